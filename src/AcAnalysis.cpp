@@ -0,0 +1,309 @@
+#include "AcAnalysis.h"
+#include "CircuitBoard.h"
+#include "DenseCholesky.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr uint32_t NoIndex = 0xFFFFFFFF;
+    constexpr double Pi = 3.14159265358979323846;
+}
+
+AcAnalysis::AcAnalysis(JobSystem& jobSystem)
+    : mJobSystem(jobSystem)
+    , mSolver(jobSystem)
+    , mScratches(jobSystem.GetThreadCount())
+{ }
+
+bool AcAnalysis::Sweep(CircuitBoard& circuitBoard, const std::vector<Probe>& probes, const AcSweepSettings& settings, const PointSink& pointSink, std::string& outError)
+{
+    return Prepare(circuitBoard, probes, settings, outError) && Run(pointSink, outError);
+}
+
+bool AcAnalysis::Prepare(CircuitBoard& circuitBoard, const std::vector<Probe>& probes, const AcSweepSettings& settings, std::string& outError)
+{
+    mStamps.clear();
+    mProbeNets.clear();
+    if (!(settings.mStartFrequency > 0.0) || !(settings.mStopFrequency >= settings.mStartFrequency) || settings.mPointCount == 0)
+    {
+        outError = "Frequencies must be positive and rising, with at least one point";
+        return false;
+    }
+
+    mSettings = settings;
+    mSlotCount = circuitBoard.GetNetwork().GetSlotCount();
+    if (!BuildStamps(circuitBoard, settings.mSourceComponentId, probes, outError))
+    {
+        mStamps.clear();
+        return false;
+    }
+    return true;
+}
+
+bool AcAnalysis::Run(const PointSink& pointSink, std::string& outError)
+{
+    if (mStamps.empty())
+    {
+        outError = "Nothing was prepared to sweep";
+        return false;
+    }
+
+    if (!FindOperatingPoint(mSlotCount, outError))
+    {
+        return false;
+    }
+
+    // Batches of one point per thread, so only a batch of results is ever held
+    const AcSweepSettings& settings = mSettings;
+    size_t laneCount = mScratches.size();
+    size_t probeCount = mProbeNets.size();
+    std::vector<Complex> batchVoltages(laneCount * probeCount);
+    std::vector<double> batchFrequencies(laneCount);
+    std::vector<uint8_t> batchSolved(laneCount);
+    double ratio = settings.mStopFrequency / settings.mStartFrequency;
+    for (size_t firstPoint = 0; firstPoint < settings.mPointCount; firstPoint += laneCount)
+    {
+        size_t batchCount = std::min<size_t>(laneCount, settings.mPointCount - firstPoint);
+        for (size_t index = 0; index < batchCount; index++)
+        {
+            double position = settings.mPointCount > 1 ? static_cast<double>(firstPoint + index) / (settings.mPointCount - 1) : 0.0;
+            batchFrequencies[index] = settings.mStartFrequency * std::pow(ratio, position);
+        }
+
+        mJobSystem.ParallelFor(batchCount, [&](size_t index)
+        {
+            batchSolved[index] = SolvePoint(batchFrequencies[index], mScratches[index], &batchVoltages[index * probeCount]);
+        });
+
+        for (size_t index = 0; index < batchCount; index++)
+        {
+            if (!batchSolved[index])
+            {
+                outError = "Singular system at " + std::to_string(batchFrequencies[index]) + " Hz";
+                return false;
+            }
+            pointSink(batchFrequencies[index], &batchVoltages[index * probeCount]);
+        }
+    }
+    return true;
+}
+
+// Numbers the nets of the source's partition the way CircuitSolver does, so ground is the same net
+bool AcAnalysis::BuildStamps(CircuitBoard& circuitBoard, uint32_t sourceComponentId, const std::vector<Probe>& probes, std::string& outError)
+{
+    if (sourceComponentId >= circuitBoard.GetComponentCount())
+    {
+        outError = "No such component";
+        return false;
+    }
+
+    ElementKind sourceKind = circuitBoard.GetComponent(sourceComponentId).GetElementKind();
+    if (sourceKind != ElementKind::VoltageSource && sourceKind != ElementKind::CurrentSource)
+    {
+        outError = "The source must be a voltage or current source";
+        return false;
+    }
+
+    // Elements come in component order, skipping the components that are none
+    mSourceElement = 0;
+    for (uint32_t componentId = 0; componentId < sourceComponentId; componentId++)
+    {
+        if (circuitBoard.GetComponent(componentId).GetElementKind() != ElementKind::None)
+        {
+            mSourceElement++;
+        }
+    }
+
+    CircuitSolver::CollectElements(circuitBoard, mElements);
+    mLamps.clear();
+    mColdResistances.clear();
+    for (uint32_t element = 0; element < mElements.size(); element++)
+    {
+        if (mElements[element].mKind == ElementKind::Lamp)
+        {
+            mLamps.push_back(element);
+            mColdResistances.push_back(mElements[element].mValue);
+        }
+    }
+
+    CircuitNetwork& network = circuitBoard.GetNetwork();
+    TrackedVector<uint32_t, MemoryTag::Solver> rootNets(network.GetSlotCount(), NoIndex);
+    uint32_t partition = mElements[mSourceElement].mPartition;
+    mStamps.clear();
+    mNetCount = 0;
+    for (uint32_t element = 0, lamp = 0; element < mElements.size(); element++)
+    {
+        const CircuitElement& circuitElement = mElements[element];
+        bool isLamp = circuitElement.mKind == ElementKind::Lamp;
+        if (circuitElement.mPartition != partition)
+        {
+            lamp += isLamp ? 1 : 0;
+            continue;
+        }
+
+        Stamp stamp{ {}, element, isLamp ? lamp++ : NoIndex };
+        for (uint32_t terminal = 0; terminal < 2; terminal++)
+        {
+            uint32_t root = circuitElement.mNets[terminal];
+            if (rootNets[root] == NoIndex)
+            {
+                rootNets[root] = static_cast<uint32_t>(mNetCount++);
+            }
+            stamp.mNets[terminal] = rootNets[root];
+        }
+        mStamps.push_back(stamp);
+    }
+
+    if (mNetCount - 1 > MaxNets)
+    {
+        outError = "The partition of the source has " + std::to_string(mNetCount) + " nets, at most " + std::to_string(MaxNets + 1) + " are supported";
+        return false;
+    }
+
+    mProbeNets.clear();
+    for (const Probe& probe : probes)
+    {
+        bool isValid = probe.mComponentId < network.GetComponentCount() && probe.mComponentPinId < circuitBoard.GetComponent(probe.mComponentId).GetComponentPins().size();
+        mProbeNets.push_back(isValid ? rootNets[network.FindNet(network.GetSlot(probe.mComponentId, probe.mComponentPinId))] : NoIndex);
+    }
+    return true;
+}
+
+// Filaments settle where the power they dissipate matches their heat loss. Each round solves the board with
+// the current resistances and moves every filament halfway to the temperature that power would hold it at,
+// the halving keeps a filament that cools as it heats from overshooting.
+bool AcAnalysis::FindOperatingPoint(size_t slotCount, std::string& outError)
+{
+    TrackedVector<double, MemoryTag::Solver> temperatures(mLamps.size(), 0.0);
+    mLampVoltages.assign(mLamps.size(), 0.0);
+    for (size_t iteration = 0; iteration < MaxOperatingPointIterations; iteration++)
+    {
+        for (size_t lamp = 0; lamp < mLamps.size(); lamp++)
+        {
+            mElements[mLamps[lamp]].mValue = mColdResistances[lamp] * (1.0 + Simulation::FilamentTemperatureCoefficient * temperatures[lamp]);
+        }
+        mSolver.Solve(mElements, slotCount, iteration == 0);
+
+        bool isSettled = true;
+        for (size_t lamp = 0; lamp < mLamps.size(); lamp++)
+        {
+            const CircuitElement& element = mElements[mLamps[lamp]];
+            std::optional<double> elementVoltage = mSolver.GetElementVoltage(element);
+            if (!elementVoltage.has_value())
+            {
+                // Lamps of other partitions do not matter, they stay cold
+                if (element.mPartition == mElements[mSourceElement].mPartition)
+                {
+                    outError = "The operating point could not be solved";
+                    return false;
+                }
+                continue;
+            }
+
+            double resistance = std::max(element.mValue, CircuitSolver::MinResistance);
+            double voltage = elementVoltage.value();
+            double settledTemperature = voltage * voltage / resistance / Simulation::FilamentHeatLoss;
+            double resistanceChange = mColdResistances[lamp] * Simulation::FilamentTemperatureCoefficient * (settledTemperature - temperatures[lamp]);
+            isSettled = isSettled && std::abs(resistanceChange) <= OperatingPointTolerance * resistance;
+            temperatures[lamp] = 0.5 * (temperatures[lamp] + settledTemperature);
+            mLampVoltages[lamp] = voltage;
+        }
+
+        if (isSettled)
+        {
+            return true;
+        }
+    }
+
+    outError = "The filaments did not settle at an operating point";
+    return false;
+}
+
+// A lamp is its hot resistance R plus the filament heating up with the current. With V the operating voltage,
+// R0 the cold resistance, a the temperature coefficient, C the heat capacity and k the heat loss, the
+// admittance is 1/R - 2 a R0 V^2 / R^3 / (jwC + k + a R0 V^2 / R^2), falling to 1/R once w outruns k/C.
+AcAnalysis::Complex AcAnalysis::GetAdmittance(const Stamp& stamp, double frequency) const
+{
+    const CircuitElement& element = mElements[stamp.mElement];
+    switch (element.mKind)
+    {
+        case ElementKind::Resistor:
+            return 1.0 / std::max(element.mValue, CircuitSolver::MinResistance);
+        case ElementKind::VoltageSource:
+            return 1.0 / CircuitSolver::VoltageSourceResistance;
+        case ElementKind::Lamp:
+        {
+            double resistance = std::max(element.mValue, CircuitSolver::MinResistance);
+            double voltage = mLampVoltages[stamp.mLamp];
+            double heating = Simulation::FilamentTemperatureCoefficient * mColdResistances[stamp.mLamp] * voltage * voltage / (resistance * resistance);
+            Complex thermal(Simulation::FilamentHeatLoss + heating, 2.0 * Pi * frequency * Simulation::FilamentHeatCapacity);
+            return 1.0 / resistance - 2.0 * heating / resistance / thermal;
+        }
+        default:
+            return 0.0;
+    }
+}
+
+bool AcAnalysis::SolvePoint(double frequency, Scratch& scratch, Complex* outProbeVoltages) const
+{
+    // Ground is not an unknown, row and column k stand for net k + 1
+    size_t size = mNetCount - 1;
+    std::vector<Complex>& matrix = scratch.mMatrix;
+    std::vector<Complex>& rightHandSide = scratch.mRightHandSide;
+    matrix.assign(size * size, 0.0);
+    rightHandSide.assign(size, 0.0);
+    for (size_t row = 0; row < size; row++)
+    {
+        matrix[row * size + row] = CircuitSolver::GroundConductance;
+    }
+
+    for (const Stamp& stamp : mStamps)
+    {
+        Complex admittance = GetAdmittance(stamp, frequency);
+        uint32_t net = stamp.mNets[0];
+        uint32_t otherNet = stamp.mNets[1];
+        if (net > 0)
+        {
+            matrix[(net - 1) * size + (net - 1)] += admittance;
+        }
+        if (otherNet > 0)
+        {
+            matrix[(otherNet - 1) * size + (otherNet - 1)] += admittance;
+        }
+        if (net > 0 && otherNet > 0)
+        {
+            matrix[(net - 1) * size + (otherNet - 1)] -= admittance;
+            matrix[(otherNet - 1) * size + (net - 1)] -= admittance;
+        }
+
+        if (stamp.mElement == mSourceElement)
+        {
+            // The Norton current of 1 V, or 1 A, flowing into the first terminal
+            bool isVoltageSource = mElements[stamp.mElement].mKind == ElementKind::VoltageSource;
+            double current = isVoltageSource ? 1.0 / CircuitSolver::VoltageSourceResistance : -1.0;
+            if (net > 0)
+            {
+                rightHandSide[net - 1] += current;
+            }
+            if (otherNet > 0)
+            {
+                rightHandSide[otherNet - 1] -= current;
+            }
+        }
+    }
+
+    if (!SolveDenseCholesky(size, matrix, rightHandSide))
+    {
+        return false;
+    }
+
+    for (size_t probe = 0; probe < mProbeNets.size(); probe++)
+    {
+        uint32_t net = mProbeNets[probe];
+        outProbeVoltages[probe] = net == NoIndex || net == 0 ? Complex(0.0) : rightHandSide[net - 1];
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "CircuitSolver.h"
+#include "MemoryTracker.h"
+#include "Simulation.h"
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+class CircuitBoard;
+class JobSystem;
+
+struct AcSweepSettings
+{
+    uint32_t mSourceComponentId{ 0 };  // A voltage source driven at 1 V or a current source at 1 A
+    double mStartFrequency{ 1e-3 };    // Hertz
+    double mStopFrequency{ 1e3 };
+    uint32_t mPointCount{ 121 };       // Spaced evenly on a log scale
+};
+
+// Small-signal frequency response of the board to one source. The circuit is linearized at its DC operating
+// point, where every filament has reached the temperature at which it loses the heat it dissipates. The
+// other voltage sources become their source resistance and the other current sources open circuits.
+// Resistors and voltage sources do not depend on frequency, a lamp does, its filament temperature follows
+// slow changes of its current and lags behind fast ones.
+// Only the partition of the source responds. Its complex system is numbered and stamped once, every point
+// then only fills in the admittances and factors, points are solved in parallel one per thread, and handed
+// out in frequency order as soon as their batch is done.
+class AcAnalysis
+{
+public:
+    // Phasors of the probe voltages, in volts per volt or ampere of the source
+    using PointSink = std::function<void(double frequency, const std::complex<double>* probeVoltages)>;
+
+    explicit AcAnalysis(JobSystem& jobSystem);
+
+    bool Sweep(CircuitBoard& circuitBoard, const std::vector<Probe>& probes, const AcSweepSettings& settings, const PointSink& pointSink, std::string& outError);
+
+    // Sweep in two halves. Prepare reads the board and Run does not, so Run can go on another thread
+    // while the board keeps changing.
+    bool Prepare(CircuitBoard& circuitBoard, const std::vector<Probe>& probes, const AcSweepSettings& settings, std::string& outError);
+    bool Run(const PointSink& pointSink, std::string& outError);
+
+    static constexpr size_t MaxNets = 1024;  // 16 MB of complex matrix per thread
+    static constexpr size_t MaxOperatingPointIterations = 500;
+    static constexpr double OperatingPointTolerance = 1e-9;  // Of filament resistances, relative
+
+private:
+    using Complex = std::complex<double>;
+
+    // Where an element goes in the system, nets are within the partition with ground at zero
+    struct Stamp
+    {
+        uint32_t mNets[2];
+        uint32_t mElement;  // Index into mElements
+        uint32_t mLamp;     // Index into mLamps, NoIndex for other elements
+    };
+
+    struct Scratch
+    {
+        std::vector<Complex> mMatrix;
+        std::vector<Complex> mRightHandSide;
+    };
+
+    bool BuildStamps(CircuitBoard& circuitBoard, uint32_t sourceComponentId, const std::vector<Probe>& probes, std::string& outError);
+    bool FindOperatingPoint(size_t slotCount, std::string& outError);
+    Complex GetAdmittance(const Stamp& stamp, double frequency) const;
+    bool SolvePoint(double frequency, Scratch& scratch, Complex* outProbeVoltages) const;
+
+    JobSystem& mJobSystem;
+    CircuitSolver mSolver;
+    std::vector<Scratch> mScratches;  // Per thread
+
+    AcSweepSettings mSettings;
+    size_t mSlotCount{ 0 };
+    CircuitElements mElements;  // Lamps at their operating resistance
+    TrackedVector<uint32_t, MemoryTag::Solver> mLamps;
+    TrackedVector<double, MemoryTag::Solver> mColdResistances;  // Per lamp
+    TrackedVector<double, MemoryTag::Solver> mLampVoltages;     // Per lamp, at the operating point
+
+    TrackedVector<Stamp, MemoryTag::Solver> mStamps;
+    uint32_t mSourceElement{ 0 };
+    size_t mNetCount{ 0 };
+    TrackedVector<uint32_t, MemoryTag::Solver> mProbeNets;  // Within the partition, NoIndex for probes outside it
+};
\ No newline at end of file
@@ -0,0 +1,306 @@
+#include "AutoRouter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <numeric>
+
+class AutoRouter::SearchScratch
+{
+public:
+    struct OpenEntry
+    {
+        uint32_t mEstimate;
+        uint32_t mCost;
+        uint32_t mCell;
+    };
+
+    // Cells are only valid when stamped with the current search, so nothing is cleared between searches
+    void Prepare(size_t totalCells)
+    {
+        if (mStamps.size() < totalCells)
+        {
+            mStamps.resize(totalCells, 0);
+            mCosts.resize(totalCells);
+            mParents.resize(totalCells);
+        }
+
+        mStamp++;
+        if (mStamp == 0)
+        {
+            std::fill(mStamps.begin(), mStamps.end(), 0);
+            mStamp = 1;
+        }
+        mOpen.clear();
+    }
+
+    bool IsVisited(uint32_t cell) const { return mStamps[cell] == mStamp; }
+
+    void Visit(uint32_t cell, uint32_t cost, uint32_t parent, uint32_t estimate)
+    {
+        mStamps[cell] = mStamp;
+        mCosts[cell] = cost;
+        mParents[cell] = parent;
+
+        mOpen.push_back({ estimate, cost, cell });
+        std::push_heap(mOpen.begin(), mOpen.end(), &SearchScratch::IsLowerPriority);
+    }
+
+    OpenEntry Pop()
+    {
+        std::pop_heap(mOpen.begin(), mOpen.end(), &SearchScratch::IsLowerPriority);
+        OpenEntry entry = mOpen.back();
+        mOpen.pop_back();
+        return entry;
+    }
+
+    bool HasOpen() const { return !mOpen.empty(); }
+    uint32_t GetCost(uint32_t cell) const { return mCosts[cell]; }
+    uint32_t GetParent(uint32_t cell) const { return mParents[cell]; }
+
+private:
+    // Ties on the estimate go to the entry closest to the target
+    static bool IsLowerPriority(const OpenEntry& lhs, const OpenEntry& rhs)
+    {
+        if (lhs.mEstimate != rhs.mEstimate)
+        {
+            return lhs.mEstimate > rhs.mEstimate;
+        }
+        return lhs.mCost < rhs.mCost;
+    }
+
+    std::vector<OpenEntry> mOpen;
+    std::vector<uint32_t> mStamps;
+    std::vector<uint32_t> mCosts;
+    std::vector<uint32_t> mParents;
+    uint32_t mStamp{ 0 };
+};
+
+AutoRouter::AutoRouter(sf::Vector2u grid, const OccupancyBitmap& occupancy)
+    : mGrid(grid)
+    , mPinLayout(grid)
+    , mOccupancy(occupancy)
+{
+    size_t totalWords = (static_cast<size_t>(mGrid.x) * mGrid.y + 63) / 64;
+    mWireWords.assign(totalWords, 0);
+    mReservedWords.assign(totalWords, 0);
+}
+
+RouteResult AutoRouter::Route(const RouteRequest& request)
+{
+    return RouteAll({ request }).front();
+}
+
+std::vector<RouteResult> AutoRouter::RouteAll(const std::vector<RouteRequest>& requests, JobSystem& jobSystem)
+{
+    std::vector<RouteResult> results(requests.size());
+    Reserve(requests);
+
+    std::vector<SearchScratch> scratches(jobSystem.GetThreadCount());
+
+    std::vector<size_t> pending(requests.size());
+    std::iota(pending.begin(), pending.end(), 0);
+
+    while (!pending.empty())
+    {
+        // Search every pending net against the wires committed by previous passes
+        std::vector<std::vector<uint32_t>> paths(pending.size());
+        std::vector<char> isFound(pending.size(), false);
+        std::atomic<size_t> nextPending{ 0 };
+
+        // One lane per scratch, a single net searches on the calling thread
+        jobSystem.ParallelFor(std::min(scratches.size(), pending.size()), [&](size_t lane)
+        {
+            for (size_t index = nextPending++; index < pending.size(); index = nextPending++)
+            {
+                isFound[index] = FindPath(requests[pending[index]], scratches[lane], paths[index]);
+            }
+        });
+
+        // Commit in request order. The first found path of a pass never conflicts, so every pass makes progress.
+        std::vector<size_t> conflicting;
+        for (size_t index = 0; index < pending.size(); index++)
+        {
+            if (!isFound[index])
+            {
+                continue;  // Obstacles only grow, retrying cannot help
+            }
+
+            if (ConflictsWithWires(paths[index]))
+            {
+                conflicting.push_back(pending[index]);
+                continue;
+            }
+
+            ClaimWire(paths[index]);
+            RouteResult& result = results[pending[index]];
+            result.mIsRouted = true;
+            result.mPinIds = std::move(paths[index]);
+        }
+        pending.swap(conflicting);
+    }
+
+    return results;
+}
+
+bool AutoRouter::FindPath(const RouteRequest& request, SearchScratch& scratch, std::vector<uint32_t>& outPinIds) const
+{
+    sf::Vector2u source(request.mSourcePinId % mGrid.x, request.mSourcePinId / mGrid.x);
+    sf::Vector2u target(request.mTargetPinId % mGrid.x, request.mTargetPinId / mGrid.x);
+
+    sf::Vector2u boundsMin(std::min(source.x, target.x), std::min(source.y, target.y));
+    sf::Vector2u boundsMax(std::max(source.x, target.x), std::max(source.y, target.y));
+
+    // Search a window around the endpoints first and grow it. Detours far longer than the net itself
+    // are not worth a wire, so the window stops growing before it degenerates into a board-wide flood.
+    uint32_t span = boundsMax.x - boundsMin.x + boundsMax.y - boundsMin.y;
+    uint32_t margin = std::max(8u, span / 2);
+    uint32_t maxMargin = std::max(64u, span * 4);
+    while (true)
+    {
+        sf::Vector2u windowMin(boundsMin.x - std::min(boundsMin.x, margin), boundsMin.y - std::min(boundsMin.y, margin));
+        sf::Vector2u windowMax(std::min(boundsMax.x + margin, mGrid.x - 1), std::min(boundsMax.y + margin, mGrid.y - 1));
+
+        bool isClipped = false;
+        if (SearchWindow(request, windowMin, windowMax, scratch, outPinIds, isClipped))
+        {
+            return true;
+        }
+
+        // A search that never reached the window edge exhausted everything reachable from the source
+        bool isWholeBoard = windowMin.x == 0 && windowMin.y == 0 && windowMax.x == mGrid.x - 1 && windowMax.y == mGrid.y - 1;
+        if (!isClipped || isWholeBoard || margin >= maxMargin)
+        {
+            return false;
+        }
+
+        // Same for the target, otherwise a walled in target floods the whole board from the source
+        RouteRequest reversedRequest{ request.mTargetPinId, request.mSourcePinId };
+        isClipped = false;
+        SearchWindow(reversedRequest, windowMin, windowMax, scratch, outPinIds, isClipped);
+        if (!isClipped)
+        {
+            return false;
+        }
+        margin = std::min(margin * 2, maxMargin);
+    }
+}
+
+bool AutoRouter::SearchWindow(const RouteRequest& request, const sf::Vector2u& windowMin, const sf::Vector2u& windowMax,
+    SearchScratch& scratch, std::vector<uint32_t>& outPinIds, bool& outIsClipped) const
+{
+    uint32_t windowWidth = windowMax.x - windowMin.x + 1;
+    uint32_t windowHeight = windowMax.y - windowMin.y + 1;
+    scratch.Prepare(static_cast<size_t>(windowWidth) * windowHeight);
+
+    auto toCell = [&](uint32_t pinId)
+    {
+        return (pinId % mGrid.x - windowMin.x) + (pinId / mGrid.x - windowMin.y) * windowWidth;
+    };
+    auto toPinId = [&](uint32_t cell)
+    {
+        return (cell % windowWidth + windowMin.x) + (cell / windowWidth + windowMin.y) * mGrid.x;
+    };
+
+    int32_t targetX = request.mTargetPinId % mGrid.x;
+    int32_t targetY = request.mTargetPinId / mGrid.x;
+    auto distanceToTarget = [&](int32_t x, int32_t y)
+    {
+        return static_cast<uint32_t>(std::abs(targetX - x) + std::abs(targetY - y));
+    };
+
+    uint32_t sourceCell = toCell(request.mSourcePinId);
+    uint32_t targetCell = toCell(request.mTargetPinId);
+    scratch.Visit(sourceCell, 0, sourceCell, distanceToTarget(request.mSourcePinId % mGrid.x, request.mSourcePinId / mGrid.x));
+
+    const sf::Vector2i directions[] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+    while (scratch.HasOpen())
+    {
+        SearchScratch::OpenEntry entry = scratch.Pop();
+        if (entry.mCost != scratch.GetCost(entry.mCell))
+        {
+            continue;  // Superseded by a cheaper visit
+        }
+
+        if (entry.mCell == targetCell)
+        {
+            outPinIds.clear();
+            for (uint32_t cell = targetCell; cell != sourceCell; cell = scratch.GetParent(cell))
+            {
+                outPinIds.push_back(toPinId(cell));
+            }
+            outPinIds.push_back(request.mSourcePinId);
+            std::reverse(outPinIds.begin(), outPinIds.end());
+            return true;
+        }
+
+        int32_t x = entry.mCell % windowWidth;
+        int32_t y = entry.mCell / windowWidth;
+        for (const sf::Vector2i& direction : directions)
+        {
+            int32_t neighborX = x + direction.x;
+            int32_t neighborY = y + direction.y;
+            if (neighborX < 0 || neighborX >= static_cast<int32_t>(windowWidth) || neighborY < 0 || neighborY >= static_cast<int32_t>(windowHeight))
+            {
+                outIsClipped = true;
+                continue;
+            }
+
+            uint32_t neighborCell = neighborX + neighborY * windowWidth;
+            uint32_t neighborPinId = toPinId(neighborCell);
+            if (!IsPassable(neighborPinId, request))
+            {
+                continue;
+            }
+
+            uint32_t cost = entry.mCost + 1;
+            if (!scratch.IsVisited(neighborCell) || cost < scratch.GetCost(neighborCell))
+            {
+                uint32_t estimate = cost + distanceToTarget(neighborX + windowMin.x, neighborY + windowMin.y);
+                scratch.Visit(neighborCell, cost, entry.mCell, estimate);
+            }
+        }
+    }
+
+    return false;
+}
+
+bool AutoRouter::IsPassable(uint32_t pinId, const RouteRequest& request) const
+{
+    if (pinId == request.mSourcePinId || pinId == request.mTargetPinId)
+    {
+        return true;
+    }
+    return !mOccupancy.IsOccupied(mPinLayout.GetSlot(pinId)) && !TestBit(mWireWords, pinId) && !TestBit(mReservedWords, pinId);
+}
+
+bool AutoRouter::ConflictsWithWires(const std::vector<uint32_t>& pinIds) const
+{
+    // Endpoints may be shared between nets, only the interior of a wire is exclusive
+    for (size_t index = 1; index + 1 < pinIds.size(); index++)
+    {
+        if (TestBit(mWireWords, pinIds[index]))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void AutoRouter::ClaimWire(const std::vector<uint32_t>& pinIds)
+{
+    for (uint32_t pinId : pinIds)
+    {
+        SetBit(mWireWords, pinId);
+    }
+}
+
+void AutoRouter::Reserve(const std::vector<RouteRequest>& requests)
+{
+    std::fill(mReservedWords.begin(), mReservedWords.end(), 0);
+    for (const RouteRequest& request : requests)
+    {
+        SetBit(mReservedWords, request.mSourcePinId);
+        SetBit(mReservedWords, request.mTargetPinId);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "JobSystem.h"
+#include "OccupancyBitmap.h"
+#include "PinLayout.h"
+
+#include <SFML/Graphics.hpp>
+
+#include <cstdint>
+#include <vector>
+
+struct RouteRequest
+{
+    uint32_t mSourcePinId;
+    uint32_t mTargetPinId;
+};
+
+struct RouteResult
+{
+    bool mIsRouted{ false };
+    std::vector<uint32_t> mPinIds;  // Source to target, both included
+};
+
+// Routes wires between circuit board pins around claimed pins. Pin ids are row-major grid indices.
+class AutoRouter
+{
+public:
+    AutoRouter(sf::Vector2u grid, const OccupancyBitmap& occupancy);
+
+    RouteResult Route(const RouteRequest& request);
+
+    // Nets are searched concurrently against the wires committed so far. Results are committed in
+    // request order and a net whose path crosses a wire committed earlier in the same pass is
+    // searched again in the next pass.
+    std::vector<RouteResult> RouteAll(const std::vector<RouteRequest>& requests, JobSystem& jobSystem = JobSystem::GetShared());
+
+private:
+    class SearchScratch;
+
+    bool FindPath(const RouteRequest& request, SearchScratch& scratch, std::vector<uint32_t>& outPinIds) const;
+    bool SearchWindow(const RouteRequest& request, const sf::Vector2u& windowMin, const sf::Vector2u& windowMax,
+        SearchScratch& scratch, std::vector<uint32_t>& outPinIds, bool& outIsClipped) const;
+
+    bool IsPassable(uint32_t pinId, const RouteRequest& request) const;
+    bool ConflictsWithWires(const std::vector<uint32_t>& pinIds) const;
+    void ClaimWire(const std::vector<uint32_t>& pinIds);
+    void Reserve(const std::vector<RouteRequest>& requests);
+
+    static bool TestBit(const std::vector<uint64_t>& words, uint32_t pinId)
+    {
+        return (words[pinId / 64] >> (pinId % 64)) & 1;
+    }
+
+    static void SetBit(std::vector<uint64_t>& words, uint32_t pinId)
+    {
+        words[pinId / 64] |= uint64_t(1) << (pinId % 64);
+    }
+
+    sf::Vector2u mGrid;
+    PinLayout mPinLayout;  // Of the occupancy
+    const OccupancyBitmap& mOccupancy;
+    std::vector<uint64_t> mWireWords;      // Pins claimed by wires routed by this router
+    std::vector<uint64_t> mReservedWords;  // Endpoints of the batch being routed
+};
\ No newline at end of file
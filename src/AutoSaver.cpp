@@ -0,0 +1,81 @@
+#include "AutoSaver.h"
+#include "BoardFile.h"
+
+#include <iostream>
+
+AutoSaver::AutoSaver(std::string filePath, float intervalSeconds)
+    : mFilePath(std::move(filePath))
+    , mIntervalSeconds(intervalSeconds)
+    , mSavedRevision(0)
+    , mIsSaving(false)
+    , mIsStopping(false)
+    , mThread(&AutoSaver::Run, this)
+{ }
+
+AutoSaver::~AutoSaver()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mIsStopping = true;
+    }
+    mCondition.notify_one();
+    mThread.join();
+}
+
+bool AutoSaver::Update(const CircuitBoard& circuitBoard)
+{
+    if (mIsSaving || mClock.getElapsedTime().asSeconds() < mIntervalSeconds)
+    {
+        return false;
+    }
+    mClock.restart();
+
+    if (circuitBoard.GetRevision() == mSavedRevision)
+    {
+        return false;
+    }
+    Save(circuitBoard, mFilePath);
+    return true;
+}
+
+void AutoSaver::Save(const CircuitBoard& circuitBoard, const std::string& filePath)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mPendingSave = PendingSave{ circuitBoard.TakeSnapshot(), filePath };
+        mIsSaving = true;
+    }
+    mCondition.notify_one();
+}
+
+void AutoSaver::Run()
+{
+    while (true)
+    {
+        PendingSave pendingSave;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this] { return mIsStopping || mPendingSave.has_value(); });
+
+            // A snapshot handed over right before shutdown is still saved
+            if (!mPendingSave.has_value())
+            {
+                return;
+            }
+            pendingSave = std::move(*mPendingSave);
+            mPendingSave.reset();
+        }
+
+        if (!WriteBoardFile(pendingSave.mSnapshot, pendingSave.mFilePath))
+        {
+            std::cerr << "Saving to " << pendingSave.mFilePath << " failed" << std::endl;
+        }
+        else if (pendingSave.mFilePath == mFilePath)
+        {
+            mSavedRevision = pendingSave.mSnapshot.mRevision;
+        }
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        mIsSaving = mPendingSave.has_value();
+    }
+}
\ No newline at end of file
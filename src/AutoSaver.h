@@ -0,0 +1,52 @@
+#pragma once
+
+#include "BoardRecords.h"
+#include "CircuitBoard.h"
+
+#include <SFML/Graphics.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+// Saves the circuit board without stalling the frame, periodically or on request. The main thread only
+// takes an O(1) snapshot, serializing and flushing it to disk happens on a worker thread.
+class AutoSaver
+{
+public:
+    AutoSaver(std::string filePath, float intervalSeconds);
+    ~AutoSaver();
+
+    // Call once per frame from the thread that modifies the circuit board, true when it took a snapshot
+    bool Update(const CircuitBoard& circuitBoard);
+
+    // Replaces a save that has not started yet
+    void Save(const CircuitBoard& circuitBoard, const std::string& filePath);
+
+    bool IsSaving() const { return mIsSaving; }
+
+private:
+    struct PendingSave
+    {
+        BoardRecords mSnapshot;
+        std::string mFilePath;
+    };
+
+    void Run();
+
+    std::string mFilePath;
+    float mIntervalSeconds;
+    sf::Clock mClock;
+    std::atomic<uint64_t> mSavedRevision;
+    std::atomic<bool> mIsSaving;
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::optional<PendingSave> mPendingSave;
+    bool mIsStopping;
+
+    std::thread mThread;
+};
\ No newline at end of file
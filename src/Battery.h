@@ -1,46 +1,50 @@
 #pragma once
 
-#include "Component.h"
+#include "TwoTerminalComponent.h"
 
-/*
-class Battery : public Component
+// Ideal voltage source, the first terminal is positive
+class Battery : public TwoTerminalComponent
 {
 public:
-    Battery()
-        : Component(2)
+    Battery() = default;
+    Battery(ICircuitBoardNavigator* navigator)
+        : TwoTerminalComponent(navigator, DefaultVoltage)
     { }
 
-    virtual Component* CreateShape(ICircuitBoardNavigator& navigator, const sf::Vector2f& cursor, float gridSpacing) const
+    virtual Component* Create(ICircuitBoardNavigator* navigator) const override
     {
-        Component* component = new Battery();
-        component->GetNextNode(cursor);
-        component->GetNextNode(cursor);
-
-        return component;
+        return new Battery(navigator);
     }
 
-    virtual void Move(const sf::Vector2f& cursor) override
+    virtual const char* GetTypeName() const override
     {
-        Node* node = GetSelectedNode();
-        if (node != nullptr)
-        {
-            node->SetPosition(cursor);
-        }
+        return "Battery";
     }
 
-    virtual void DrawComponent(sf::RenderTarget& target)
+    virtual ElementKind GetElementKind() const override
     {
-        const sf::Vector2f& position1 = GetNode(0).GetPosition();
-        const sf::Vector2f& position2 = GetNode(1).GetPosition();
-        sf::Vector2f size = position2 - position1;
+        return ElementKind::VoltageSource;
+    }
 
-        sf::RectangleShape rectangle(size);
-        rectangle.setPosition(position1);
-        rectangle.setFillColor({ 0, 0, 0, 0 });
-        rectangle.setOutlineColor(mColor);
-        rectangle.setOutlineThickness(-1.f);
+    virtual void DrawComponent(Canvas& canvas) const override
+    {
+        sf::FloatRect body = DrawLeads(canvas);
 
-        target.draw(rectangle);
+        // Long positive plate, short negative plate
+        float plateX1 = body.left + body.width / 3.0f;
+        float plateX2 = body.left + 2.0f * body.width / 3.0f;
+        float centerY = body.top + body.height / 2.0f;
+        sf::Vertex lines[] = {
+            { { body.left, centerY }, mColor },
+            { { plateX1, centerY }, mColor },
+            { { plateX1, body.top }, mColor },
+            { { plateX1, body.top + body.height }, mColor },
+            { { plateX2, body.top + body.height / 4.0f }, mColor },
+            { { plateX2, body.top + 3.0f * body.height / 4.0f }, mColor },
+            { { plateX2, centerY }, mColor },
+            { { body.left + body.width, centerY }, mColor }
+        };
+        canvas.DrawLines(lines, 8);
     }
 
     virtual void DrawIcon(sf::RenderTarget& target, const sf::Transform& transform, const sf::FloatRect& localBounds) override
@@ -55,5 +59,7 @@ public:
 
         target.draw(rectangle, states);
     }
-};
-*/
\ No newline at end of file
+
+private:
+    static constexpr double DefaultVoltage = 9.0;
+};
\ No newline at end of file
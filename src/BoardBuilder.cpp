@@ -0,0 +1,76 @@
+#include "BoardBuilder.h"
+#include "CircuitBoard.h"
+
+BoardBuilder::BoardBuilder(CircuitBoard& circuitBoard)
+    : mCircuitBoard(circuitBoard)
+{ }
+
+BoardBuilder::~BoardBuilder()
+{
+    Commit();
+}
+
+// The value goes in before the board records the component
+Component* BoardBuilder::Place(const Component& prototype, uint32_t anchorPinId, std::optional<double> value)
+{
+    Component* component = prototype.CreateShapeAt(&mCircuitBoard, anchorPinId);
+    if (component != nullptr && value.has_value())
+    {
+        component->SetValue(value.value());
+    }
+    return TryPlace(component);
+}
+
+Component* BoardBuilder::Place(const Component& prototype, sf::Vector2u anchorPin, std::optional<double> value)
+{
+    const sf::Vector2i& grid = mCircuitBoard.GetGrid();
+    if (anchorPin.x >= static_cast<uint32_t>(grid.x) || anchorPin.y >= static_cast<uint32_t>(grid.y))
+    {
+        return TryPlace(nullptr);
+    }
+    return Place(prototype, anchorPin.x + anchorPin.y * static_cast<uint32_t>(grid.x), value);
+}
+
+bool BoardBuilder::Connect(const Component& source, uint32_t sourcePinId, const Component& target, uint32_t targetPinId)
+{
+    if (sourcePinId >= source.GetComponentPins().size() || targetPinId >= target.GetComponentPins().size())
+    {
+        return false;
+    }
+
+    Connector* sourceConnector = source.GetConnector(sourcePinId);
+    Connector* targetConnector = target.GetConnector(targetPinId);
+    if (sourceConnector == nullptr || targetConnector == nullptr)
+    {
+        return false;
+    }
+
+    mBatch.AddConnectorPair(sourceConnector, targetConnector);
+    return true;
+}
+
+void BoardBuilder::Commit()
+{
+    if (mBatch.GetConnectorPairCount() == 0)
+    {
+        return;
+    }
+
+    mStats.mConnectionCount += mBatch.GetConnectorPairCount();
+    mCircuitBoard.AddConnections(mBatch);
+    mBatch.Reset();
+}
+
+Component* BoardBuilder::TryPlace(Component* component)
+{
+    if (component == nullptr || !mCircuitBoard.TryCollectConnections(component, mBatch))
+    {
+        delete component;
+        mStats.mRejectedCount++;
+        return nullptr;
+    }
+
+    mCircuitBoard.AddComponent(component);
+    mStats.mPlacedCount++;
+    return component;
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Component.h"
+
+#include <SFML/Graphics.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+class CircuitBoard;
+
+struct BoardBuilderStats
+{
+    size_t mPlacedCount{ 0 };
+    size_t mRejectedCount{ 0 };    // Off the board, on claimed pins or on tiles still loading
+    size_t mConnectionCount{ 0 };  // Made by the commits so far
+};
+
+// Builds a board from code, for importers, generators, tests and benchmarks. Components go around explicit
+// board pins instead of the cursor. Their connections, found from the pins they share with the components
+// already placed or given explicitly, are collected into a batch and made in one go when the batch is
+// committed.
+class BoardBuilder
+{
+public:
+    explicit BoardBuilder(CircuitBoard& circuitBoard);
+    BoardBuilder(const BoardBuilder&) = delete;
+    BoardBuilder& operator=(const BoardBuilder&) = delete;
+
+    // Commits what is left
+    ~BoardBuilder();
+
+    // A new component of the prototype's type anchored at the board pin, where the editor puts the body of
+    // a component under the cursor, with its default value unless one is given. Null when it does not fit.
+    Component* Place(const Component& prototype, uint32_t anchorPinId, std::optional<double> value = std::nullopt);
+    Component* Place(const Component& prototype, sf::Vector2u anchorPin, std::optional<double> value = std::nullopt);
+
+    // Between connectable pins of placed components, false when either pin cannot be connected
+    bool Connect(const Component& source, uint32_t sourcePinId, const Component& target, uint32_t targetPinId);
+
+    void Commit();
+
+    size_t GetPendingConnectionCount() const { return mBatch.GetConnectorPairCount(); }
+    const BoardBuilderStats& GetStats() const { return mStats; }
+
+private:
+    Component* TryPlace(Component* component);  // Takes ownership
+
+    CircuitBoard& mCircuitBoard;
+    ConnectionConnector mBatch;
+    BoardBuilderStats mStats;
+};
\ No newline at end of file
@@ -0,0 +1,307 @@
+#include "BoardFile.h"
+#include "PinLayout.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    class BoardFileWriter
+    {
+    public:
+        explicit BoardFileWriter(std::FILE* file)
+            : mFile(file)
+            , mOffset(0)
+            , mIsGood(true)
+        { }
+
+        void Write(const void* data, size_t bytes)
+        {
+            if (mIsGood && bytes > 0)
+            {
+                mIsGood = std::fwrite(data, 1, bytes, mFile) == bytes;
+            }
+            mOffset += bytes;
+        }
+
+        // Sections start 8 byte aligned so a mapped file can be read in place
+        void Align()
+        {
+            static const char padding[8] = {};
+            Write(padding, (8 - mOffset % 8) % 8);
+        }
+
+        template<typename Array>
+        BoardFileSectionEntry WriteSection(const Array& array)
+        {
+            Align();
+            BoardFileSectionEntry entry{ mOffset, array.Size() };
+            array.ForEachChunk([&](const auto* data, size_t count)
+            {
+                Write(data, count * sizeof(*data));
+            });
+            return entry;
+        }
+
+        template<typename T>
+        BoardFileSectionEntry WriteSection(const std::vector<T>& array)
+        {
+            Align();
+            BoardFileSectionEntry entry{ mOffset, array.size() };
+            Write(array.data(), array.size() * sizeof(T));
+            return entry;
+        }
+
+        bool IsGood() const { return mIsGood; }
+
+    private:
+        std::FILE* mFile;
+        uint64_t mOffset;
+        bool mIsGood;
+    };
+
+    size_t GetRecordSize(BoardFileSection section)
+    {
+        switch (section)
+        {
+            case BoardFileSection::ComponentTypes: return sizeof(ComponentTypeRecord);
+            case BoardFileSection::Components: return sizeof(ComponentRecord);
+            case BoardFileSection::ComponentPins: return sizeof(ComponentPinRecord);
+            case BoardFileSection::Nodes: return sizeof(NodeRecord);
+            case BoardFileSection::Connections: return sizeof(ConnectionRecord);
+            case BoardFileSection::Wires: return sizeof(WireRecord);
+            case BoardFileSection::WirePins: return sizeof(uint32_t);
+            case BoardFileSection::Tiles: return sizeof(TileRecord);
+            case BoardFileSection::TileComponents: return sizeof(uint32_t);
+            case BoardFileSection::ComponentValues: return sizeof(double);
+            default: return 0;
+        }
+    }
+
+    // Tile of the first associated board pin, or the extra bucket when the component has no associated pins
+    // or reaches past the tiles around that one
+    uint32_t GetTileBucket(const BoardRecords& records, const ComponentRecord& component)
+    {
+        uint32_t tilesX = TileRecord::GetTileCount(records.mGrid.x);
+        uint32_t tilesY = TileRecord::GetTileCount(records.mGrid.y);
+        uint32_t extraBucket = tilesX * tilesY;
+
+        bool hasAnchor = false;
+        sf::Vector2i anchorTile;
+        for (uint32_t index = 0; index < component.mPinCount; index++)
+        {
+            uint32_t boardPinId = records.mComponentPins[component.mFirstPin + index].mBoardPinId;
+            if (boardPinId == ComponentPinRecord::UnassociatedPin)
+            {
+                continue;
+            }
+
+            sf::Vector2i tile(boardPinId % records.mGrid.x / TileRecord::TileSize, boardPinId / records.mGrid.x / TileRecord::TileSize);
+            if (!hasAnchor)
+            {
+                hasAnchor = true;
+                anchorTile = tile;
+            }
+            else if (std::abs(tile.x - anchorTile.x) > 1 || std::abs(tile.y - anchorTile.y) > 1)
+            {
+                return extraBucket;
+            }
+        }
+        return hasAnchor ? anchorTile.x + anchorTile.y * tilesX : extraBucket;
+    }
+
+    // Counting sort of the component ids into their tile buckets
+    void BuildTileIndex(const BoardRecords& records, std::vector<TileRecord>& tiles, std::vector<uint32_t>& tileComponents)
+    {
+        uint32_t tileCount = TileRecord::GetTileCount(records.mGrid.x) * TileRecord::GetTileCount(records.mGrid.y);
+        tiles.assign(tileCount + 1, TileRecord{ 0, 0 });
+
+        std::vector<uint32_t> buckets(records.mComponents.Size());
+        for (uint32_t componentId = 0; componentId < buckets.size(); componentId++)
+        {
+            buckets[componentId] = GetTileBucket(records, records.mComponents[componentId]);
+            tiles[buckets[componentId]].mComponentCount++;
+        }
+
+        uint32_t firstComponent = 0;
+        for (TileRecord& tile : tiles)
+        {
+            tile.mFirstComponent = firstComponent;
+            firstComponent += tile.mComponentCount;
+        }
+
+        tileComponents.resize(buckets.size());
+        std::vector<uint32_t> filled(tiles.size(), 0);
+        for (uint32_t componentId = 0; componentId < buckets.size(); componentId++)
+        {
+            uint32_t bucket = buckets[componentId];
+            tileComponents[tiles[bucket].mFirstComponent + filled[bucket]++] = componentId;
+        }
+    }
+
+    bool FlushToDisk(std::FILE* file)
+    {
+        if (std::fflush(file) != 0)
+        {
+            return false;
+        }
+#ifdef _WIN32
+        return _commit(_fileno(file)) == 0;
+#else
+        return fsync(fileno(file)) == 0;
+#endif
+    }
+
+    // A rename is only durable once the directory holding the entry is. Windows commits it with the file.
+    bool FlushDirectoryToDisk(const std::string& filePath)
+    {
+#ifdef _WIN32
+        (void)filePath;
+        return true;
+#else
+        std::filesystem::path directory = std::filesystem::path(filePath).parent_path();
+        int descriptor = open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_DIRECTORY);
+        if (descriptor < 0)
+        {
+            return false;
+        }
+        bool isFlushed = fsync(descriptor) == 0;
+        return close(descriptor) == 0 && isFlushed;
+#endif
+    }
+}
+
+bool WriteBoardFile(const BoardRecords& records, const std::string& filePath)
+{
+    std::string temporaryPath = filePath + ".tmp";
+    std::FILE* file = std::fopen(temporaryPath.c_str(), "wb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    BoardFileHeader header{};
+    header.mMagic = BoardFileHeader::Magic;
+    header.mVersion = BoardFileHeader::CurrentVersion;
+    header.mGridX = records.mGrid.x;
+    header.mGridY = records.mGrid.y;
+    header.mGridSpacing = records.mGridSpacing;
+    header.mFlags = records.mFlags;
+    header.mRevision = records.mRevision;
+
+    // The header is written twice, first as a placeholder and again once the section table is known
+    BoardFileWriter writer(file);
+    writer.Write(&header, sizeof(header));
+
+    auto section = [&](BoardFileSection fileSection) -> BoardFileSectionEntry&
+    {
+        return header.mSections[static_cast<uint32_t>(fileSection)];
+    };
+    section(BoardFileSection::ComponentTypes) = writer.WriteSection(records.mComponentTypes);
+    section(BoardFileSection::Components) = writer.WriteSection(records.mComponents);
+    section(BoardFileSection::ComponentPins) = writer.WriteSection(records.mComponentPins);
+    section(BoardFileSection::Nodes) = writer.WriteSection(records.mNodes);
+    section(BoardFileSection::Connections) = writer.WriteSection(records.mConnections);
+    section(BoardFileSection::Wires) = writer.WriteSection(records.mWires);
+    section(BoardFileSection::WirePins) = writer.WriteSection(records.mWirePins);
+
+    std::vector<TileRecord> tiles;
+    std::vector<uint32_t> tileComponents;
+    BuildTileIndex(records, tiles, tileComponents);
+    section(BoardFileSection::Tiles) = writer.WriteSection(tiles);
+    section(BoardFileSection::TileComponents) = writer.WriteSection(tileComponents);
+    section(BoardFileSection::ComponentValues) = writer.WriteSection(records.mComponentValues);
+
+    bool isWritten = writer.IsGood()
+        && std::fseek(file, 0, SEEK_SET) == 0
+        && std::fwrite(&header, sizeof(header), 1, file) == 1
+        && FlushToDisk(file);
+    isWritten = std::fclose(file) == 0 && isWritten;
+
+    std::error_code error;
+    if (isWritten)
+    {
+        std::filesystem::rename(temporaryPath, filePath, error);
+        isWritten = !error && FlushDirectoryToDisk(filePath);
+    }
+
+    if (!isWritten)
+    {
+        std::filesystem::remove(temporaryPath, error);
+    }
+    return isWritten;
+}
+
+bool BoardFileView::Open(const std::string& filePath, std::string& outError)
+{
+    mHeader = nullptr;
+    if (!mFile.Open(filePath))
+    {
+        outError = "Cannot open " + filePath;
+        return false;
+    }
+
+    // Magic and version come first in every version of the header
+    const BoardFileHeader* header = reinterpret_cast<const BoardFileHeader*>(mFile.GetData());
+    if (mFile.GetSize() < 2 * sizeof(uint32_t) || header->mMagic != BoardFileHeader::Magic)
+    {
+        outError = "Not a board file";
+        return false;
+    }
+
+    if (header->mVersion == 0 || header->mVersion > BoardFileHeader::CurrentVersion)
+    {
+        outError = "Unsupported board file version " + std::to_string(header->mVersion);
+        return false;
+    }
+
+    uint32_t sectionCount = BoardFileHeader::GetSectionCount(header->mVersion);
+    if (mFile.GetSize() < offsetof(BoardFileHeader, mSections) + sectionCount * sizeof(BoardFileSectionEntry))
+    {
+        outError = "File is too small to be a board file";
+        return false;
+    }
+
+    // The board pads its rows of pin tiles, the padded grid has to fit as well
+    if (header->mGridX < 2 || header->mGridY < 2 || !PinLayout::IsGridSupported(sf::Vector2u(header->mGridX, header->mGridY)))
+    {
+        outError = "Invalid grid size";
+        return false;
+    }
+
+    if (!std::isfinite(header->mGridSpacing) || !(header->mGridSpacing > 0.0f))
+    {
+        outError = "Invalid grid spacing";
+        return false;
+    }
+
+    for (uint32_t index = 0; index < sectionCount; index++)
+    {
+        const BoardFileSectionEntry& entry = header->mSections[index];
+        size_t recordSize = GetRecordSize(static_cast<BoardFileSection>(index));
+
+        bool isAligned = entry.mOffset % 8 == 0;
+        bool isCountValid = entry.mCount <= std::numeric_limits<uint64_t>::max() / recordSize;
+        if (!isAligned || !isCountValid || !IsRangeWithin(entry.mOffset, entry.mCount * recordSize, mFile.GetSize()))
+        {
+            outError = "Corrupt section table";
+            return false;
+        }
+    }
+
+    mHeader = header;
+    mSectionCount = sectionCount;
+    return true;
+}
\ No newline at end of file
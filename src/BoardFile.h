@@ -0,0 +1,51 @@
+#pragma once
+
+#include "BoardFormat.h"
+#include "BoardRecords.h"
+#include "MappedFile.h"
+
+#include <string>
+
+// Writes to a temporary file next to filePath, flushes it to disk and renames it over filePath, so a
+// crash mid-save never leaves a torn board file behind
+bool WriteBoardFile(const BoardRecords& records, const std::string& filePath);
+
+// Zero-copy access to a memory mapped board file. Open validates the header and that every section lies
+// within the file, records are then read in place and only paged in when touched.
+class BoardFileView
+{
+public:
+    bool Open(const std::string& filePath, std::string& outError);
+
+    const BoardFileHeader& GetHeader() const { return *mHeader; }
+
+    template<typename Record>
+    const Record* GetSection(BoardFileSection section) const
+    {
+        return reinterpret_cast<const Record*>(mFile.GetData() + GetEntry(section).mOffset);
+    }
+
+    size_t GetCount(BoardFileSection section) const
+    {
+        return static_cast<size_t>(GetEntry(section).mCount);
+    }
+
+    // first + count <= total without overflowing
+    static bool IsRangeWithin(uint64_t first, uint64_t count, uint64_t total)
+    {
+        return first <= total && count <= total - first;
+    }
+
+private:
+    // Sections newer than the file are empty
+    const BoardFileSectionEntry& GetEntry(BoardFileSection section) const
+    {
+        static const BoardFileSectionEntry emptyEntry{ 0, 0 };
+        uint32_t index = static_cast<uint32_t>(section);
+        return index < mSectionCount ? mHeader->mSections[index] : emptyEntry;
+    }
+
+    MappedFile mFile;
+    const BoardFileHeader* mHeader{ nullptr };
+    uint32_t mSectionCount{ 0 };
+};
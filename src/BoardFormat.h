@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+
+// On-disk board file layout. A header is followed by flat, 8 byte aligned arrays of the records below,
+// located through the header's section table. All values are little endian.
+
+struct ComponentTypeRecord
+{
+    char mName[32];  // Zero terminated
+};
+
+struct ComponentRecord
+{
+    uint32_t mTypeId;      // Index into the component type section
+    uint32_t mFirstPin;    // Index into the component pin section
+    uint32_t mPinCount;
+    uint32_t mFirstNode;   // Index into the node section
+    uint32_t mNodeCount;
+};
+
+struct ComponentPinRecord
+{
+    static constexpr uint32_t UnassociatedPin = 0xFFFFFFFF;
+
+    uint32_t mBoardPinId;     // Circuit board pin the component pin is associated with
+    uint32_t mIsConnectable;
+};
+
+struct NodeRecord
+{
+    float mX;
+    float mY;
+};
+
+struct ConnectionRecord
+{
+    uint32_t mSourceComponent;
+    uint32_t mSourceComponentPin;
+    uint32_t mTargetComponent;
+    uint32_t mTargetComponentPin;
+};
+
+struct WireRecord
+{
+    uint32_t mFirstPin;  // Index into the wire pin section
+    uint32_t mPinCount;
+};
+
+// Components are bucketed by the tile of the first board pin they are associated with, so a region of the
+// board can be loaded on its own. Tiles are TileSize x TileSize board pins, in row major order, followed by
+// one extra bucket for components reaching past the tiles around their own.
+struct TileRecord
+{
+    static constexpr uint32_t TileSize = 64;
+
+    static constexpr uint32_t GetTileCount(uint32_t pinCount) { return (pinCount + TileSize - 1) / TileSize; }
+
+    uint32_t mFirstComponent;  // Index into the tile component section
+    uint32_t mComponentCount;
+};
+
+enum class BoardFileSection : uint32_t
+{
+    ComponentTypes,
+    Components,
+    ComponentPins,
+    Nodes,
+    Connections,
+    Wires,
+    WirePins,        // uint32_t circuit board pin ids
+    Tiles,           // Since version 2
+    TileComponents,  // uint32_t component ids
+    ComponentValues, // double per component, since version 3
+    Count
+};
+
+struct BoardFileSectionEntry
+{
+    uint64_t mOffset;  // From the start of the file
+    uint64_t mCount;   // In records
+};
+
+struct BoardFileHeader
+{
+    static constexpr uint32_t Magic = 0x46425343;  // "CSBF"
+    static constexpr uint32_t CurrentVersion = 3;
+    static constexpr uint32_t IterativeSolverFlag = 1 << 0;  // Solve large partitions iteratively
+
+    // Older files end their section table before the sections added since
+    static constexpr uint32_t GetSectionCount(uint32_t version)
+    {
+        switch (version)
+        {
+            case 1: return static_cast<uint32_t>(BoardFileSection::Tiles);
+            case 2: return static_cast<uint32_t>(BoardFileSection::ComponentValues);
+            default: return static_cast<uint32_t>(BoardFileSection::Count);
+        }
+    }
+
+    uint32_t mMagic;
+    uint32_t mVersion;
+    int32_t mGridX;
+    int32_t mGridY;
+    float mGridSpacing;
+    uint32_t mFlags;
+    uint64_t mRevision;
+    BoardFileSectionEntry mSections[static_cast<uint32_t>(BoardFileSection::Count)];
+};
+
+static_assert(sizeof(ComponentTypeRecord) == 32);
+static_assert(sizeof(ComponentRecord) == 20);
+static_assert(sizeof(ComponentPinRecord) == 8);
+static_assert(sizeof(NodeRecord) == 8);
+static_assert(sizeof(ConnectionRecord) == 16);
+static_assert(sizeof(WireRecord) == 8);
+static_assert(sizeof(TileRecord) == 8);
+static_assert(sizeof(BoardFileHeader) == 32 + 16 * static_cast<uint32_t>(BoardFileSection::Count));
\ No newline at end of file
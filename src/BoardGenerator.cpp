@@ -0,0 +1,95 @@
+#include "BoardGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+
+BoardGenerator::BoardGenerator(const BoardGeneratorSettings& settings)
+    : mSettings(settings)
+{ }
+
+BoardGeneratorStats BoardGenerator::Populate(CircuitBoard& circuitBoard, const std::vector<const Component*>& prototypes)
+{
+    assert(!prototypes.empty() && mSettings.mDensity > 0.0f);
+
+    BoardGeneratorStats stats;
+    mRandom.seed(mSettings.mSeed);
+    mPlacedPinIds.clear();
+    mPlacedPinIds.reserve(mSettings.mComponentCount);
+
+    // Size the populated region so the footprints of all components cover the requested density
+    const sf::Vector2i& grid = circuitBoard.GetGrid();
+    std::unique_ptr<Component> sample(prototypes.front()->CreateShapeAt(&circuitBoard, 0));
+    OccupancyFootprint footprint;
+    sample->CollectFootprint(footprint);
+
+    double regionArea = static_cast<double>(mSettings.mComponentCount) * footprint.GetPinCount() / mSettings.mDensity;
+    int32_t regionSide = static_cast<int32_t>(std::ceil(std::sqrt(regionArea)));
+    mRegion = { std::clamp(regionSide, 1, grid.x), std::clamp(regionSide, 1, grid.y) };
+    mGrid = grid;
+
+    // Connections are made once, after the last component
+    BoardBuilder boardBuilder(circuitBoard);
+    for (size_t index = 0; index < mSettings.mComponentCount; index++)
+    {
+        const Component& prototype = *prototypes[RandomBelow(prototypes.size())];
+        bool isConnected = !mPlacedPinIds.empty() && RandomChance(mSettings.mConnectivity);
+
+        bool isPlaced = false;
+        size_t pendingConnectionCount = boardBuilder.GetPendingConnectionCount();
+        for (size_t attempt = 0; attempt < mSettings.mMaxAttempts && !isPlaced; attempt++)
+        {
+            uint32_t pinId = isConnected
+                ? RandomPinNear(mPlacedPinIds[RandomBelow(mPlacedPinIds.size())])
+                : RandomPinInRegion();
+
+            isPlaced = TryPlace(boardBuilder, prototype, pinId);
+            if (!isPlaced)
+            {
+                stats.mRejectedPlacements++;
+            }
+        }
+
+        if (!isPlaced)
+        {
+            stats.mSkippedComponents++;
+            continue;
+        }
+
+        stats.mPlacedComponents++;
+        if (boardBuilder.GetPendingConnectionCount() > pendingConnectionCount)
+        {
+            stats.mConnectedComponents++;
+        }
+    }
+
+    boardBuilder.Commit();
+    return stats;
+}
+
+bool BoardGenerator::TryPlace(BoardBuilder& boardBuilder, const Component& prototype, uint32_t pinId)
+{
+    if (boardBuilder.Place(prototype, pinId) == nullptr)
+    {
+        return false;
+    }
+
+    mPlacedPinIds.push_back(pinId);
+    return true;
+}
+
+uint32_t BoardGenerator::RandomPinInRegion()
+{
+    uint32_t x = static_cast<uint32_t>(RandomBelow(mRegion.x));
+    uint32_t y = static_cast<uint32_t>(RandomBelow(mRegion.y));
+    return x + y * mGrid.x;
+}
+
+// Neighbors two pins away share a connectable pin with typical two by two footprints
+uint32_t BoardGenerator::RandomPinNear(uint32_t pinId)
+{
+    int32_t x = static_cast<int32_t>(pinId % mGrid.x) + static_cast<int32_t>(RandomBelow(5)) - 2;
+    int32_t y = static_cast<int32_t>(pinId / mGrid.x) + static_cast<int32_t>(RandomBelow(5)) - 2;
+    x = std::clamp(x, 0, mGrid.x - 1);
+    y = std::clamp(y, 0, mGrid.y - 1);
+    return static_cast<uint32_t>(x + y * mGrid.x);
+}
\ No newline at end of file
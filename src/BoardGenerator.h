@@ -0,0 +1,52 @@
+#pragma once
+
+#include "BoardBuilder.h"
+#include "CircuitBoard.h"
+#include "Component.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+struct BoardGeneratorSettings
+{
+    sf::Vector2i mGrid{ 1024, 1024 };
+    size_t mComponentCount{ 10000 };
+    float mDensity{ 0.3f };        // Fraction of the pins of the populated region claimed by components
+    float mConnectivity{ 0.5f };   // Chance a component is placed against an already placed one
+    size_t mMaxAttempts{ 16 };     // Placement attempts per component before it is skipped
+    uint64_t mSeed{ 0 };
+};
+
+struct BoardGeneratorStats
+{
+    size_t mPlacedComponents{ 0 };
+    size_t mConnectedComponents{ 0 };
+    size_t mSkippedComponents{ 0 };
+    size_t mRejectedPlacements{ 0 };
+};
+
+// Populates a circuit board through the same placement rules as the editor, reproducibly from a seed
+class BoardGenerator
+{
+public:
+    BoardGenerator(const BoardGeneratorSettings& settings);
+
+    // Components are cloned from the prototypes, picked uniformly
+    BoardGeneratorStats Populate(CircuitBoard& circuitBoard, const std::vector<const Component*>& prototypes);
+
+private:
+    bool TryPlace(BoardBuilder& boardBuilder, const Component& prototype, uint32_t pinId);
+    uint32_t RandomPinInRegion();
+    uint32_t RandomPinNear(uint32_t pinId);
+
+    // std distributions differ between standard libraries, only the raw engine output is reproducible
+    uint64_t RandomBelow(uint64_t bound) { return mRandom() % bound; }
+    bool RandomChance(float probability) { return (mRandom() >> 11) * (1.0 / 9007199254740992.0) < probability; }
+
+    BoardGeneratorSettings mSettings;
+    std::mt19937_64 mRandom;
+    sf::Vector2i mGrid;
+    sf::Vector2i mRegion;
+    std::vector<uint32_t> mPlacedPinIds;
+};
\ No newline at end of file
@@ -0,0 +1,204 @@
+#include "BoardImageExporter.h"
+#include "CircuitBoard.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+BoardImageExporter::BoardImageExporter(JobSystem& jobSystem)
+    : mJobSystem(jobSystem)
+{ }
+
+bool BoardImageExporter::Export(const CircuitBoard& circuitBoard, const std::string& filePath, const BoardImageSettings& settings, std::string& outError)
+{
+    auto start = std::chrono::steady_clock::now();
+    mStats = BoardImageStats();
+    mSettings = settings;
+    mProgress = 0.0f;
+
+    if (circuitBoard.IsLoading())
+    {
+        outError = "Board is still loading";
+        return false;
+    }
+
+    if (!(settings.mPixelsPerUnit > 0.0f) || !std::isfinite(settings.mPixelsPerUnit))
+    {
+        outError = "Invalid scale";
+        return false;
+    }
+
+    // Pins and outlines reach past the outermost pins
+    float margin = CircuitBoard::PinRadius + 1.0f;
+    sf::Vector2f extent = sf::Vector2f(circuitBoard.GetGrid() - sf::Vector2i(1, 1)) * circuitBoard.GetGridSpacing() + sf::Vector2f(2.0f * margin, 2.0f * margin);
+    double width = std::ceil(static_cast<double>(extent.x) * settings.mPixelsPerUnit);
+    double height = std::ceil(static_cast<double>(extent.y) * settings.mPixelsPerUnit);
+    if (width > std::numeric_limits<uint32_t>::max() - settings.mTileSize || height > std::numeric_limits<uint32_t>::max() - settings.mTileSize)
+    {
+        outError = "Image too large";
+        return false;
+    }
+
+    mWorldOrigin = { -margin, -margin };
+    mStats.mImageSize = { static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
+    if (!mWriter.Open(filePath, mStats.mImageSize, settings.mTileSize, outError))
+    {
+        return false;
+    }
+    mTileCount = mWriter.GetTileCount();
+    mStats.mTileCount = mWriter.GetTotalTileCount();
+    BinWireSegments(circuitBoard);
+
+    // A batch renders into one half of the lanes while the batch before it is written from the other
+    size_t batchSize = mJobSystem.GetThreadCount();
+    size_t batchCount = (mStats.mTileCount + batchSize - 1) / batchSize;
+    mLanes.resize(2 * batchSize);
+
+    JobGroup rendering;
+    auto scheduleBatch = [&](size_t batch)
+    {
+        for (size_t tileId = batch * batchSize; tileId < std::min((batch + 1) * batchSize, mStats.mTileCount); tileId++)
+        {
+            Lane* lane = &mLanes[(batch % 2) * batchSize + tileId % batchSize];
+            mJobSystem.Schedule(rendering, [this, &circuitBoard, tileId, lane]()
+            {
+                RenderTile(circuitBoard, static_cast<uint32_t>(tileId), *lane);
+            });
+        }
+    };
+
+    scheduleBatch(0);
+    for (size_t batch = 0; batch < batchCount; batch++)
+    {
+        mJobSystem.Wait(rendering);
+        if (batch + 1 < batchCount)
+        {
+            scheduleBatch(batch + 1);
+        }
+
+        for (size_t tileId = batch * batchSize; tileId < std::min((batch + 1) * batchSize, mStats.mTileCount); tileId++)
+        {
+            const Lane& lane = mLanes[(batch % 2) * batchSize + tileId % batchSize];
+            if (!mWriter.WriteTile(lane.mCanvas.GetPixels(), outError))
+            {
+                mJobSystem.Wait(rendering);
+                return false;
+            }
+        }
+        mProgress = static_cast<float>(batch + 1) / batchCount;
+    }
+
+    if (!mWriter.Close(outError))
+    {
+        return false;
+    }
+
+    mStats.mMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+// Counted first so the segments of every tile are stored back to back
+void BoardImageExporter::BinWireSegments(const CircuitBoard& circuitBoard)
+{
+    const auto& vertices = circuitBoard.GetWireVertices();
+    size_t tileTotal = static_cast<size_t>(mTileCount.x) * mTileCount.y;
+    float tileExtent = mSettings.mTileSize / mSettings.mPixelsPerUnit;
+    float reach = 1.0f / mSettings.mPixelsPerUnit;
+
+    auto forEachTile = [&](size_t segment, auto function)
+    {
+        sf::Vector2f start = vertices[2 * segment].position - mWorldOrigin;
+        sf::Vector2f end = vertices[2 * segment + 1].position - mWorldOrigin;
+        auto toTile = [&](float position, uint32_t tileCount)
+        {
+            return static_cast<uint32_t>(std::clamp(position / tileExtent, 0.0f, static_cast<float>(tileCount - 1)));
+        };
+
+        uint32_t firstX = toTile(std::min(start.x, end.x) - reach, mTileCount.x);
+        uint32_t lastX = toTile(std::max(start.x, end.x) + reach, mTileCount.x);
+        uint32_t firstY = toTile(std::min(start.y, end.y) - reach, mTileCount.y);
+        uint32_t lastY = toTile(std::max(start.y, end.y) + reach, mTileCount.y);
+        for (uint32_t tileY = firstY; tileY <= lastY; tileY++)
+        {
+            for (uint32_t tileX = firstX; tileX <= lastX; tileX++)
+            {
+                function(tileX + tileY * mTileCount.x);
+            }
+        }
+    };
+
+    size_t segmentCount = vertices.size() / 2;
+    mTileSegmentStarts.assign(tileTotal + 1, 0);
+    for (size_t segment = 0; segment < segmentCount; segment++)
+    {
+        forEachTile(segment, [&](size_t tileId) { mTileSegmentStarts[tileId + 1]++; });
+    }
+
+    for (size_t tileId = 0; tileId < tileTotal; tileId++)
+    {
+        mTileSegmentStarts[tileId + 1] += mTileSegmentStarts[tileId];
+    }
+
+    // Filled through the starts, which are moved back into place afterwards
+    mTileSegments.resize(mTileSegmentStarts[tileTotal]);
+    for (size_t segment = 0; segment < segmentCount; segment++)
+    {
+        forEachTile(segment, [&](size_t tileId) { mTileSegments[mTileSegmentStarts[tileId]++] = static_cast<uint32_t>(segment); });
+    }
+
+    for (size_t tileId = tileTotal; tileId > 0; tileId--)
+    {
+        mTileSegmentStarts[tileId] = mTileSegmentStarts[tileId - 1];
+    }
+    mTileSegmentStarts[0] = 0;
+}
+
+// In the order the window draws: pins, wires, then components by id
+void BoardImageExporter::RenderTile(const CircuitBoard& circuitBoard, uint32_t tileId, Lane& lane) const
+{
+    sf::FloatRect rect = GetTileWorldRect(tileId);
+    RasterCanvas& canvas = lane.mCanvas;
+    canvas.Reset({ mSettings.mTileSize, mSettings.mTileSize }, rect.getPosition(), mSettings.mPixelsPerUnit, mSettings.mBackground);
+
+    // A pixel of slack, shapes cover the pixels whose centers they contain
+    float pixel = 1.0f / mSettings.mPixelsPerUnit;
+    const sf::Vector2i& grid = circuitBoard.GetGrid();
+    float spacing = circuitBoard.GetGridSpacing();
+    float reach = CircuitBoard::PinRadius + pixel;
+    int32_t firstX = std::max(static_cast<int32_t>(std::ceil((rect.left - reach) / spacing)), 0);
+    int32_t lastX = std::min(static_cast<int32_t>(std::floor((rect.left + rect.width + reach) / spacing)), grid.x - 1);
+    int32_t firstY = std::max(static_cast<int32_t>(std::ceil((rect.top - reach) / spacing)), 0);
+    int32_t lastY = std::min(static_cast<int32_t>(std::floor((rect.top + rect.height + reach) / spacing)), grid.y - 1);
+    for (int32_t indexY = firstY; indexY <= lastY; indexY++)
+    {
+        for (int32_t indexX = firstX; indexX <= lastX; indexX++)
+        {
+            canvas.DrawPoint(sf::Vector2f(indexX, indexY) * spacing, CircuitBoard::PinRadius, sf::Color::Cyan);
+        }
+    }
+
+    const auto& vertices = circuitBoard.GetWireVertices();
+    for (uint32_t index = mTileSegmentStarts[tileId]; index < mTileSegmentStarts[tileId + 1]; index++)
+    {
+        canvas.DrawLines(&vertices[2 * mTileSegments[index]], 2);
+    }
+
+    // Outlines reach a unit past the bounds
+    float padding = 1.0f + pixel;
+    sf::FloatRect paddedRect({ rect.left - padding, rect.top - padding }, { rect.width + 2.0f * padding, rect.height + 2.0f * padding });
+    circuitBoard.FindComponentsIn(paddedRect, lane.mComponentIds);
+    std::sort(lane.mComponentIds.begin(), lane.mComponentIds.end());
+    for (uint32_t componentId : lane.mComponentIds)
+    {
+        circuitBoard.GetComponent(componentId).DrawComponent(canvas);
+    }
+}
+
+sf::FloatRect BoardImageExporter::GetTileWorldRect(uint32_t tileId) const
+{
+    float tileExtent = mSettings.mTileSize / mSettings.mPixelsPerUnit;
+    sf::Vector2f position(static_cast<float>(tileId % mTileCount.x) * tileExtent, static_cast<float>(tileId / mTileCount.x) * tileExtent);
+    return sf::FloatRect(mWorldOrigin + position, { tileExtent, tileExtent });
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "MemoryTracker.h"
+#include "RasterCanvas.h"
+#include "TiledImageWriter.h"
+
+#include <SFML/Graphics.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class CircuitBoard;
+class JobSystem;
+
+struct BoardImageSettings
+{
+    float mPixelsPerUnit{ 1.0f };  // Board units are those of the grid spacing
+    uint32_t mTileSize{ 256 };     // Pixels, a multiple of 16
+    sf::Color mBackground{ sf::Color::Black };
+};
+
+struct BoardImageStats
+{
+    sf::Vector2u mImageSize;
+    size_t mTileCount{ 0 };
+    double mMilliseconds{ 0 };
+};
+
+// Renders the whole board into a tiled image (see TiledImageWriter), however large, for publishing
+// snapshots. Tiles are rasterized in software with the same drawing code as the window, a batch of one tile
+// per thread at a time, and written in order as soon as their batch is done, so memory stays at a tile per
+// thread. Components are found through the board's spatial index and wire segments are binned by tile
+// once, a tile only draws what overlaps it. The board must not change during the export.
+class BoardImageExporter
+{
+public:
+    explicit BoardImageExporter(JobSystem& jobSystem);
+
+    bool Export(const CircuitBoard& circuitBoard, const std::string& filePath, const BoardImageSettings& settings, std::string& outError);
+
+    const BoardImageStats& GetStats() const { return mStats; }
+
+    // Share of the tiles written so far, read from any thread while Export runs on another
+    float GetProgress() const { return mProgress; }
+
+private:
+    struct Lane
+    {
+        RasterCanvas mCanvas;
+        std::vector<uint32_t> mComponentIds;
+    };
+
+    void BinWireSegments(const CircuitBoard& circuitBoard);
+    void RenderTile(const CircuitBoard& circuitBoard, uint32_t tileId, Lane& lane) const;
+    sf::FloatRect GetTileWorldRect(uint32_t tileId) const;
+
+    JobSystem& mJobSystem;
+    std::vector<Lane> mLanes;  // Per thread
+    TiledImageWriter mWriter;
+    BoardImageStats mStats;
+    std::atomic<float> mProgress{ 0.0f };
+
+    BoardImageSettings mSettings;
+    sf::Vector2f mWorldOrigin;
+    sf::Vector2u mTileCount;
+
+    // Segments overlapping each tile, those of tile t start at mTileSegmentStarts[t]
+    TrackedVector<uint32_t, MemoryTag::RenderCaches> mTileSegmentStarts;
+    TrackedVector<uint32_t, MemoryTag::RenderCaches> mTileSegments;
+};
\ No newline at end of file
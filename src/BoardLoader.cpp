@@ -0,0 +1,409 @@
+#include "BoardLoader.h"
+#include "CircuitBoard.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+std::unique_ptr<CircuitBoard> BoardLoader::Open(const std::string& filePath, const std::vector<const Component*>& prototypes, std::string& outError)
+{
+    mStage = Stage::Done;
+    mCircuitBoard = nullptr;
+    if (!mView.Open(filePath, outError))
+    {
+        return nullptr;
+    }
+
+    // Resolve component types against the prototypes
+    const ComponentTypeRecord* types = mView.GetSection<ComponentTypeRecord>(BoardFileSection::ComponentTypes);
+    mTypePrototypes.assign(mView.GetCount(BoardFileSection::ComponentTypes), nullptr);
+    for (size_t typeId = 0; typeId < mTypePrototypes.size(); typeId++)
+    {
+        std::string typeName(types[typeId].mName, strnlen(types[typeId].mName, sizeof(types[typeId].mName)));
+        for (const Component* prototype : prototypes)
+        {
+            if (typeName == prototype->GetTypeName())
+            {
+                mTypePrototypes[typeId] = prototype;
+            }
+        }
+
+        if (mTypePrototypes[typeId] == nullptr)
+        {
+            outError = "Unknown component type " + typeName;
+            return nullptr;
+        }
+    }
+
+    const BoardFileHeader& header = mView.GetHeader();
+    auto circuitBoard = std::make_unique<CircuitBoard>(sf::Vector2i(header.mGridX, header.mGridY), header.mGridSpacing);
+    circuitBoard->SetSolverMode(header.mFlags & BoardFileHeader::IterativeSolverFlag ? SolverMode::Iterative : SolverMode::Dense);
+
+    size_t componentCount = mView.GetCount(BoardFileSection::Components);
+    mTileCount = sf::Vector2i(circuitBoard->GetTileCount());
+    mExtraBucket = mTileCount.x * mTileCount.y;
+    mHasTileIndex = mView.GetCount(BoardFileSection::Tiles) > 0;
+    mHasValues = mView.GetCount(BoardFileSection::ComponentValues) > 0;
+    if (mHasValues && mView.GetCount(BoardFileSection::ComponentValues) != componentCount)
+    {
+        outError = "Corrupt component values";
+        return nullptr;
+    }
+
+    if (mHasTileIndex && (mView.GetCount(BoardFileSection::Tiles) != mExtraBucket + 1 || mView.GetCount(BoardFileSection::TileComponents) != componentCount))
+    {
+        outError = "Corrupt tile index";
+        return nullptr;
+    }
+
+    circuitBoard->SetTilesLoading();
+    mCircuitBoard = circuitBoard.get();
+    mIsBucketLoaded.assign(mExtraBucket + 1, 0);
+    mBucket.reset();
+    mComponentIds.assign(componentCount, Unloaded);
+    mFocusTiles = sf::IntRect();
+    mFocusCursor = 0;
+    mRing = 0;
+
+    mStage = Stage::Wires;
+    mCursor = 0;
+    mLoadedCount = 0;
+    mTotalCount = mView.GetCount(BoardFileSection::Wires) + componentCount + mView.GetCount(BoardFileSection::Connections);
+    return circuitBoard;
+}
+
+bool BoardLoader::Update(const sf::FloatRect& focusArea, sf::Time timeBudget, std::string& outError)
+{
+    if (mStage == Stage::Done)
+    {
+        return true;
+    }
+
+    SetFocusArea(focusArea);
+
+    sf::Clock clock;
+    ConnectionConnector connectionConnector;
+    bool isGood = true;
+    while (isGood && mStage != Stage::Done && (timeBudget <= sf::Time::Zero || clock.getElapsedTime() < timeBudget))
+    {
+        switch (mStage)
+        {
+            case Stage::Wires:
+                if (mCursor < mView.GetCount(BoardFileSection::Wires))
+                {
+                    isGood = LoadWire(outError);
+                }
+                else
+                {
+                    mStage = Stage::Components;
+                }
+                break;
+
+            case Stage::Components:
+                if (!mBucket.has_value())
+                {
+                    // The extra bucket goes first, its components may reach into any tile
+                    std::optional<uint32_t> bucket = mIsBucketLoaded[mExtraBucket] ? PickTile() : mExtraBucket;
+                    if (bucket.has_value())
+                    {
+                        isGood = BeginBucket(bucket.value(), outError);
+                    }
+                    else
+                    {
+                        mStage = Stage::Connections;
+                        mCursor = 0;
+                    }
+                }
+                else if (mCursor < mBucketCount)
+                {
+                    isGood = LoadComponent(mBucketComponents ? mBucketComponents[mCursor] : static_cast<uint32_t>(mCursor), outError);
+                }
+                else
+                {
+                    FinishBucket();
+                }
+                break;
+
+            case Stage::Connections:
+                if (mCursor < mView.GetCount(BoardFileSection::Connections))
+                {
+                    isGood = LoadConnection(connectionConnector, outError);
+                }
+                else
+                {
+                    mStage = Stage::Done;
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    // Connections collected in this slice go in as one batch
+    if (connectionConnector.GetConnectorPairCount() > 0)
+    {
+        mCircuitBoard->AddConnections(connectionConnector);
+    }
+
+    if (!isGood)
+    {
+        Stop();
+    }
+    return isGood;
+}
+
+float BoardLoader::GetProgress() const
+{
+    return mTotalCount > 0 && IsLoading() ? static_cast<float>(mLoadedCount) / mTotalCount : 1.0f;
+}
+
+bool BoardLoader::LoadWire(std::string& outError)
+{
+    uint32_t totalPins = mCircuitBoard->TotalPins();
+    const WireRecord& record = mView.GetSection<WireRecord>(BoardFileSection::Wires)[mCursor];
+    const uint32_t* wirePins = mView.GetSection<uint32_t>(BoardFileSection::WirePins);
+
+    bool isValid = BoardFileView::IsRangeWithin(record.mFirstPin, record.mPinCount, mView.GetCount(BoardFileSection::WirePins));
+    for (uint32_t index = 0; isValid && index < record.mPinCount; index++)
+    {
+        isValid = wirePins[record.mFirstPin + index] < totalPins;
+    }
+
+    if (!isValid)
+    {
+        outError = "Corrupt wire " + std::to_string(mCursor);
+        return false;
+    }
+
+    mCircuitBoard->AddWire(wirePins + record.mFirstPin, record.mPinCount);
+    mCursor++;
+    mLoadedCount++;
+    return true;
+}
+
+bool BoardLoader::LoadComponent(uint32_t componentId, std::string& outError)
+{
+    if (componentId >= mComponentIds.size() || mComponentIds[componentId] != Unloaded)
+    {
+        outError = "Corrupt tile index";
+        return false;
+    }
+
+    uint32_t totalPins = mCircuitBoard->TotalPins();
+    const ComponentRecord& record = mView.GetSection<ComponentRecord>(BoardFileSection::Components)[componentId];
+    const ComponentPinRecord* componentPins = mView.GetSection<ComponentPinRecord>(BoardFileSection::ComponentPins);
+    const NodeRecord* nodes = mView.GetSection<NodeRecord>(BoardFileSection::Nodes);
+
+    if (record.mTypeId >= mTypePrototypes.size()
+        || !BoardFileView::IsRangeWithin(record.mFirstPin, record.mPinCount, mView.GetCount(BoardFileSection::ComponentPins))
+        || !BoardFileView::IsRangeWithin(record.mFirstNode, record.mNodeCount, mView.GetCount(BoardFileSection::Nodes)))
+    {
+        outError = "Corrupt component " + std::to_string(componentId);
+        return false;
+    }
+
+    for (uint32_t index = 0; index < record.mPinCount; index++)
+    {
+        uint32_t boardPinId = componentPins[record.mFirstPin + index].mBoardPinId;
+        if (boardPinId >= totalPins && boardPinId != ComponentPinRecord::UnassociatedPin)
+        {
+            outError = "Component " + std::to_string(componentId) + " is off the board";
+            return false;
+        }
+    }
+
+    std::unique_ptr<Component> component(mTypePrototypes[record.mTypeId]->Create(mCircuitBoard));
+    if (component->GetComponentPins().size() != record.mPinCount)
+    {
+        outError = "Component " + std::to_string(componentId) + " does not match its type";
+        return false;
+    }
+
+    component->RestorePlacement(componentPins + record.mFirstPin, nodes + record.mFirstNode, record.mNodeCount);
+    if (mHasValues)
+    {
+        component->SetValue(mView.GetSection<double>(BoardFileSection::ComponentValues)[componentId]);
+    }
+    mCircuitBoard->AddComponent(component.release());
+    mComponentIds[componentId] = static_cast<uint32_t>(mCircuitBoard->GetComponentCount() - 1);
+    mCursor++;
+    mLoadedCount++;
+    return true;
+}
+
+bool BoardLoader::LoadConnection(ConnectionConnector& connectionConnector, std::string& outError)
+{
+    const ConnectionRecord& record = mView.GetSection<ConnectionRecord>(BoardFileSection::Connections)[mCursor];
+    auto getConnector = [&](uint32_t componentId, uint32_t componentPinId) -> Connector*
+    {
+        if (componentId >= mComponentIds.size() || mComponentIds[componentId] == Unloaded)
+        {
+            return nullptr;
+        }
+        return mCircuitBoard->GetConnector(mComponentIds[componentId], componentPinId);
+    };
+
+    Connector* sourceConnector = getConnector(record.mSourceComponent, record.mSourceComponentPin);
+    Connector* targetConnector = getConnector(record.mTargetComponent, record.mTargetComponentPin);
+    if (sourceConnector == nullptr || targetConnector == nullptr)
+    {
+        outError = "Corrupt connection " + std::to_string(mCursor);
+        return false;
+    }
+
+    connectionConnector.AddConnectorPair(sourceConnector, targetConnector);
+    mCursor++;
+    mLoadedCount++;
+    return true;
+}
+
+bool BoardLoader::BeginBucket(uint32_t bucket, std::string& outError)
+{
+    mBucket = bucket;
+    mCursor = 0;
+
+    if (!mHasTileIndex)
+    {
+        mBucketComponents = nullptr;
+        mBucketCount = bucket == mExtraBucket ? mComponentIds.size() : 0;
+        return true;
+    }
+
+    const TileRecord& tile = mView.GetSection<TileRecord>(BoardFileSection::Tiles)[bucket];
+    if (!BoardFileView::IsRangeWithin(tile.mFirstComponent, tile.mComponentCount, mView.GetCount(BoardFileSection::TileComponents)))
+    {
+        outError = "Corrupt tile " + std::to_string(bucket);
+        return false;
+    }
+
+    mBucketComponents = mView.GetSection<uint32_t>(BoardFileSection::TileComponents) + tile.mFirstComponent;
+    mBucketCount = tile.mComponentCount;
+    return true;
+}
+
+void BoardLoader::FinishBucket()
+{
+    uint32_t bucket = mBucket.value();
+    mIsBucketLoaded[bucket] = 1;
+    mBucket.reset();
+
+    // Components of a tile may reach into the tiles around it, so each of those can be ready now
+    if (bucket != mExtraBucket)
+    {
+        int32_t tileX = bucket % mTileCount.x;
+        int32_t tileY = bucket / mTileCount.x;
+        for (int32_t y = tileY - 1; y <= tileY + 1; y++)
+        {
+            for (int32_t x = tileX - 1; x <= tileX + 1; x++)
+            {
+                if (IsTileReady(x, y))
+                {
+                    mCircuitBoard->SetTileLoaded(x + y * mTileCount.x);
+                }
+            }
+        }
+    }
+}
+
+void BoardLoader::SetFocusArea(const sf::FloatRect& focusArea)
+{
+    float tileExtent = TileRecord::TileSize * mCircuitBoard->GetGridSpacing();
+    auto toTile = [&](float coordinate, int32_t tileCount)
+    {
+        return std::clamp(static_cast<int32_t>(std::floor(coordinate / tileExtent)), 0, tileCount - 1);
+    };
+
+    int32_t left = toTile(focusArea.left, mTileCount.x);
+    int32_t top = toTile(focusArea.top, mTileCount.y);
+    int32_t right = toTile(focusArea.left + focusArea.width, mTileCount.x);
+    int32_t bottom = toTile(focusArea.top + focusArea.height, mTileCount.y);
+
+    sf::IntRect focusTiles({ left, top }, { right - left + 1, bottom - top + 1 });
+    if (focusTiles != mFocusTiles)
+    {
+        mFocusTiles = focusTiles;
+        mFocusCursor = 0;
+        mRing = 0;
+    }
+}
+
+std::optional<uint32_t> BoardLoader::PickTile()
+{
+    auto isPending = [&](int32_t x, int32_t y)
+    {
+        return x >= 0 && x < mTileCount.x && y >= 0 && y < mTileCount.y && !mIsBucketLoaded[x + y * mTileCount.x];
+    };
+
+    // Tiles overlapping the focus area, row by row
+    for (; mFocusCursor < static_cast<size_t>(mFocusTiles.width * mFocusTiles.height); mFocusCursor++)
+    {
+        int32_t x = mFocusTiles.left + static_cast<int32_t>(mFocusCursor % mFocusTiles.width);
+        int32_t y = mFocusTiles.top + static_cast<int32_t>(mFocusCursor / mFocusTiles.width);
+        if (isPending(x, y))
+        {
+            return x + y * mTileCount.x;
+        }
+    }
+
+    // Then rings of tiles around the center of the focus area
+    sf::Vector2i center(mFocusTiles.left + mFocusTiles.width / 2, mFocusTiles.top + mFocusTiles.height / 2);
+    int32_t maxRing = std::max({ center.x, mTileCount.x - 1 - center.x, center.y, mTileCount.y - 1 - center.y });
+    for (; mRing <= maxRing; mRing++)
+    {
+        for (int32_t dy = -mRing; dy <= mRing; dy++)
+        {
+            // Only the first and last row of a ring are full rows
+            int32_t step = dy == -mRing || dy == mRing ? 1 : 2 * mRing;
+            for (int32_t dx = -mRing; dx <= mRing; dx += step)
+            {
+                if (isPending(center.x + dx, center.y + dy))
+                {
+                    return (center.x + dx) + (center.y + dy) * mTileCount.x;
+                }
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+bool BoardLoader::IsTileReady(int32_t tileX, int32_t tileY) const
+{
+    if (tileX < 0 || tileX >= mTileCount.x || tileY < 0 || tileY >= mTileCount.y)
+    {
+        return false;
+    }
+
+    for (int32_t y = std::max(tileY - 1, 0); y <= std::min(tileY + 1, mTileCount.y - 1); y++)
+    {
+        for (int32_t x = std::max(tileX - 1, 0); x <= std::min(tileX + 1, mTileCount.x - 1); x++)
+        {
+            if (!mIsBucketLoaded[x + y * mTileCount.x])
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void BoardLoader::Stop()
+{
+    // Whatever was loaded stays usable
+    for (uint32_t tileId = 0; tileId < mExtraBucket; tileId++)
+    {
+        mCircuitBoard->SetTileLoaded(tileId);
+    }
+    mStage = Stage::Done;
+}
+
+std::unique_ptr<CircuitBoard> LoadBoardFile(const std::string& filePath, const std::vector<const Component*>& prototypes, std::string& outError)
+{
+    BoardLoader loader;
+    std::unique_ptr<CircuitBoard> circuitBoard = loader.Open(filePath, prototypes, outError);
+    if (!circuitBoard || !loader.Update(sf::FloatRect(), sf::Time::Zero, outError))
+    {
+        return nullptr;
+    }
+    return circuitBoard;
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "BoardFile.h"
+#include "Component.h"
+#include "MemoryTracker.h"
+
+#include <SFML/Graphics.hpp>
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+class CircuitBoard;
+
+// Loads a board file a slice at a time so the board can be shown and edited while it loads. Wires go
+// first, then the components of the tiles overlapping the focus area, then the remaining tiles nearest to
+// it, and the connections last. A tile accepts placement once it and the tiles around it are loaded.
+class BoardLoader
+{
+public:
+    // Validates the header and resolves the component types against the prototypes by type name. The
+    // returned board is empty with every tile loading, it must outlive the loader.
+    std::unique_ptr<CircuitBoard> Open(const std::string& filePath, const std::vector<const Component*>& prototypes, std::string& outError);
+
+    // Loads until timeBudget is spent, a zero budget loads everything. On a corrupt record loading stops
+    // for good and the board keeps what was loaded so far.
+    bool Update(const sf::FloatRect& focusArea, sf::Time timeBudget, std::string& outError);
+
+    bool IsLoading() const { return mStage != Stage::Done; }
+    float GetProgress() const;
+
+private:
+    enum class Stage
+    {
+        Wires,
+        Components,
+        Connections,
+        Done
+    };
+
+    bool LoadWire(std::string& outError);
+    bool LoadComponent(uint32_t componentId, std::string& outError);
+    bool LoadConnection(ConnectionConnector& connectionConnector, std::string& outError);
+    bool BeginBucket(uint32_t bucket, std::string& outError);
+    void FinishBucket();
+    void SetFocusArea(const sf::FloatRect& focusArea);
+    std::optional<uint32_t> PickTile();
+    bool IsTileReady(int32_t tileX, int32_t tileY) const;
+    void Stop();
+
+    static constexpr uint32_t Unloaded = 0xFFFFFFFF;
+
+    BoardFileView mView;
+    CircuitBoard* mCircuitBoard{ nullptr };
+    std::vector<const Component*> mTypePrototypes;
+    bool mHasValues{ false };  // Files before version 3 keep the default values
+    Stage mStage{ Stage::Done };
+    size_t mCursor{ 0 };  // Next record of the current stage, or of the current bucket
+    size_t mLoadedCount{ 0 };
+    size_t mTotalCount{ 0 };
+
+    // Component buckets, one per tile plus the extra bucket. Files without a tile index have all their
+    // components in the extra bucket.
+    sf::Vector2i mTileCount;
+    uint32_t mExtraBucket{ 0 };
+    bool mHasTileIndex{ false };
+    TrackedVector<uint8_t, MemoryTag::BoardGrid> mIsBucketLoaded;
+    std::optional<uint32_t> mBucket;
+    const uint32_t* mBucketComponents{ nullptr };  // Null when the bucket holds every component in order
+    size_t mBucketCount{ 0 };
+
+    // Board component id of every file component
+    TrackedVector<uint32_t, MemoryTag::BoardRecords> mComponentIds;
+
+    // Tile picking resumes where it left off until the focus moves to other tiles
+    sf::IntRect mFocusTiles;
+    size_t mFocusCursor{ 0 };
+    int32_t mRing{ 0 };
+};
+
+// Loads the whole board at once
+std::unique_ptr<CircuitBoard> LoadBoardFile(const std::string& filePath, const std::vector<const Component*>& prototypes, std::string& outError);
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "BoardFormat.h"
+#include "CowArray.h"
+
+#include <SFML/Graphics.hpp>
+
+#include <cstdint>
+
+// Plain data mirror of everything placed on a circuit board, appended to as the board changes.
+// Copies are O(1) snapshots that stay valid while the board keeps changing.
+struct BoardRecords
+{
+    sf::Vector2i mGrid;
+    float mGridSpacing{ 0 };
+    uint64_t mRevision{ 0 };
+    uint32_t mFlags{ 0 };  // Those of BoardFileHeader
+
+    CowArray<ComponentTypeRecord, MemoryTag::BoardRecords> mComponentTypes;
+    CowArray<ComponentRecord, MemoryTag::BoardRecords> mComponents;
+    CowArray<double, MemoryTag::BoardRecords> mComponentValues;
+    CowArray<ComponentPinRecord, MemoryTag::BoardRecords> mComponentPins;
+    CowArray<NodeRecord, MemoryTag::BoardRecords> mNodes;
+    CowArray<ConnectionRecord, MemoryTag::BoardRecords> mConnections;
+    CowArray<WireRecord, MemoryTag::BoardRecords> mWires;
+    CowArray<uint32_t, MemoryTag::BoardRecords> mWirePins;
+};
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+
+// On-disk layout of a simulation checkpoint. The header is followed by the arrays of the checkpoint, each
+// tightly packed in the order of the counts below, and nothing else. All values are little endian.
+//
+//   First slots         uint32_t per component
+//   Net parents         uint32_t per slot
+//   Partition parents   uint32_t per slot
+//   Elements            CheckpointElementRecord per element
+//   Element slots       uint32_t, two per element
+//   Component elements  uint32_t per component
+//   Lamps               uint32_t per lamp
+//   Cold resistances    double per lamp
+//   Temperatures        double per lamp
+//   Probes              CheckpointProbeRecord per probe
+//   Probe minimums      float per probe
+//   Probe maximums      float per probe
+//   Net voltages        double per slot
+// Nets and partitions of an element are looked up again from its slots on resume
+struct CheckpointElementRecord
+{
+    uint32_t mKind;      // ElementKind
+    uint32_t mReserved;  // Zero
+    double mValue;
+};
+
+struct CheckpointProbeRecord
+{
+    uint32_t mComponentId;
+    uint32_t mComponentPinId;
+};
+
+struct CheckpointFileHeader
+{
+    static constexpr uint32_t Magic = 0x4B435343;  // "CSCK"
+    static constexpr uint32_t CurrentVersion = 3;
+    static constexpr uint32_t OldestVersion = 3;  // Version 2 could not tell which board it belonged to
+
+    uint32_t mMagic;
+    uint32_t mVersion;
+    double mTimeStep;  // Seconds, a checkpoint only resumes with the same step
+    uint64_t mStepCount;
+    uint64_t mComponentCount;
+    uint64_t mConnectionCount;
+    uint64_t mSlotCount;
+    uint64_t mElementCount;
+    uint64_t mLampCount;
+    uint32_t mProbeCount;
+    uint32_t mDecimationCount;
+    uint64_t mWaveformSampleCount;
+    uint64_t mComponentHash;   // BoardFingerprint of the components and connections
+    uint64_t mConnectionHash;
+};
+
+static_assert(sizeof(CheckpointElementRecord) == 16);
+static_assert(sizeof(CheckpointProbeRecord) == 8);
+static_assert(sizeof(CheckpointFileHeader) == 96);
\ No newline at end of file
@@ -0,0 +1,502 @@
+#pragma once
+
+#include "AutoRouter.h"
+#include "BoardRecords.h"
+#include "CircuitNetwork.h"
+#include "CircuitSolver.h"
+#include "Component.h"
+#include "DrawUtils.h"
+#include "LooseQuadtree.h"
+#include "MemoryTracker.h"
+#include "OccupancyBitmap.h"
+#include "PinLayout.h"
+
+#include <SFML/Graphics.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <optional>
+#include <vector>
+
+class CircuitBoard : public ICircuitBoardNavigator
+{
+public:
+    CircuitBoard(sf::Vector2i grid = { 10, 10 }, float gridSpacing = 25)
+        : mSelectedPin(nullptr)
+        , mGrid(grid)
+        , mGridSpacing(gridSpacing)
+        , mPinLayout(sf::Vector2u(grid))
+    {
+        assert(mGrid.x > 1 && mGrid.y > 1 && PinLayout::IsGridSupported(sf::Vector2u(grid)));
+        assert(std::isfinite(mGridSpacing) && mGridSpacing > 0.0f);
+        mPins.reserve(mPinLayout.GetSlotCount());
+        for (uint32_t slot = 0; slot < mPinLayout.GetSlotCount(); slot++)
+        {
+            mPins.emplace_back(mPinLayout.GetPinId(slot));
+        }
+        mSelectedPin = GetPin(0);
+        mOccupancy.Resize(mPinLayout.GetSlotCount());
+        mPinOwners.assign(mPinLayout.GetSlotCount(), 0);
+        mRecords.mGrid = mGrid;
+        mRecords.mGridSpacing = mGridSpacing;
+        mComponentIndex = LooseQuadtree(sf::FloatRect({ 0, 0 }, sf::Vector2f(mGrid) * mGridSpacing));
+    }
+
+    CircuitBoard(const CircuitBoard&) = delete;
+    CircuitBoard& operator=(const CircuitBoard&) = delete;
+
+    ~CircuitBoard()
+    {
+        for (Component* component : mComponents)
+        {
+            delete component;
+        }
+    }
+
+    void AddComponent(Component* component)
+    {
+        component->CollectFootprint(mFootprint);
+        mOccupancy.Claim(mFootprint);
+        component->SetId(static_cast<uint32_t>(mComponents.size()));
+        mComponents.push_back(component);
+        mComponentIndex.Insert(component->GetId(), component->GetBounds());
+        mNetwork.AddComponent(*component);
+        RecordComponent(*component);
+        mPlacementRevision++;
+
+        uint32_t owner = static_cast<uint32_t>(mComponents.size());
+        mFootprint.ForEachPin([&](uint32_t slot)
+        {
+            uint32_t& pinOwner = mPinOwners[slot];
+            if (pinOwner == 0)
+            {
+                pinOwner = owner;
+            }
+        });
+    }
+
+    // Components must have been added before their connections
+    void AddConnections(ConnectionConnector& connectionConnector)
+    {
+        connectionConnector.Connect();
+        for (const auto& [sourceConnector, targetConnector] : connectionConnector.GetConnectorPairs())
+        {
+            mRecords.mConnections.PushBack({
+                sourceConnector->GetComponent()->GetId(), sourceConnector->GetComponentPinId(),
+                targetConnector->GetComponent()->GetId(), targetConnector->GetComponentPinId()
+            });
+            mNetwork.AddConnection(
+                sourceConnector->GetComponent()->GetId(), sourceConnector->GetComponentPinId(),
+                targetConnector->GetComponent()->GetId(), targetConnector->GetComponentPinId());
+        }
+        mRecords.mRevision++;
+    }
+
+    // Refills the connector, which keeps its storage, for a component moving every frame
+    void CollectConnections(const Component* newComponent, ConnectionConnector& outConnectionConnector)
+    {
+        outConnectionConnector.Reset();
+        newComponent->CollectFootprint(mFootprint);
+        outConnectionConnector.SetIsPlaceable(mOccupancy.CanPlace(mFootprint) && !IsFootprintLoading());
+        CollectFootprintConnections(newComponent, outConnectionConnector);
+    }
+
+    // For batches, the connections are appended only when the component can be placed
+    bool TryCollectConnections(const Component* newComponent, ConnectionConnector& outConnectionConnector)
+    {
+        newComponent->CollectFootprint(mFootprint);
+        if (!mOccupancy.CanPlace(mFootprint) || IsFootprintLoading())
+        {
+            return false;
+        }
+
+        CollectFootprintConnections(newComponent, outConnectionConnector);
+        return true;
+    }
+
+    std::vector<RouteResult> RouteWires(const std::vector<RouteRequest>& requests)
+    {
+        AutoRouter router(sf::Vector2u(mGrid), mOccupancy);
+        std::vector<RouteResult> results = router.RouteAll(requests);
+        for (const RouteResult& result : results)
+        {
+            if (result.mIsRouted)
+            {
+                AddWire(result.mPinIds.data(), result.mPinIds.size());
+            }
+        }
+        return results;
+    }
+
+    // Topmost component whose bounds contain the point, components draw in id order
+    std::optional<uint32_t> FindComponentAt(sf::Vector2f position) const
+    {
+        std::optional<uint32_t> found;
+        mComponentIndex.Query(position, [&](uint32_t componentId)
+        {
+            found = std::max(found.value_or(0), componentId);
+        });
+        return found;
+    }
+
+    // Components whose bounds overlap the rectangle, in no particular order
+    void FindComponentsIn(const sf::FloatRect& rect, std::vector<uint32_t>& outComponentIds) const
+    {
+        outComponentIds.clear();
+        mComponentIndex.Query(rect, [&](uint32_t componentId)
+        {
+            outComponentIds.push_back(componentId);
+        });
+    }
+
+    const Component& GetComponent(uint32_t componentId) const { return *mComponents[componentId]; }
+
+    void SetComponentValue(uint32_t componentId, double value)
+    {
+        mComponents.at(componentId)->SetValue(value);
+        mRecords.mComponentValues.Set(componentId, value);
+        mRecords.mRevision++;
+    }
+
+    // Connections in the order they were added
+    size_t GetConnectionCount() const { return mRecords.mConnections.Size(); }
+    const ConnectionRecord& GetConnection(size_t index) const { return mRecords.mConnections[index]; }
+
+    CircuitNetwork& GetNetwork() { return mNetwork; }
+
+    sf::FloatRect GetComponentBounds(uint32_t componentId) const
+    {
+        return mComponents.at(componentId)->GetBounds();
+    }
+
+    uint32_t GetSelectedPinId() const
+    {
+        return mSelectedPin->GetId();
+    }
+
+    void SelectPin(uint32_t pinId)
+    {
+        assert(pinId < TotalPins());
+        mSelectedPin = GetPin(pinId);
+    }
+
+    // O(1), the snapshot stays valid and unchanged while the board keeps changing
+    BoardRecords TakeSnapshot() const { return mRecords; }
+    uint64_t GetRevision() const { return mRecords.mRevision; }
+
+    // Changes whenever collecting the connections of a component can give another result, when pins are
+    // claimed or tiles finish loading
+    uint64_t GetPlacementRevision() const { return mPlacementRevision; }
+
+    // Null when the component or component pin does not exist or the pin is not connectable
+    Connector* GetConnector(uint32_t componentId, uint32_t componentPinId) const
+    {
+        if (componentId >= mComponents.size() || componentPinId >= mComponents[componentId]->GetComponentPins().size())
+        {
+            return nullptr;
+        }
+        return mComponents[componentId]->GetConnector(componentPinId);
+    }
+
+    // Placement is refused on tiles (see TileRecord) that are still being loaded
+    void SetTilesLoading()
+    {
+        mLoadingTiles.assign(GetTileCount().x * GetTileCount().y, 1);
+        mLoadingTileCount = static_cast<uint32_t>(mLoadingTiles.size());
+        mPlacementRevision++;
+    }
+
+    void SetTileLoaded(uint32_t tileId)
+    {
+        if (mLoadingTiles[tileId])
+        {
+            mLoadingTiles[tileId] = 0;
+            mLoadingTileCount--;
+            mPlacementRevision++;
+        }
+    }
+
+    bool IsLoading() const { return mLoadingTileCount > 0; }
+
+    sf::Vector2u GetTileCount() const
+    {
+        return { TileRecord::GetTileCount(mGrid.x), TileRecord::GetTileCount(mGrid.y) };
+    }
+
+    // Saved with the board
+    SolverMode GetSolverMode() const
+    {
+        return mRecords.mFlags & BoardFileHeader::IterativeSolverFlag ? SolverMode::Iterative : SolverMode::Dense;
+    }
+
+    void SetSolverMode(SolverMode mode)
+    {
+        if (mode != GetSolverMode())
+        {
+            mRecords.mFlags ^= BoardFileHeader::IterativeSolverFlag;
+            mRecords.mRevision++;
+        }
+    }
+
+    static constexpr float PinRadius = 4.0f;
+
+    // Pairs of vertices, one pair per segment of a routed wire
+    const TrackedVector<sf::Vertex, MemoryTag::RenderCaches>& GetWireVertices() const { return mWireVertices; }
+
+    const sf::Vector2i& GetGrid() const { return mGrid; }
+
+    // In 32 bits unsigned, the pin count of a supported grid may not fit a signed int
+    uint32_t TotalPins() const { return static_cast<uint32_t>(mGrid.x) * static_cast<uint32_t>(mGrid.y); }
+    float GetGridSpacing() const { return mGridSpacing; }
+    size_t GetComponentCount() const { return mComponents.size(); }
+
+    void UpdateSelectedPin(sf::Vector2f cursorWorldCoord)
+    {
+        float nearestGridX = std::round(cursorWorldCoord.x / mGridSpacing) * mGridSpacing;
+        float nearestGridY = std::round(cursorWorldCoord.y / mGridSpacing) * mGridSpacing;
+
+        nearestGridX = std::clamp(nearestGridX, 0.0f, (mGrid.x - 1) * mGridSpacing);
+        nearestGridY = std::clamp(nearestGridY, 0.0f, (mGrid.y - 1) * mGridSpacing);
+
+        uint32_t indexX = nearestGridX / mGridSpacing;
+        uint32_t indexY = nearestGridY / mGridSpacing;
+
+        mSelectedPin = &mPins[mPinLayout.GetSlot(indexX, indexY)];
+    }
+
+    void Draw(sf::RenderTarget& target)
+    {
+        for (uint32_t indexY = 0; indexY < mGrid.y; indexY++)
+        {
+            for (uint32_t indexX = 0; indexX < mGrid.x; indexX++)
+            {
+                sf::Vector2f position = sf::Vector2f(indexX, indexY) * mGridSpacing;
+                DrawPoint(target, position, PinRadius, sf::Color::Cyan);
+            }
+        }
+
+        target.draw(mWireVertices.data(), mWireVertices.size(), sf::PrimitiveType::Lines);
+
+        TargetCanvas canvas(target);
+        for (Component* component : mComponents)
+        {
+            component->DrawComponent(canvas);
+        }
+
+        if (IsLoading())
+        {
+            DrawLoadingTiles(target);
+        }
+
+        if (mSelectedPin)
+        {
+            DrawPoint(target, GetGridCoordinateFromPin(*mSelectedPin), 4, sf::Color::White);
+        }
+    }
+
+    void AddWire(const uint32_t* pinIds, size_t pinCount)
+    {
+        // Wire endpoints stay connectable, the interior of a wire blocks other components and wires
+        mFootprint.Reset();
+        for (size_t index = 0; index < pinCount; index++)
+        {
+            bool isEndpoint = index == 0 || index + 1 == pinCount;
+            mFootprint.AddPin(pinIds[index], isEndpoint);
+        }
+        mOccupancy.Claim(mFootprint);
+        mPlacementRevision++;
+
+        for (size_t index = 1; index < pinCount; index++)
+        {
+            mWireVertices.emplace_back(sf::Vector2f(Get2DPinIndex(pinIds[index - 1])) * mGridSpacing, sf::Color::Yellow);
+            mWireVertices.emplace_back(sf::Vector2f(Get2DPinIndex(pinIds[index])) * mGridSpacing, sf::Color::Yellow);
+        }
+
+        mRecords.mWires.PushBack({ static_cast<uint32_t>(mRecords.mWirePins.Size()), static_cast<uint32_t>(pinCount) });
+        for (size_t index = 0; index < pinCount; index++)
+        {
+            mRecords.mWirePins.PushBack(pinIds[index]);
+        }
+        mRecords.mRevision++;
+    }
+
+private:
+    // Only a footprint touching claimed pins can have anything to connect to. Connecting to the first
+    // component that claimed a shared pin is enough, the others are already connected to it.
+    void CollectFootprintConnections(const Component* newComponent, ConnectionConnector& outConnectionConnector)
+    {
+        if (!mOccupancy.Intersects(mFootprint))
+        {
+            return;
+        }
+
+        mNeighborComponents.clear();
+        mFootprint.ForEachPin([&](uint32_t slot)
+        {
+            uint32_t owner = mPinOwners[slot];
+            if (owner != 0 && std::find(mNeighborComponents.begin(), mNeighborComponents.end(), owner) == mNeighborComponents.end())
+            {
+                mNeighborComponents.push_back(owner);
+            }
+        });
+
+        for (uint32_t owner : mNeighborComponents)
+        {
+            newComponent->CollectConnections(*mComponents[owner - 1], outConnectionConnector);
+        }
+    }
+
+    bool IsFootprintLoading()
+    {
+        bool isLoading = false;
+        if (IsLoading())
+        {
+            mFootprint.ForEachPin([&](uint32_t slot)
+            {
+                sf::Vector2u position = mPinLayout.GetPosition(slot);
+                uint32_t tileX = position.x / TileRecord::TileSize;
+                uint32_t tileY = position.y / TileRecord::TileSize;
+                isLoading = isLoading || mLoadingTiles[tileX + tileY * GetTileCount().x];
+            });
+        }
+        return isLoading;
+    }
+
+    void DrawLoadingTiles(sf::RenderTarget& target)
+    {
+        float tileExtent = TileRecord::TileSize * mGridSpacing;
+        sf::Color color(40, 40, 40, 200);
+
+        mLoadingTileVertices.clear();
+        for (uint32_t tileId = 0; tileId < mLoadingTiles.size(); tileId++)
+        {
+            if (!mLoadingTiles[tileId])
+            {
+                continue;
+            }
+
+            sf::Vector2f topLeft(tileId % GetTileCount().x * tileExtent, tileId / GetTileCount().x * tileExtent);
+            sf::Vector2f bottomRight = topLeft + sf::Vector2f(tileExtent, tileExtent);
+            mLoadingTileVertices.emplace_back(topLeft, color);
+            mLoadingTileVertices.emplace_back(sf::Vector2f(bottomRight.x, topLeft.y), color);
+            mLoadingTileVertices.emplace_back(bottomRight, color);
+            mLoadingTileVertices.emplace_back(topLeft, color);
+            mLoadingTileVertices.emplace_back(bottomRight, color);
+            mLoadingTileVertices.emplace_back(sf::Vector2f(topLeft.x, bottomRight.y), color);
+        }
+        target.draw(mLoadingTileVertices.data(), mLoadingTileVertices.size(), sf::PrimitiveType::Triangles);
+    }
+
+    void RecordComponent(const Component& component)
+    {
+        const auto& componentPins = component.GetComponentPins();
+        const auto& nodes = component.GetNodes();
+
+        ComponentRecord record;
+        record.mTypeId = GetComponentTypeId(component.GetTypeName());
+        record.mFirstPin = static_cast<uint32_t>(mRecords.mComponentPins.Size());
+        record.mPinCount = static_cast<uint32_t>(componentPins.size());
+        record.mFirstNode = static_cast<uint32_t>(mRecords.mNodes.Size());
+        record.mNodeCount = static_cast<uint32_t>(nodes.size());
+        mRecords.mComponents.PushBack(record);
+        mRecords.mComponentValues.PushBack(component.GetValue());
+
+        for (const ComponentPin& componentPin : componentPins)
+        {
+            Pin* circuitBoardPin = componentPin.GetTemporaryConnectionPin();
+            uint32_t boardPinId = circuitBoardPin ? circuitBoardPin->GetId() : ComponentPinRecord::UnassociatedPin;
+            mRecords.mComponentPins.PushBack({ boardPinId, componentPin.IsConnectable() });
+        }
+
+        for (const Node& node : nodes)
+        {
+            mRecords.mNodes.PushBack({ node.GetPosition().x, node.GetPosition().y });
+        }
+        mRecords.mRevision++;
+    }
+
+    uint32_t GetComponentTypeId(const char* typeName)
+    {
+        for (uint32_t typeId = 0; typeId < mRecords.mComponentTypes.Size(); typeId++)
+        {
+            if (std::strncmp(mRecords.mComponentTypes[typeId].mName, typeName, sizeof(ComponentTypeRecord::mName)) == 0)
+            {
+                return typeId;
+            }
+        }
+
+        ComponentTypeRecord record{};
+        std::strncpy(record.mName, typeName, sizeof(record.mName) - 1);
+        mRecords.mComponentTypes.PushBack(record);
+        return static_cast<uint32_t>(mRecords.mComponentTypes.Size() - 1);
+    }
+
+    // ICircuitBoardNavigator interface
+    virtual Pin& GetSelectedPin()
+    {
+        return *mSelectedPin;
+    }
+
+    virtual Pin* GetPin(uint32_t pinId)
+    {
+        return pinId < TotalPins() ? &mPins[mPinLayout.GetSlot(pinId)] : nullptr;
+    }
+
+    // Works on the position of the pin's slot, no division
+    virtual Pin* GetSurroundingPin(Pin& pin, sf::Vector2i offset)  // rename to neahbor
+    {
+        sf::Vector2i newIndex = sf::Vector2i(mPinLayout.GetPosition(GetSlot(pin)));
+        newIndex += offset;
+        if (newIndex.x < 0 || newIndex.x >= mGrid.x || newIndex.y < 0 || newIndex.y >= mGrid.y)
+        {
+            return nullptr;
+        }
+        return &mPins[mPinLayout.GetSlot(static_cast<uint32_t>(newIndex.x), static_cast<uint32_t>(newIndex.y))];
+    }
+
+    virtual sf::Vector2f GetGridCoordinateFromPin(Pin& pin)
+    {
+        sf::Vector2u index = mPinLayout.GetPosition(GetSlot(pin));
+        return sf::Vector2f(index) * mGridSpacing;
+    }
+
+    // Board pins only ever come from mPins
+    virtual uint32_t GetSlot(const Pin& pin) const
+    {
+        assert(&pin >= mPins.data() && &pin < mPins.data() + mPins.size());
+        return static_cast<uint32_t>(&pin - mPins.data());
+    }
+
+    uint32_t Get1DPinIndex(uint32_t xIndex, uint32_t yIndex)
+    {
+        return xIndex + yIndex * mGrid.x;
+    }
+
+    sf::Vector2u Get2DPinIndex(uint32_t index)
+    {
+        uint32_t xIndex = index % mGrid.x;
+        uint32_t yIndex = index / mGrid.x;
+        return { xIndex, yIndex };
+    }
+
+
+    TrackedVector<Component*, MemoryTag::Components> mComponents;
+    Pin* mSelectedPin;
+    TrackedVector<Pin, MemoryTag::BoardGrid> mPins;  // In mPinLayout order, like all per-pin board data
+    OccupancyBitmap mOccupancy;
+    OccupancyFootprint mFootprint;
+    TrackedVector<uint32_t, MemoryTag::BoardGrid> mPinOwners;  // One based index into mComponents of the first component claiming a pin
+    TrackedVector<uint32_t, MemoryTag::Connectivity> mNeighborComponents;
+    TrackedVector<sf::Vertex, MemoryTag::RenderCaches> mWireVertices;
+    TrackedVector<uint8_t, MemoryTag::BoardGrid> mLoadingTiles;
+    uint32_t mLoadingTileCount{ 0 };
+    uint64_t mPlacementRevision{ 0 };
+    TrackedVector<sf::Vertex, MemoryTag::RenderCaches> mLoadingTileVertices;
+    LooseQuadtree mComponentIndex;
+    CircuitNetwork mNetwork;
+    BoardRecords mRecords;
+    sf::Vector2i mGrid;
+    float mGridSpacing;
+    PinLayout mPinLayout;
+};
\ No newline at end of file
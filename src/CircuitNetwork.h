@@ -0,0 +1,148 @@
+#pragma once
+
+#include "Component.h"
+#include "MemoryTracker.h"
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+// Electrical connectivity of the placed components, kept up to date as components and connections are
+// added. Every component pin gets a slot, numbered in placement order. Nets join slots through
+// connections, partitions also join the two terminals of every element, so a partition is a sub-network
+// that is electrically independent of the rest of the board. Both are union-find forests, lower slots
+// become the roots so the forests do not depend on the order of the merges.
+class CircuitNetwork
+{
+public:
+    void AddComponent(const Component& component)
+    {
+        std::optional<std::pair<uint32_t, uint32_t>> terminalPinIds;
+        std::optional<std::pair<uint32_t, uint32_t>> tiedPinIds;
+        if (component.GetElementKind() != ElementKind::None)
+        {
+            terminalPinIds = component.GetTerminalPinIds();
+            tiedPinIds = component.GetTiedPinIds();
+        }
+        AddComponent(static_cast<uint32_t>(component.GetComponentPins().size()), terminalPinIds, tiedPinIds);
+    }
+
+    // For networks kept apart from the board, terminalPinIds only for elements. The tied pins share the nets
+    // of the first and second terminal.
+    void AddComponent(uint32_t pinCount, std::optional<std::pair<uint32_t, uint32_t>> terminalPinIds,
+        std::optional<std::pair<uint32_t, uint32_t>> tiedPinIds = std::nullopt)
+    {
+        uint32_t firstSlot = static_cast<uint32_t>(mNetParents.size());
+        mFirstSlots.push_back(firstSlot);
+        for (uint32_t componentPinId = 0; componentPinId < pinCount; componentPinId++)
+        {
+            mNetParents.push_back(firstSlot + componentPinId);
+            mPartitionParents.push_back(firstSlot + componentPinId);
+        }
+
+        if (terminalPinIds.has_value())
+        {
+            Merge(mPartitionParents, firstSlot + terminalPinIds->first, firstSlot + terminalPinIds->second);
+        }
+
+        if (terminalPinIds.has_value() && tiedPinIds.has_value())
+        {
+            for (auto [terminalPinId, tiedPinId] : { std::make_pair(terminalPinIds->first, tiedPinIds->first), std::make_pair(terminalPinIds->second, tiedPinIds->second) })
+            {
+                Merge(mNetParents, firstSlot + terminalPinId, firstSlot + tiedPinId);
+                Merge(mPartitionParents, firstSlot + terminalPinId, firstSlot + tiedPinId);
+            }
+        }
+        mRevision++;
+    }
+
+    void AddConnection(uint32_t sourceComponentId, uint32_t sourcePinId, uint32_t targetComponentId, uint32_t targetPinId)
+    {
+        uint32_t sourceSlot = GetSlot(sourceComponentId, sourcePinId);
+        uint32_t targetSlot = GetSlot(targetComponentId, targetPinId);
+        Merge(mNetParents, sourceSlot, targetSlot);
+        Merge(mPartitionParents, sourceSlot, targetSlot);
+        mConnectionCount++;
+        mRevision++;
+    }
+
+    uint32_t GetSlot(uint32_t componentId, uint32_t componentPinId) const
+    {
+        return mFirstSlots[componentId] + componentPinId;
+    }
+
+    // Root slots, they stay valid until a later merge
+    uint32_t FindNet(uint32_t slot) { return Find(mNetParents, slot); }
+    uint32_t FindPartition(uint32_t slot) { return Find(mPartitionParents, slot); }
+
+    size_t GetSlotCount() const { return mNetParents.size(); }
+    size_t GetComponentCount() const { return mFirstSlots.size(); }
+    size_t GetConnectionCount() const { return mConnectionCount; }
+    uint64_t GetRevision() const { return mRevision; }
+
+    using Forest = TrackedVector<uint32_t, MemoryTag::Connectivity>;
+
+    // The raw forests, to save a network and restore it elsewhere
+    const TrackedVector<uint32_t, MemoryTag::Connectivity>& GetFirstSlots() const { return mFirstSlots; }
+    const Forest& GetNetParents() const { return mNetParents; }
+    const Forest& GetPartitionParents() const { return mPartitionParents; }
+
+    // False when they do not make a valid network, which is then left unchanged. Parents never lie above
+    // their children, so finding a root always ends.
+    bool Restore(TrackedVector<uint32_t, MemoryTag::Connectivity> firstSlots, Forest netParents, Forest partitionParents, size_t connectionCount)
+    {
+        size_t slotCount = netParents.size();
+        bool isValid = partitionParents.size() == slotCount;
+        for (size_t index = 0; isValid && index < firstSlots.size(); index++)
+        {
+            isValid = firstSlots[index] <= slotCount && (index == 0 ? firstSlots[index] == 0 : firstSlots[index] >= firstSlots[index - 1]);
+        }
+        for (size_t slot = 0; isValid && slot < slotCount; slot++)
+        {
+            isValid = netParents[slot] <= slot && partitionParents[slot] <= slot;
+        }
+        if (!isValid)
+        {
+            return false;
+        }
+
+        mFirstSlots = std::move(firstSlots);
+        mNetParents = std::move(netParents);
+        mPartitionParents = std::move(partitionParents);
+        mConnectionCount = connectionCount;
+        mRevision++;
+        return true;
+    }
+
+private:
+    static uint32_t Find(Forest& parents, uint32_t slot)
+    {
+        // Path halving
+        while (parents[slot] != slot)
+        {
+            parents[slot] = parents[parents[slot]];
+            slot = parents[slot];
+        }
+        return slot;
+    }
+
+    static void Merge(Forest& parents, uint32_t slot, uint32_t otherSlot)
+    {
+        uint32_t root = Find(parents, slot);
+        uint32_t otherRoot = Find(parents, otherSlot);
+        if (root < otherRoot)
+        {
+            parents[otherRoot] = root;
+        }
+        else if (otherRoot < root)
+        {
+            parents[root] = otherRoot;
+        }
+    }
+
+    TrackedVector<uint32_t, MemoryTag::Connectivity> mFirstSlots;  // Per component id
+    Forest mNetParents;
+    Forest mPartitionParents;
+    size_t mConnectionCount{ 0 };
+    uint64_t mRevision{ 0 };
+};
\ No newline at end of file
@@ -0,0 +1,684 @@
+#include "CircuitSolver.h"
+#include "CircuitBoard.h"
+#include "DenseCholesky.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+
+namespace
+{
+    constexpr uint32_t NoIndex = 0xFFFFFFFF;
+}
+
+CircuitSolver::CircuitSolver(JobSystem& jobSystem)
+    : mJobSystem(jobSystem)
+    , mScratches(jobSystem.GetThreadCount())
+{ }
+
+void CircuitSolver::Solve(CircuitBoard& circuitBoard)
+{
+    CircuitNetwork& network = circuitBoard.GetNetwork();
+    bool isRegroupNeeded = !mHasPartitions || network.GetRevision() != mNetworkRevision;
+    mMode = circuitBoard.GetSolverMode();
+    CollectElements(circuitBoard, mBoardElements);
+    Solve(mBoardElements, network.GetSlotCount(), isRegroupNeeded);
+    mNetworkRevision = network.GetRevision();
+}
+
+void CircuitSolver::Solve(const CircuitElements& elements, size_t slotCount, bool isRegroupNeeded)
+{
+    if (!mHasPartitions || isRegroupNeeded)
+    {
+        RegroupAll(elements, slotCount);
+    }
+
+    for (uint32_t partition = 0; partition < mPartitions.size(); partition++)
+    {
+        if (!mPartitions[partition].mIsChanged && mPartitions[partition].mElementCount > 0)
+        {
+            mPartitions[partition].mIsChanged = true;
+            mChangedPartitions.push_back(partition);
+        }
+    }
+    SolveChanged(elements);
+}
+
+void CircuitSolver::SolveChanged(const CircuitElements& elements)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    mSolveOrder.clear();
+    for (uint32_t partition : mChangedPartitions)
+    {
+        Partition& changedPartition = mPartitions[partition];
+        changedPartition.mIsChanged = false;
+        if (changedPartition.mElementCount > 0)
+        {
+            mSolvedCount -= changedPartition.mIsSolved ? 1 : 0;
+            changedPartition.mIsSolved = false;
+            mSolveOrder.push_back(partition);
+        }
+    }
+    mChangedPartitions.clear();
+    std::sort(mSolveOrder.begin(), mSolveOrder.end(), [this](uint32_t partition, uint32_t otherPartition)
+    {
+        return mPartitions[partition].mNetCount > mPartitions[otherPartition].mNetCount;
+    });
+
+    // One lane per thread so every lane keeps its own scratch, partitions are handed out largest first
+    std::atomic<size_t> nextPartition{ 0 };
+    mJobSystem.ParallelFor(mScratches.size(), [&](size_t lane)
+    {
+        for (size_t index = nextPartition++; index < mSolveOrder.size(); index = nextPartition++)
+        {
+            Partition& partition = mPartitions[mSolveOrder[index]];
+            partition.mIsSolved = SolvePartition(elements, partition, mScratches[lane]);
+        }
+    });
+
+    // The partitions the lanes skipped for their size lead the order
+    mStats.mIterativeCount = 0;
+    mStats.mIterations = 0;
+    for (size_t index = 0; mMode == SolverMode::Iterative && index < mSolveOrder.size(); index++)
+    {
+        Partition& partition = mPartitions[mSolveOrder[index]];
+        if (partition.mNetCount <= mDenseNetLimit)
+        {
+            break;
+        }
+        partition.mIsSolved = SolveIterative(elements, partition);
+        mStats.mIterativeCount += partition.mIsSolved ? 1 : 0;
+    }
+
+    for (uint32_t partition : mSolveOrder)
+    {
+        mSolvedCount += mPartitions[partition].mIsSolved ? 1 : 0;
+    }
+
+    mStats.mPartitionCount = mPartitionCount;
+    mStats.mSolvedCount = mSolvedCount;
+    mStats.mSkippedCount = mPartitionCount - mSolvedCount;
+    mStats.mMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void CircuitSolver::CollectElements(CircuitBoard& circuitBoard, CircuitElements& outElements)
+{
+    CircuitNetwork& network = circuitBoard.GetNetwork();
+    outElements.clear();
+    for (uint32_t componentId = 0; componentId < circuitBoard.GetComponentCount(); componentId++)
+    {
+        const Component& component = circuitBoard.GetComponent(componentId);
+        if (component.GetElementKind() == ElementKind::None)
+        {
+            continue;
+        }
+
+        auto [firstPinId, secondPinId] = component.GetTerminalPinIds();
+        uint32_t firstSlot = network.GetSlot(componentId, firstPinId);
+        uint32_t secondSlot = network.GetSlot(componentId, secondPinId);
+        outElements.push_back({
+            component.GetElementKind(), component.GetValue(),
+            { network.FindNet(firstSlot), network.FindNet(secondSlot) }, network.FindPartition(firstSlot)
+        });
+    }
+}
+
+void CircuitSolver::Reset()
+{
+    mHasPartitions = false;
+    mNetVoltages.clear();
+    mNetPartitions.clear();
+    mNetIndices.clear();
+    mPartitions.clear();
+    mChangedPartitions.clear();
+    mPartitionCount = 0;
+    mSolvedCount = 0;
+    mStats = CircuitSolveStats();
+}
+
+void CircuitSolver::Regroup(CircuitElements& elements, const TrackedVector<uint32_t, MemoryTag::Solver>& elementSlots, CircuitNetwork& network,
+    const std::vector<uint32_t>& touchedPartitions, size_t firstNewElement)
+{
+    size_t slotCount = network.GetSlotCount();
+    mNetVoltages.resize(slotCount, 0.0);
+    mNetPartitions.resize(slotCount, NoIndex);
+    mNetIndices.resize(slotCount, NoIndex);
+
+    // The elements of the merged partitions, those of partitions without elements and of retired ones were
+    // taken already or never existed. Only retired partitions are left at slots that stopped being roots.
+    mRegroupElements.clear();
+    for (uint32_t root : touchedPartitions)
+    {
+        uint32_t partitionIndex = mNetPartitions[root];
+        if (partitionIndex == NoIndex || mPartitions[partitionIndex].mElementCount == 0)
+        {
+            continue;
+        }
+
+        Partition& partition = mPartitions[partitionIndex];
+        mRegroupElements.insert(mRegroupElements.end(), &mElements[partition.mFirstElement], &mElements[partition.mFirstElement] + partition.mElementCount);
+        mRetiredElementCount += partition.mElementCount;
+        mSolvedCount -= partition.mIsSolved ? 1 : 0;
+        mPartitionCount--;
+        partition.mElementCount = 0;
+        partition.mIsSolved = false;
+    }
+
+    for (size_t elementIndex = firstNewElement; elementIndex < elements.size(); elementIndex++)
+    {
+        mRegroupElements.push_back(static_cast<uint32_t>(elementIndex));
+    }
+
+    for (uint32_t elementIndex : mRegroupElements)
+    {
+        CircuitElement& element = elements[elementIndex];
+        element.mNets[0] = network.FindNet(elementSlots[2 * elementIndex]);
+        element.mNets[1] = network.FindNet(elementSlots[2 * elementIndex + 1]);
+        element.mPartition = network.FindPartition(elementSlots[2 * elementIndex]);
+    }
+
+    // Retired partitions are dropped once they held more elements than the live ones hold
+    if (mRetiredElementCount > elements.size())
+    {
+        RegroupAll(elements, slotCount);
+        return;
+    }
+
+    // Element order, as in a full regroup
+    std::sort(mRegroupElements.begin(), mRegroupElements.end());
+    AppendPartitions(elements);
+}
+
+void CircuitSolver::MarkChanged(const CircuitElement& element)
+{
+    uint32_t partitionIndex = element.mPartition < mNetPartitions.size() ? mNetPartitions[element.mPartition] : NoIndex;
+    if (partitionIndex != NoIndex && !mPartitions[partitionIndex].mIsChanged)
+    {
+        mPartitions[partitionIndex].mIsChanged = true;
+        mChangedPartitions.push_back(partitionIndex);
+    }
+}
+
+std::optional<double> CircuitSolver::GetNetVoltage(uint32_t netSlot) const
+{
+    if (netSlot >= mNetPartitions.size() || mNetPartitions[netSlot] == NoIndex || !mPartitions[mNetPartitions[netSlot]].mIsSolved)
+    {
+        return std::nullopt;
+    }
+    return mNetVoltages[netSlot];
+}
+
+// Both terminals are in the partition of the element
+std::optional<double> CircuitSolver::GetElementVoltage(const CircuitElement& element) const
+{
+    std::optional<double> voltage = GetNetVoltage(element.mNets[0]);
+    if (!voltage.has_value())
+    {
+        return std::nullopt;
+    }
+    return voltage.value() - mNetVoltages[element.mNets[1]];
+}
+
+std::optional<double> CircuitSolver::GetVoltage(CircuitBoard& circuitBoard, uint32_t componentId, uint32_t componentPinId) const
+{
+    CircuitNetwork& network = circuitBoard.GetNetwork();
+    return GetNetVoltage(network.FindNet(network.GetSlot(componentId, componentPinId)));
+}
+
+void CircuitSolver::RegroupAll(const CircuitElements& elements, size_t slotCount)
+{
+    mPartitions.clear();
+    mElements.clear();
+    mTerminalNets.clear();
+    mNets.clear();
+    mChangedPartitions.clear();
+    mNetPartitions.assign(slotCount, NoIndex);
+    mNetIndices.assign(slotCount, NoIndex);
+    mNetVoltages.assign(slotCount, 0.0);
+    mPartitionCount = 0;
+    mSolvedCount = 0;
+    mRetiredElementCount = 0;
+    mStats.mLargestPartition = 0;
+
+    mRegroupElements.resize(elements.size());
+    std::iota(mRegroupElements.begin(), mRegroupElements.end(), 0);
+    AppendPartitions(elements);
+    mHasPartitions = true;
+}
+
+// Partitions are numbered in order of their first element, the first terminal of that element is ground
+void CircuitSolver::AppendPartitions(const CircuitElements& elements)
+{
+    // Count the elements of each partition, partitions retired by this regroup may still sit at their roots
+    uint32_t firstPartition = static_cast<uint32_t>(mPartitions.size());
+    for (uint32_t elementIndex : mRegroupElements)
+    {
+        uint32_t& partitionIndex = mNetPartitions[elements[elementIndex].mPartition];
+        if (partitionIndex == NoIndex || partitionIndex < firstPartition)
+        {
+            partitionIndex = static_cast<uint32_t>(mPartitions.size());
+            mPartitions.push_back({ 0, 0, 0, 0, true, false });
+            mChangedPartitions.push_back(partitionIndex);
+        }
+        mPartitions[partitionIndex].mElementCount++;
+    }
+
+    uint32_t position = static_cast<uint32_t>(mElements.size());
+    for (uint32_t partitionIndex = firstPartition; partitionIndex < mPartitions.size(); partitionIndex++)
+    {
+        mPartitions[partitionIndex].mFirstElement = position;
+        position += mPartitions[partitionIndex].mElementCount;
+        mPartitions[partitionIndex].mElementCount = 0;
+    }
+
+    mElements.resize(position);
+    mTerminalNets.resize(2 * position);
+    for (uint32_t elementIndex : mRegroupElements)
+    {
+        Partition& partition = mPartitions[mNetPartitions[elements[elementIndex].mPartition]];
+        mElements[partition.mFirstElement + partition.mElementCount++] = elementIndex;
+    }
+
+    // Number the nets within each partition
+    for (uint32_t partitionIndex = firstPartition; partitionIndex < mPartitions.size(); partitionIndex++)
+    {
+        Partition& partition = mPartitions[partitionIndex];
+        partition.mFirstNet = static_cast<uint32_t>(mNets.size());
+        for (uint32_t elementPosition = partition.mFirstElement; elementPosition < partition.mFirstElement + partition.mElementCount; elementPosition++)
+        {
+            const CircuitElement& element = elements[mElements[elementPosition]];
+            for (uint32_t terminal = 0; terminal < 2; terminal++)
+            {
+                uint32_t root = element.mNets[terminal];
+                if (mNetIndices[root] == NoIndex)
+                {
+                    mNetIndices[root] = static_cast<uint32_t>(mNets.size()) - partition.mFirstNet;
+                    mNetPartitions[root] = partitionIndex;
+                    mNets.push_back(root);
+                }
+                mTerminalNets[2 * elementPosition + terminal] = mNetIndices[root];
+            }
+        }
+        partition.mNetCount = static_cast<uint32_t>(mNets.size()) - partition.mFirstNet;
+
+        for (uint32_t net = partition.mFirstNet; net < mNets.size(); net++)
+        {
+            mNetIndices[mNets[net]] = NoIndex;
+        }
+        mStats.mLargestPartition = std::max<size_t>(mStats.mLargestPartition, partition.mNetCount);
+    }
+
+    mPartitionCount += mPartitions.size() - firstPartition;
+    mStats.mPartitionCount = mPartitionCount;
+}
+
+bool CircuitSolver::SolvePartition(const CircuitElements& elements, const Partition& partition, Scratch& scratch)
+{
+    size_t netCount = partition.mNetCount;
+    if (netCount > mDenseNetLimit)
+    {
+        return false;
+    }
+
+    // Ground is not an unknown, row and column k stand for net k + 1
+    size_t size = netCount - 1;
+    std::vector<double>& matrix = scratch.mMatrix;
+    std::vector<double>& rightHandSide = scratch.mRightHandSide;
+    matrix.assign(size * size, 0.0);
+    rightHandSide.assign(size, 0.0);
+    for (size_t row = 0; row < size; row++)
+    {
+        matrix[row * size + row] = GroundConductance;
+    }
+
+    auto stampConductance = [&](uint32_t net, uint32_t otherNet, double conductance)
+    {
+        if (net > 0)
+        {
+            matrix[(net - 1) * size + (net - 1)] += conductance;
+        }
+        if (otherNet > 0)
+        {
+            matrix[(otherNet - 1) * size + (otherNet - 1)] += conductance;
+        }
+        if (net > 0 && otherNet > 0)
+        {
+            matrix[(net - 1) * size + (otherNet - 1)] -= conductance;
+            matrix[(otherNet - 1) * size + (net - 1)] -= conductance;
+        }
+    };
+
+    // Current flowing into the net
+    auto stampCurrent = [&](uint32_t net, double current)
+    {
+        if (net > 0)
+        {
+            rightHandSide[net - 1] += current;
+        }
+    };
+
+    for (uint32_t position = partition.mFirstElement; position < partition.mFirstElement + partition.mElementCount; position++)
+    {
+        const CircuitElement& element = elements[mElements[position]];
+        uint32_t net = mTerminalNets[2 * position];
+        uint32_t otherNet = mTerminalNets[2 * position + 1];
+        double value = element.mValue;
+
+        switch (element.mKind)
+        {
+            case ElementKind::Resistor:
+            case ElementKind::Lamp:
+                stampConductance(net, otherNet, 1.0 / std::max(value, MinResistance));
+                break;
+            case ElementKind::VoltageSource:
+                stampConductance(net, otherNet, 1.0 / VoltageSourceResistance);
+                stampCurrent(net, value / VoltageSourceResistance);
+                stampCurrent(otherNet, -value / VoltageSourceResistance);
+                break;
+            case ElementKind::CurrentSource:
+                stampCurrent(net, -value);
+                stampCurrent(otherNet, value);
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (!SolveDenseCholesky(size, matrix, rightHandSide))
+    {
+        return false;
+    }
+
+    const uint32_t* nets = &mNets[partition.mFirstNet];
+    mNetVoltages[nets[0]] = 0.0;
+    for (size_t row = 0; row < size; row++)
+    {
+        mNetVoltages[nets[row + 1]] = rightHandSide[row];
+    }
+    return true;
+}
+
+bool CircuitSolver::SolveIterative(const CircuitElements& elements, const Partition& partition)
+{
+    size_t size = partition.mNetCount - 1;
+    BuildIncidences(elements, partition);
+
+    IterativeScratch& scratch = mIterative;
+    size_t threadCount = mJobSystem.GetThreadCount();
+    scratch.mBlockSize = mIsDeterministic ? IterativeBlockSize : std::max(IterativeBlockSize, (size + threadCount - 1) / threadCount);
+    scratch.mSolution.assign(size, 0.0);
+    scratch.mResidual.assign(scratch.mRightHandSide.begin(), scratch.mRightHandSide.end());
+    scratch.mPreconditioned.resize(size);
+    scratch.mDirection.resize(size);
+    scratch.mProduct.resize(size);
+
+    double rightHandSideNorm = std::sqrt(SumBlocks(size, [&](size_t begin, size_t end)
+    {
+        double sum = 0.0;
+        for (size_t net = begin; net < end; net++)
+        {
+            sum += scratch.mRightHandSide[net] * scratch.mRightHandSide[net];
+        }
+        return sum;
+    }));
+
+    double residualDotPreconditioned = SumBlocks(size, [&](size_t begin, size_t end)
+    {
+        Precondition(begin, end);
+        double sum = 0.0;
+        for (size_t net = begin; net < end; net++)
+        {
+            scratch.mDirection[net] = scratch.mPreconditioned[net];
+            sum += scratch.mResidual[net] * scratch.mPreconditioned[net];
+        }
+        return sum;
+    });
+
+    bool isConverged = rightHandSideNorm == 0.0;
+    for (size_t iteration = 0; !isConverged && iteration < MaxIterations; iteration++)
+    {
+        double directionDotProduct = SumBlocks(size, [&](size_t begin, size_t end)
+        {
+            ApplyOperator(begin, end);
+            double sum = 0.0;
+            for (size_t net = begin; net < end; net++)
+            {
+                sum += scratch.mDirection[net] * scratch.mProduct[net];
+            }
+            return sum;
+        });
+        if (!(directionDotProduct > 0.0))
+        {
+            break;
+        }
+
+        double step = residualDotPreconditioned / directionDotProduct;
+        double residualNorm = std::sqrt(SumBlocks(size, [&](size_t begin, size_t end)
+        {
+            double sum = 0.0;
+            for (size_t net = begin; net < end; net++)
+            {
+                scratch.mSolution[net] += step * scratch.mDirection[net];
+                scratch.mResidual[net] -= step * scratch.mProduct[net];
+                sum += scratch.mResidual[net] * scratch.mResidual[net];
+            }
+            return sum;
+        }));
+        mStats.mIterations++;
+
+        isConverged = residualNorm <= IterativeTolerance * rightHandSideNorm;
+        if (isConverged)
+        {
+            break;
+        }
+
+        double nextResidualDotPreconditioned = SumBlocks(size, [&](size_t begin, size_t end)
+        {
+            Precondition(begin, end);
+            double sum = 0.0;
+            for (size_t net = begin; net < end; net++)
+            {
+                sum += scratch.mResidual[net] * scratch.mPreconditioned[net];
+            }
+            return sum;
+        });
+
+        double scale = nextResidualDotPreconditioned / residualDotPreconditioned;
+        residualDotPreconditioned = nextResidualDotPreconditioned;
+        SumBlocks(size, [&](size_t begin, size_t end)
+        {
+            for (size_t net = begin; net < end; net++)
+            {
+                scratch.mDirection[net] = scratch.mPreconditioned[net] + scale * scratch.mDirection[net];
+            }
+            return 0.0;
+        });
+    }
+
+    if (!isConverged)
+    {
+        return false;
+    }
+
+    const uint32_t* nets = &mNets[partition.mFirstNet];
+    mNetVoltages[nets[0]] = 0.0;
+    for (size_t net = 0; net < size; net++)
+    {
+        mNetVoltages[nets[net + 1]] = scratch.mSolution[net];
+    }
+    return true;
+}
+
+// Stamps the partition the way SolvePartition does, but keeps the conductances per element and the
+// elements per net instead of filling a matrix. Unknown k stands for net k + 1, as in the dense solver.
+void CircuitSolver::BuildIncidences(const CircuitElements& elements, const Partition& partition)
+{
+    IterativeScratch& scratch = mIterative;
+    size_t size = partition.mNetCount - 1;
+    uint32_t firstPosition = partition.mFirstElement;
+    uint32_t elementCount = partition.mElementCount;
+
+    scratch.mConductances.assign(elementCount, 0.0);
+    scratch.mDiagonal.assign(size, GroundConductance);
+    scratch.mRightHandSide.assign(size, 0.0);
+    scratch.mFirstIncidences.assign(size + 1, 0);
+
+    auto stampCurrent = [&](uint32_t net, double current)
+    {
+        if (net > 0)
+        {
+            scratch.mRightHandSide[net - 1] += current;
+        }
+    };
+
+    for (uint32_t element = 0; element < elementCount; element++)
+    {
+        uint32_t position = firstPosition + element;
+        const CircuitElement& circuitElement = elements[mElements[position]];
+        uint32_t net = mTerminalNets[2 * position];
+        uint32_t otherNet = mTerminalNets[2 * position + 1];
+        double value = circuitElement.mValue;
+        double conductance = 0.0;
+
+        switch (circuitElement.mKind)
+        {
+            case ElementKind::Resistor:
+            case ElementKind::Lamp:
+                conductance = 1.0 / std::max(value, MinResistance);
+                break;
+            case ElementKind::VoltageSource:
+                conductance = 1.0 / VoltageSourceResistance;
+                stampCurrent(net, value / VoltageSourceResistance);
+                stampCurrent(otherNet, -value / VoltageSourceResistance);
+                break;
+            case ElementKind::CurrentSource:
+                stampCurrent(net, -value);
+                stampCurrent(otherNet, value);
+                break;
+            default:
+                break;
+        }
+
+        // An element between a net and itself cancels out
+        if (conductance == 0.0 || net == otherNet)
+        {
+            continue;
+        }
+
+        scratch.mConductances[element] = conductance;
+        if (net > 0)
+        {
+            scratch.mDiagonal[net - 1] += conductance;
+        }
+        if (otherNet > 0)
+        {
+            scratch.mDiagonal[otherNet - 1] += conductance;
+        }
+        if (net > 0 && otherNet > 0)
+        {
+            scratch.mFirstIncidences[net]++;
+            scratch.mFirstIncidences[otherNet]++;
+        }
+    }
+
+    // Every count sits after its net, so the sums start the lists. Filling moves each start to the start of
+    // the next list, shifting them back restores them.
+    for (size_t net = 0; net < size; net++)
+    {
+        scratch.mFirstIncidences[net + 1] += scratch.mFirstIncidences[net];
+    }
+    scratch.mIncidences.resize(scratch.mFirstIncidences[size]);
+
+    for (uint32_t element = 0; element < elementCount; element++)
+    {
+        uint32_t position = firstPosition + element;
+        uint32_t net = mTerminalNets[2 * position];
+        uint32_t otherNet = mTerminalNets[2 * position + 1];
+        if (scratch.mConductances[element] != 0.0 && net > 0 && otherNet > 0)
+        {
+            scratch.mIncidences[scratch.mFirstIncidences[net - 1]++] = { otherNet - 1, element };
+            scratch.mIncidences[scratch.mFirstIncidences[otherNet - 1]++] = { net - 1, element };
+        }
+    }
+
+    for (size_t net = size; net > 0; net--)
+    {
+        scratch.mFirstIncidences[net] = scratch.mFirstIncidences[net - 1];
+    }
+    scratch.mFirstIncidences[0] = 0;
+}
+
+// Product of the nodal matrix and the search direction, for the unknowns in [begin, end)
+void CircuitSolver::ApplyOperator(size_t begin, size_t end)
+{
+    IterativeScratch& scratch = mIterative;
+    for (size_t net = begin; net < end; net++)
+    {
+        double value = scratch.mDiagonal[net] * scratch.mDirection[net];
+        for (uint32_t index = scratch.mFirstIncidences[net]; index < scratch.mFirstIncidences[net + 1]; index++)
+        {
+            const Incidence& incidence = scratch.mIncidences[index];
+            value -= scratch.mConductances[incidence.mElement] * scratch.mDirection[incidence.mNet];
+        }
+        scratch.mProduct[net] = value;
+    }
+}
+
+// One forward and one backward Gauss-Seidel sweep on the residual, over the block [begin, end) alone. The
+// couplings to other blocks are left out, which keeps the preconditioner symmetric and the blocks independent.
+void CircuitSolver::Precondition(size_t begin, size_t end)
+{
+    IterativeScratch& scratch = mIterative;
+    for (size_t net = begin; net < end; net++)
+    {
+        double value = scratch.mResidual[net];
+        for (uint32_t index = scratch.mFirstIncidences[net]; index < scratch.mFirstIncidences[net + 1]; index++)
+        {
+            const Incidence& incidence = scratch.mIncidences[index];
+            if (incidence.mNet >= begin && incidence.mNet < net)
+            {
+                value += scratch.mConductances[incidence.mElement] * scratch.mPreconditioned[incidence.mNet];
+            }
+        }
+        scratch.mPreconditioned[net] = value / scratch.mDiagonal[net];
+    }
+
+    for (size_t net = end; net-- > begin;)
+    {
+        double value = 0.0;
+        for (uint32_t index = scratch.mFirstIncidences[net]; index < scratch.mFirstIncidences[net + 1]; index++)
+        {
+            const Incidence& incidence = scratch.mIncidences[index];
+            if (incidence.mNet > net && incidence.mNet < end)
+            {
+                value += scratch.mConductances[incidence.mElement] * scratch.mPreconditioned[incidence.mNet];
+            }
+        }
+        scratch.mPreconditioned[net] += value / scratch.mDiagonal[net];
+    }
+}
+
+// Runs the function on every block of unknowns on the job system and adds up what it returns in block
+// order, so the sum does not depend on which thread ran which block
+double CircuitSolver::SumBlocks(size_t size, const std::function<double(size_t, size_t)>& function)
+{
+    size_t blockSize = mIterative.mBlockSize;
+    size_t blockCount = (size + blockSize - 1) / blockSize;
+    mIterative.mBlockSums.resize(blockCount);
+    mJobSystem.ParallelFor(blockCount, [&](size_t block)
+    {
+        size_t begin = block * blockSize;
+        mIterative.mBlockSums[block] = function(begin, std::min(begin + blockSize, size));
+    });
+
+    double sum = 0.0;
+    for (double blockSum : mIterative.mBlockSums)
+    {
+        sum += blockSum;
+    }
+    return sum;
+}
\ No newline at end of file
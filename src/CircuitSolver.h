@@ -0,0 +1,194 @@
+#pragma once
+
+#include "CircuitNetwork.h"
+#include "Component.h"
+#include "MemoryTracker.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+class CircuitBoard;
+class JobSystem;
+
+// An element as the solver sees it, detached from the board so it can be solved on another thread
+struct CircuitElement
+{
+    ElementKind mKind;
+    double mValue;
+    uint32_t mNets[2];    // Root slots of the nets of the first and second terminal
+    uint32_t mPartition;  // Root slot of the partition
+};
+
+using CircuitElements = TrackedVector<CircuitElement, MemoryTag::Solver>;
+
+// How partitions too large for the dense solver are handled
+enum class SolverMode : uint8_t
+{
+    Dense,     // Skipped
+    Iterative  // Preconditioned conjugate gradient, memory linear in their nets and elements
+};
+
+struct CircuitSolveStats
+{
+    size_t mPartitionCount{ 0 };
+    size_t mSolvedCount{ 0 };
+    size_t mSkippedCount{ 0 };     // Partitions too large for the dense solver, or that did not converge
+    size_t mIterativeCount{ 0 };   // Partitions solved iteratively
+    size_t mIterations{ 0 };       // Summed over the partitions solved iteratively
+    size_t mLargestPartition{ 0 }; // Nets
+    double mMilliseconds{ 0 };
+};
+
+// DC operating point of the board, solved by nodal analysis per partition (see CircuitNetwork) on the job
+// system, so solve time follows the largest partition. Every partition is grounded at the first terminal of
+// its first element.
+// Voltage sources are Norton equivalents with a small source resistance, which keeps the system
+// symmetric positive definite, and every net has a tiny conductance to ground so floating nets solve.
+// Lamps are solved as resistors of their value, a transient run keeps that value at the hot resistance.
+// In iterative mode the partitions too large to factor are solved one after the other by conjugate gradient,
+// each spread over the job system. The operator is applied from the element conductances through per-net
+// incidence lists, no matrix is assembled, and the preconditioner is a symmetric Gauss-Seidel sweep over
+// blocks of nets. Sums over the blocks go in block order. By default there is a block per thread, the larger
+// blocks precondition better, so the last bits of the result vary with the thread count but not from run to
+// run. Deterministic solves use blocks of a fixed size, which makes them bitwise reproducible on any thread
+// count, for golden file tests and resumed checkpoints. Dense partitions are assembled and factored on one
+// thread each and are reproducible either way.
+class CircuitSolver
+{
+public:
+    explicit CircuitSolver(JobSystem& jobSystem);
+
+    // Partitions are regrouped only after the topology changed, element values are read on every solve
+    void Solve(CircuitBoard& circuitBoard);
+
+    // Solves elements collected earlier, slotCount is the slot count of the network they were collected
+    // from. Regrouping is needed whenever the elements are not the ones of the previous solve.
+    void Solve(const CircuitElements& elements, size_t slotCount, bool isRegroupNeeded);
+
+    // For elements edited a few at a time, like those of a simulation, after a first full Solve. Regroups
+    // only the partitions edits of the network merged: touchedPartitions are their root slots from before the
+    // edits, and the elements from firstNewElement on are new. The nets of the elements in them are looked
+    // up again from elementSlots, two per element. The partitions are left as a full regroup makes them.
+    void Regroup(CircuitElements& elements, const TrackedVector<uint32_t, MemoryTag::Solver>& elementSlots, CircuitNetwork& network,
+        const std::vector<uint32_t>& touchedPartitions, size_t firstNewElement);
+
+    // The partition of the element is solved again by the next SolveChanged
+    void MarkChanged(const CircuitElement& element);
+
+    // Solves the partitions regrouped or marked changed since their last solve, the others keep their
+    // voltages, which solving them again would reproduce bit for bit
+    void SolveChanged(const CircuitElements& elements);
+
+    static void CollectElements(CircuitBoard& circuitBoard, CircuitElements& outElements);
+
+    // Forgets the partitions, for when the solver moves to another board
+    void Reset();
+
+    // Solve(CircuitBoard&) takes the mode of the board
+    void SetMode(SolverMode mode) { mMode = mode; }
+    SolverMode GetMode() const { return mMode; }
+
+    void SetDeterministic(bool isDeterministic) { mIsDeterministic = isDeterministic; }
+    bool IsDeterministic() const { return mIsDeterministic; }
+
+    // Partitions with more nets are too large to factor, lowered to check the iterative solver against the
+    // dense one on small boards. At most MaxDenseNets.
+    void SetDenseNetLimit(size_t netCount) { mDenseNetLimit = netCount < MaxDenseNets ? netCount : MaxDenseNets; }
+
+    // Volts against the ground of the partition, none for nets whose partition was skipped or failed
+    std::optional<double> GetNetVoltage(uint32_t netSlot) const;
+    std::optional<double> GetElementVoltage(const CircuitElement& element) const;  // First terminal against second
+    std::optional<double> GetVoltage(CircuitBoard& circuitBoard, uint32_t componentId, uint32_t componentPinId) const;
+    const TrackedVector<double, MemoryTag::Solver>& GetNetVoltages() const { return mNetVoltages; }  // Stale where not solved
+
+    const CircuitSolveStats& GetStats() const { return mStats; }
+
+    static constexpr double VoltageSourceResistance = 1e-3;
+    static constexpr double MinResistance = 1e-6;
+    static constexpr double GroundConductance = 1e-12;
+    static constexpr size_t MaxDenseNets = 2048;  // 32 MB of matrix per thread
+    static constexpr double IterativeTolerance = 1e-10;  // Residual norm relative to that of the right hand side
+    static constexpr size_t MaxIterations = 10000;
+    static constexpr size_t IterativeBlockSize = 4096;   // Nets per preconditioner block, the least when not deterministic
+
+private:
+    struct Scratch
+    {
+        std::vector<double> mMatrix;
+        std::vector<double> mRightHandSide;
+    };
+
+    // The partition's nets but ground, each with the other net and the element of every incident element
+    struct Incidence
+    {
+        uint32_t mNet;      // Ground never appears
+        uint32_t mElement;  // Index into mConductances
+    };
+
+    struct IterativeScratch
+    {
+        TrackedVector<uint32_t, MemoryTag::Solver> mFirstIncidences;
+        TrackedVector<Incidence, MemoryTag::Solver> mIncidences;
+        TrackedVector<double, MemoryTag::Solver> mConductances;  // Per element of the partition
+        TrackedVector<double, MemoryTag::Solver> mDiagonal;
+        TrackedVector<double, MemoryTag::Solver> mRightHandSide;
+        TrackedVector<double, MemoryTag::Solver> mSolution;
+        TrackedVector<double, MemoryTag::Solver> mResidual;
+        TrackedVector<double, MemoryTag::Solver> mPreconditioned;
+        TrackedVector<double, MemoryTag::Solver> mDirection;
+        TrackedVector<double, MemoryTag::Solver> mProduct;
+        TrackedVector<double, MemoryTag::Solver> mBlockSums;  // Per block
+        size_t mBlockSize{ IterativeBlockSize };
+    };
+
+    // Nets and elements of a partition are stored back to back, in mNets and in mElements and mTerminalNets.
+    // A regroup retires the partitions it merges in place and appends the merged ones.
+    struct Partition
+    {
+        uint32_t mFirstElement;
+        uint32_t mElementCount;  // Zero once retired
+        uint32_t mFirstNet;      // Ground first
+        uint32_t mNetCount;
+        bool mIsChanged;         // Listed in mChangedPartitions
+        bool mIsSolved;
+    };
+
+    void RegroupAll(const CircuitElements& elements, size_t slotCount);
+    void AppendPartitions(const CircuitElements& elements);  // Of the elements in mRegroupElements
+    bool SolvePartition(const CircuitElements& elements, const Partition& partition, Scratch& scratch);
+    bool SolveIterative(const CircuitElements& elements, const Partition& partition);
+    void BuildIncidences(const CircuitElements& elements, const Partition& partition);
+    void ApplyOperator(size_t begin, size_t end);
+    void Precondition(size_t begin, size_t end);
+    double SumBlocks(size_t size, const std::function<double(size_t, size_t)>& function);
+
+    JobSystem& mJobSystem;
+    std::vector<Scratch> mScratches;  // Per thread
+    IterativeScratch mIterative;
+    SolverMode mMode{ SolverMode::Dense };
+    bool mIsDeterministic{ false };
+    size_t mDenseNetLimit{ MaxDenseNets };
+    uint64_t mNetworkRevision{ 0 };
+    bool mHasPartitions{ false };
+
+    CircuitElements mBoardElements;
+
+    TrackedVector<Partition, MemoryTag::Solver> mPartitions;
+    TrackedVector<uint32_t, MemoryTag::Solver> mElements;      // Indices into the elements
+    TrackedVector<uint32_t, MemoryTag::Solver> mTerminalNets;  // Per element, its terminal nets within the partition
+    TrackedVector<uint32_t, MemoryTag::Solver> mNets;          // Root slots
+    TrackedVector<uint32_t, MemoryTag::Solver> mNetPartitions; // Per slot, set on the root slots of partition nets
+    TrackedVector<uint32_t, MemoryTag::Solver> mNetIndices;    // Per slot, NoIndex but while numbering nets
+    TrackedVector<uint32_t, MemoryTag::Solver> mChangedPartitions;
+    TrackedVector<uint32_t, MemoryTag::Solver> mSolveOrder;    // Largest first
+    TrackedVector<uint32_t, MemoryTag::Solver> mRegroupElements;
+    size_t mPartitionCount{ 0 };  // Not retired
+    size_t mSolvedCount{ 0 };
+    size_t mRetiredElementCount{ 0 };
+
+    TrackedVector<double, MemoryTag::Solver> mNetVoltages;  // Per slot, set on root slots
+    CircuitSolveStats mStats;
+};
\ No newline at end of file
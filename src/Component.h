@@ -1,8 +1,13 @@
 #pragma once
 
+#include "BoardFormat.h"
 #include "DrawUtils.h"
 #include "Interfaces.h"
+#include "MemoryTracker.h"
+#include "OccupancyBitmap.h"
 
+#include <algorithm>
+#include <limits>
 
 class Component;
 class Connection;
@@ -27,11 +32,12 @@ public:
     sf::Vector2f mPosition;
 };
 
-class Connector
+class Connector : public TrackedObject<MemoryTag::Connectivity>
 {
 public:
-    Connector(Component* component)
+    Connector(Component* component, uint32_t componentPinId)
         : mComponent(component)
+        , mComponentPinId(componentPinId)
     { }
 
     const sf::Vector2f& GetPosition() const { return mPosition; }
@@ -41,16 +47,18 @@ public:
         mConnections.emplace_back(connection);
     }    
 
-    std::vector<std::shared_ptr<Connection>>& GetConnections()
+    TrackedVector<std::shared_ptr<Connection>, MemoryTag::Connectivity>& GetConnections()
     {
         return mConnections;
     }    
 
     Component* GetComponent() { return mComponent; }
+    uint32_t GetComponentPinId() const { return mComponentPinId; }
 
 private:
     Component* mComponent;
-    std::vector<std::shared_ptr<Connection>> mConnections;    
+    uint32_t mComponentPinId;
+    TrackedVector<std::shared_ptr<Connection>, MemoryTag::Connectivity> mConnections;    
     sf::Vector2f mPosition;
 };
 
@@ -95,14 +103,16 @@ public:
             Connector* sourceConnector = connectorPair.first;
             Connector* targetConnector = connectorPair.second;
 
-            auto connection = std::make_shared<Connection>(sourceConnector, targetConnector);
+            auto connection = std::allocate_shared<Connection>(TrackedAllocator<Connection, MemoryTag::Connectivity>(), sourceConnector, targetConnector);
             sourceConnector->AddConnection(connection);
             targetConnector->AddConnection(connection);
         }
     }
 
-    void SetIsPlaceable(bool value) { mIsPlaceable = false; }
+    void SetIsPlaceable(bool value) { mIsPlaceable = value; }
     bool IsPlaceable() { return mIsPlaceable; }
+    size_t GetConnectorPairCount() const { return mConnectorPairs.size(); }
+    const TrackedVector<std::pair<Connector*, Connector*>, MemoryTag::Connectivity>& GetConnectorPairs() const { return mConnectorPairs; }
     
     void AddConnectorPair(Connector* sourceConnector, Connector* targetConnector) 
     { 
@@ -117,7 +127,7 @@ public:
 
 private:
     bool mIsPlaceable;
-    std::vector<std::pair<Connector*, Connector*>> mConnectorPairs;    
+    TrackedVector<std::pair<Connector*, Connector*>, MemoryTag::Connectivity> mConnectorPairs;    
 };
 
 class Pin
@@ -127,7 +137,7 @@ public:
         : mId(id)
     { }
 
-    uint32_t GetId() { return mId; }
+    uint32_t GetId() const { return mId; }
 
 private:
     uint32_t mId;
@@ -143,8 +153,8 @@ public:
     { }
 
     // Getters
-    Pin* GetTemporaryConnectionPin() { return mTemporaryConnectionPin; }
-    bool IsConnectable() { return mIsConnectable; }
+    Pin* GetTemporaryConnectionPin() const { return mTemporaryConnectionPin; }
+    bool IsConnectable() const { return mIsConnectable; }
 
     // Setters
     void SetTemporaryConnectionPin(Pin* pin) { mTemporaryConnectionPin = pin; }
@@ -155,7 +165,17 @@ private:
     bool mIsConnectable;
 };
 
-class Component
+// How a component behaves between its two terminal pins
+enum class ElementKind
+{
+    None,
+    Resistor,       // Value in ohms
+    Lamp,           // Value in ohms when cold, the filament heats up as current flows and its resistance rises
+    VoltageSource,  // Value in volts, the first terminal is positive
+    CurrentSource   // Value in amperes, flowing from the first terminal through the source to the second
+};
+
+class Component : public TrackedObject<MemoryTag::Components>
 {
 public:
     Component() = default;
@@ -175,81 +195,169 @@ public:
         {
             return nullptr;
         }
-        
-        sf::Vector2f position = mNavigator->GetGridCoordinateFromPin(mNavigator->GetSelectedPin());
-        Node node(this, position);
-        mNodes.push_back(node);
-
-        mSelectedNode = &mNodes[mNodes.size() - 1];
-        return mSelectedNode;
+        return AddNode(mNavigator->GetGridCoordinateFromPin(mNavigator->GetSelectedPin()));
     }
 
     Node* GetSelectedNode() { return mSelectedNode; }
     Node& GetNode(size_t index) { return mNodes[index]; }
-    std::vector<Node>& GetNodes() { return mNodes; }
+    const Node& GetNode(size_t index) const { return mNodes[index]; }
+    TrackedVector<Node, MemoryTag::Components>& GetNodes() { return mNodes; }
+    const TrackedVector<Node, MemoryTag::Components>& GetNodes() const { return mNodes; }
+    const TrackedVector<ComponentPin, MemoryTag::Components>& GetComponentPins() const { return mPins; }
+    Connector* GetConnector(uint32_t componentPinId) const { return mConnectors.at(componentPinId).get(); }
+
+    // Assigned by the circuit board when the component is placed
+    uint32_t GetId() const { return mId; }
+    void SetId(uint32_t id) { mId = id; }
 
     void SetColor(const sf::Color& color) { mColor = color; }    
 
+    double GetValue() const { return mValue; }
+    void SetValue(double value) { mValue = value; }
+
+    // Placement validity is answered by the circuit board occupancy bitmap, this only pairs up
+    // connectors of connectable pins that land on the same circuit board pin
     void CollectConnections(Component& component, ConnectionConnector& outConnectionConnector) const
     {   
-        /*
-        for (const sf::Vector2f& pin0 : mPins)
+        for (uint32_t componentPinId = 0; componentPinId < mPins.size(); componentPinId++)
         {
-            for (const sf::Vector2f& pin1 : component.mPins)
+            Pin* circuitBoardPin = mPins[componentPinId].GetTemporaryConnectionPin();
+            if (circuitBoardPin == nullptr)
+            {
+                continue;
+            }
+
+            Connector* sourceConnector = mConnectors[componentPinId].get();
+            Connector* targetConnector = component.GetConnectorAtPin(*circuitBoardPin);
+            if (sourceConnector != nullptr && targetConnector != nullptr)
             {
-                if (pin0 != pin1)
-                {
-                    continue;
-                }
-
-                Connector* sourceConnector = GetConnectorAtPin(pin0);
-                Connector* targetConnector = component.GetConnectorAtPin(pin1);
-
-                if (sourceConnector == nullptr || targetConnector == nullptr)
-                {
-                    outConnectionConnector.SetIsPlaceable(false);
-                }
-                else
-                {
-                    outConnectionConnector.AddConnectorPair(sourceConnector, targetConnector);
-                }
+                outConnectionConnector.AddConnectorPair(sourceConnector, targetConnector);
             }
         }
-        */
     }     
 
-    virtual Connector* GetConnectorAtPin(sf::Vector2f pin) const
+    Connector* GetConnectorAtPin(const Pin& circuitBoardPin) const
     {
+        for (uint32_t componentPinId = 0; componentPinId < mPins.size(); componentPinId++)
+        {
+            Pin* temporaryConnectionPin = mPins[componentPinId].GetTemporaryConnectionPin();
+            if (temporaryConnectionPin != nullptr && temporaryConnectionPin->GetId() == circuitBoardPin.GetId())
+            {
+                return mConnectors[componentPinId].get();
+            }
+        }
         return nullptr;
+    }
 
-        /*
-        for (auto& connectorPtr : mConnectors)
+    // Puts the component back where a board file recorded it instead of following the cursor
+    void RestorePlacement(const ComponentPinRecord* pinRecords, const NodeRecord* nodeRecords, size_t nodeCount)
+    {
+        for (uint32_t componentPinId = 0; componentPinId < mPins.size(); componentPinId++)
         {
-            sf::Vector2f position = connectorPtr->GetPosition();
-            if (pin.x == position.x && pin.y == position.y)
+            uint32_t boardPinId = pinRecords[componentPinId].mBoardPinId;
+            Pin* circuitBoardPin = boardPinId == ComponentPinRecord::UnassociatedPin ? nullptr : mNavigator->GetPin(boardPinId);
+            AssociateComponentWithCircuitBoardPin(componentPinId, circuitBoardPin);
+        }
+
+        for (size_t nodeIndex = 0; nodeIndex < nodeCount && nodeIndex < mNodes.size(); nodeIndex++)
+        {
+            mNodes[nodeIndex].SetPosition({ nodeRecords[nodeIndex].mX, nodeRecords[nodeIndex].mY });
+        }
+    }
+
+    void CollectFootprint(OccupancyFootprint& outFootprint) const
+    {
+        outFootprint.Reset();
+        for (const ComponentPin& componentPin : mPins)
+        {
+            if (Pin* circuitBoardPin = componentPin.GetTemporaryConnectionPin())
             {
-                return connectorPtr.get();
+                outFootprint.AddPin(mNavigator->GetSlot(*circuitBoardPin), componentPin.IsConnectable());
             }
         }
-        return nullptr;
-        */
     }
 
-    virtual Component* CreateShape(ICircuitBoardNavigator* navigator) const = 0;
+    // A new component of this type following the cursor
+    Component* CreateShape(ICircuitBoardNavigator* navigator) const
+    {
+        Component* component = Create(navigator);
+        component->Move();
+        return component;
+    }
+
+    // A new component of this type placed around a board pin, for building boards without a cursor. Null
+    // when the pin is not on the board.
+    Component* CreateShapeAt(ICircuitBoardNavigator* navigator, uint32_t anchorPinId) const
+    {
+        Pin* anchorPin = navigator->GetPin(anchorPinId);
+        if (anchorPin == nullptr)
+        {
+            return nullptr;
+        }
+
+        Component* component = Create(navigator);
+        component->PlaceAt(*anchorPin);
+        return component;
+    }
+
+    // A new component of this type, not placed yet
+    virtual Component* Create(ICircuitBoardNavigator* navigator) const = 0;
+    virtual const char* GetTypeName() const = 0;
+    virtual ElementKind GetElementKind() const { return ElementKind::None; }
+    virtual std::pair<uint32_t, uint32_t> GetTerminalPinIds() const { return { 0, 1 }; }
+
+    // Pins wired inside the element to its first and second terminal, the terminals themselves by default
+    virtual std::pair<uint32_t, uint32_t> GetTiedPinIds() const { return GetTerminalPinIds(); }
+
+    // World bounds of the placed component, by default the box around its circuit board pins
+    virtual sf::FloatRect GetBounds() const
+    {
+        sf::Vector2f min(std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+        sf::Vector2f max(std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest());
+        for (const ComponentPin& componentPin : mPins)
+        {
+            if (Pin* circuitBoardPin = componentPin.GetTemporaryConnectionPin())
+            {
+                sf::Vector2f position = mNavigator->GetGridCoordinateFromPin(*circuitBoardPin);
+                min = { std::min(min.x, position.x), std::min(min.y, position.y) };
+                max = { std::max(max.x, position.x), std::max(max.y, position.y) };
+            }
+        }
+
+        if (min.x > max.x)
+        {
+            return sf::FloatRect();
+        }
+        return sf::FloatRect(min, max - min);
+    }
     
-    // 
-    virtual void Move() = 0;
+    // Associates the component pins with the board pins around the anchor pin, moved inwards as needed
+    // to stay on the board
+    virtual void PlaceAt(Pin& anchorPin) = 0;
+
+    // Follows the cursor
+    virtual void Move() { PlaceAt(GetCircuitBoardPinAtCursor()); }
     
     // Draing
-    virtual void DrawComponent(sf::RenderTarget& target) = 0;
+    virtual void DrawComponent(Canvas& canvas) const = 0;
     virtual void DrawIcon(sf::RenderTarget& target, const sf::Transform& transform, const sf::FloatRect& localBounds) = 0;
     virtual void DebugDraw(sf::RenderTarget& target) { };
 
 protected:
+    // Nodes of a component that places itself get their positions when it is placed
+    Node* AddNode(sf::Vector2f position = {})
+    {
+        assert(mNodes.size() < mMaxNodes);
+        mNodes.push_back(Node(this, position));
+        mSelectedNode = &mNodes[mNodes.size() - 1];
+        return mSelectedNode;
+    }
+
     void AddComponentPin(bool connectable)
     {
         uint32_t pinId = mPins.size();
         mPins.push_back(ComponentPin(pinId, connectable));
+        mConnectors.push_back(connectable ? std::make_unique<Connector>(this, pinId) : nullptr);
     }
 
     ComponentPin& GetComponentPin(uint32_t componentPinId)
@@ -262,7 +370,7 @@ protected:
         mPins.at(componentPinId).SetTemporaryConnectionPin(circuitBoardPin);
     }
 
-    const sf::Vector2f& GetCircuitBoardPinPosition(uint32_t componentPinId)
+    sf::Vector2f GetCircuitBoardPinPosition(uint32_t componentPinId)
     {
         Pin* temporaryConnectionPin = GetComponentPin(componentPinId).GetTemporaryConnectionPin();
         return mNavigator->GetGridCoordinateFromPin(*temporaryConnectionPin);
@@ -282,8 +390,11 @@ protected:
 
 private:
     ICircuitBoardNavigator* mNavigator;
-    std::vector<ComponentPin> mPins;
-    std::vector<Node> mNodes;    
+    TrackedVector<ComponentPin, MemoryTag::Components> mPins;
+    TrackedVector<std::unique_ptr<Connector>, MemoryTag::Components> mConnectors;
+    TrackedVector<Node, MemoryTag::Components> mNodes;    
     Node* mSelectedNode{ nullptr };
     size_t mMaxNodes;
+    uint32_t mId{ 0 };
+    double mValue{ 0 };
 };
\ No newline at end of file
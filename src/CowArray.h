@@ -0,0 +1,96 @@
+#pragma once
+
+#include "MemoryTracker.h"
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Growable array stored in fixed size chunks shared between copies. Copying is O(1); the first
+// write after a copy duplicates the chunk table and the chunk being written, never the whole array.
+// Copies may be read on other threads while the original keeps appending.
+template<typename T, MemoryTag Tag, size_t ChunkSize = 4096>
+class CowArray
+{
+public:
+    using Chunk = TrackedVector<T, Tag>;
+
+    void PushBack(const T& value)
+    {
+        MakeTableUnique();
+
+        std::vector<std::shared_ptr<Chunk>>& chunks = *mChunks;
+        if (chunks.empty() || chunks.back()->size() == ChunkSize)
+        {
+            chunks.push_back(std::make_shared<Chunk>());
+            chunks.back()->reserve(ChunkSize);
+        }
+        else if (chunks.back().use_count() > 1)
+        {
+            auto chunk = std::make_shared<Chunk>();
+            chunk->reserve(ChunkSize);
+            chunk->assign(chunks.back()->begin(), chunks.back()->end());
+            chunks.back() = std::move(chunk);
+        }
+
+        chunks.back()->push_back(value);
+        mSize++;
+    }
+
+    void Set(size_t index, const T& value)
+    {
+        assert(index < mSize);
+        MakeTableUnique();
+
+        std::shared_ptr<Chunk>& chunk = (*mChunks)[index / ChunkSize];
+        if (chunk.use_count() > 1)
+        {
+            auto copy = std::make_shared<Chunk>();
+            copy->reserve(ChunkSize);
+            copy->assign(chunk->begin(), chunk->end());
+            chunk = std::move(copy);
+        }
+        (*chunk)[index % ChunkSize] = value;
+    }
+
+    size_t Size() const { return mSize; }
+    bool Empty() const { return mSize == 0; }
+
+    const T& operator[](size_t index) const
+    {
+        assert(index < mSize);
+        return (*(*mChunks)[index / ChunkSize])[index % ChunkSize];
+    }
+
+    // Visits the elements as contiguous runs, in order
+    template<typename Function>
+    void ForEachChunk(Function function) const
+    {
+        if (!mChunks)
+        {
+            return;
+        }
+
+        for (const std::shared_ptr<Chunk>& chunk : *mChunks)
+        {
+            function(chunk->data(), chunk->size());
+        }
+    }
+
+private:
+    void MakeTableUnique()
+    {
+        if (!mChunks)
+        {
+            mChunks = std::make_shared<std::vector<std::shared_ptr<Chunk>>>();
+        }
+        else if (mChunks.use_count() > 1)
+        {
+            mChunks = std::make_shared<std::vector<std::shared_ptr<Chunk>>>(*mChunks);
+        }
+    }
+
+    std::shared_ptr<std::vector<std::shared_ptr<Chunk>>> mChunks;
+    size_t mSize{ 0 };
+};
\ No newline at end of file
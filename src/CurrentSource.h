@@ -0,0 +1,65 @@
+#pragma once
+
+#include "TwoTerminalComponent.h"
+
+// Ideal current source, current flows from the first terminal through the source to the second
+class CurrentSource : public TwoTerminalComponent
+{
+public:
+    CurrentSource() = default;
+    CurrentSource(ICircuitBoardNavigator* navigator)
+        : TwoTerminalComponent(navigator, DefaultCurrent)
+    { }
+
+    virtual Component* Create(ICircuitBoardNavigator* navigator) const override
+    {
+        return new CurrentSource(navigator);
+    }
+
+    virtual const char* GetTypeName() const override
+    {
+        return "CurrentSource";
+    }
+
+    virtual ElementKind GetElementKind() const override
+    {
+        return ElementKind::CurrentSource;
+    }
+
+    virtual void DrawComponent(Canvas& canvas) const override
+    {
+        sf::FloatRect body = DrawLeads(canvas);
+        float radius = body.width / 2.0f;
+        sf::Vector2f center(body.left + radius, body.top + body.height / 2.0f);
+
+        canvas.DrawCircleOutline(center, radius, mColor);
+
+        // Arrow in the direction of the current
+        float arrow = radius / 2.0f;
+        sf::Vertex lines[] = {
+            { center - sf::Vector2f(arrow, 0), mColor },
+            { center + sf::Vector2f(arrow, 0), mColor },
+            { center + sf::Vector2f(arrow, 0), mColor },
+            { center + sf::Vector2f(0, -arrow / 2.0f), mColor },
+            { center + sf::Vector2f(arrow, 0), mColor },
+            { center + sf::Vector2f(0, arrow / 2.0f), mColor }
+        };
+        canvas.DrawLines(lines, 6);
+    }
+
+    virtual void DrawIcon(sf::RenderTarget& target, const sf::Transform& transform, const sf::FloatRect& localBounds) override
+    {
+        sf::RenderStates states;
+        states.transform = transform;
+
+        float radius = std::min(localBounds.width, localBounds.height) / 2.0f;
+        sf::CircleShape circle(radius);
+        circle.setFillColor(sf::Color::Blue);
+        circle.setPosition({ localBounds.left + localBounds.width / 2.0f - radius, localBounds.top + localBounds.height / 2.0f - radius });
+
+        target.draw(circle, states);
+    }
+
+private:
+    static constexpr double DefaultCurrent = 0.001;
+};
\ No newline at end of file
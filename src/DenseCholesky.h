@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+// Cholesky factorization of a dense symmetric matrix in place, row major, the solution replaces the right
+// hand side. Complex matrices are factored by transposing rather than conjugating, which suits the complex
+// symmetric admittance matrices of an AC analysis. The factorization breaks down on a pivot lost in the
+// rounding of its diagonal, or for real matrices on one that is not positive, as for a singular matrix.
+template<typename Value>
+bool SolveDenseCholesky(size_t size, std::vector<Value>& matrix, std::vector<Value>& rightHandSide)
+{
+    constexpr double PivotTolerance = std::numeric_limits<double>::epsilon();  // Relative to the diagonal
+
+    for (size_t column = 0; column < size; column++)
+    {
+        Value* columnRow = &matrix[column * size];
+        Value diagonal = columnRow[column];
+        for (size_t inner = 0; inner < column; inner++)
+        {
+            diagonal -= columnRow[inner] * columnRow[inner];
+        }
+
+        bool isPivotValid = std::abs(diagonal) > PivotTolerance * std::abs(columnRow[column]);
+        if constexpr (std::is_floating_point_v<Value>)
+        {
+            isPivotValid = isPivotValid && diagonal > 0.0;
+        }
+        if (!isPivotValid)
+        {
+            return false;
+        }
+        diagonal = std::sqrt(diagonal);
+        columnRow[column] = diagonal;
+
+        for (size_t row = column + 1; row < size; row++)
+        {
+            Value* rowValues = &matrix[row * size];
+            Value value = rowValues[column];
+            for (size_t inner = 0; inner < column; inner++)
+            {
+                value -= rowValues[inner] * columnRow[inner];
+            }
+            rowValues[column] = value / diagonal;
+        }
+    }
+
+    // Forward substitution with the lower factor, then back substitution with its transpose
+    for (size_t row = 0; row < size; row++)
+    {
+        Value value = rightHandSide[row];
+        for (size_t inner = 0; inner < row; inner++)
+        {
+            value -= matrix[row * size + inner] * rightHandSide[inner];
+        }
+        rightHandSide[row] = value / matrix[row * size + row];
+    }
+
+    for (size_t row = size; row-- > 0;)
+    {
+        Value value = rightHandSide[row];
+        for (size_t inner = row + 1; inner < size; inner++)
+        {
+            value -= matrix[inner * size + row] * rightHandSide[inner];
+        }
+        rightHandSide[row] = value / matrix[row * size + row];
+    }
+    return true;
+}
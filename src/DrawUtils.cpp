@@ -1,21 +1,161 @@
 #include "DrawUtils.h"
 
+#include <cctype>
+#include <vector>
+
 void DrawPoint(sf::RenderTarget& target, sf::Vector2f position, float radius, sf::Color color)
 {
-    sf::CircleShape shape(radius);
+    static sf::CircleShape shape;
+    shape.setRadius(radius);
     shape.setFillColor(color);
     shape.setPosition({ position.x - radius, position.y - radius });
     target.draw(shape);
 }
 
-void DrawFloatRect(sf::RenderTarget& target, const sf::FloatRect& rect, sf::Color color)
+void DrawCircleOutline(sf::RenderTarget& target, sf::Vector2f center, float radius, sf::Color color)
+{
+    static sf::CircleShape shape;
+    shape.setRadius(radius);
+    shape.setFillColor({ 0, 0, 0, 0 });
+    shape.setOutlineColor(color);
+    shape.setOutlineThickness(1.0f);
+    shape.setPosition({ center.x - radius, center.y - radius });
+    target.draw(shape);
+}
+
+void DrawFloatRect(sf::RenderTarget& target, const sf::FloatRect& rect, sf::Color color, float outlineThickness)
 {
-    sf::RectangleShape shape;
+    static sf::RectangleShape shape;
     shape.setPosition(rect.getPosition());
     shape.setSize(rect.getSize());
     shape.setFillColor({ 0, 0, 0, 0 });
     shape.setOutlineColor(color);
-    shape.setOutlineThickness(-1);
+    shape.setOutlineThickness(outlineThickness);
 
     target.draw(shape);
+}
+
+void TargetCanvas::DrawLines(const sf::Vertex* vertices, size_t vertexCount)
+{
+    mTarget.draw(vertices, vertexCount, sf::PrimitiveType::Lines);
+}
+
+void TargetCanvas::DrawPoint(sf::Vector2f position, float radius, sf::Color color)
+{
+    ::DrawPoint(mTarget, position, radius, color);
+}
+
+void TargetCanvas::DrawCircleOutline(sf::Vector2f center, float radius, sf::Color color)
+{
+    ::DrawCircleOutline(mTarget, center, radius, color);
+}
+
+void TargetCanvas::DrawRectOutline(const sf::FloatRect& rect, sf::Color color)
+{
+    DrawFloatRect(mTarget, rect, color, 1.0f);
+}
+
+namespace
+{
+    // Rows top to bottom, three bits per row with the leftmost pixel in the high bit
+    uint16_t GetGlyph(char character)
+    {
+        auto rows = [](uint16_t r0, uint16_t r1, uint16_t r2, uint16_t r3, uint16_t r4)
+        {
+            return static_cast<uint16_t>((r0 << 12) | (r1 << 9) | (r2 << 6) | (r3 << 3) | r4);
+        };
+
+        switch (std::toupper(static_cast<unsigned char>(character)))
+        {
+            case '0': return rows(07, 05, 05, 05, 07);
+            case '1': return rows(02, 06, 02, 02, 07);
+            case '2': return rows(07, 01, 07, 04, 07);
+            case '3': return rows(07, 01, 07, 01, 07);
+            case '4': return rows(05, 05, 07, 01, 01);
+            case '5': return rows(07, 04, 07, 01, 07);
+            case '6': return rows(07, 04, 07, 05, 07);
+            case '7': return rows(07, 01, 01, 01, 01);
+            case '8': return rows(07, 05, 07, 05, 07);
+            case '9': return rows(07, 05, 07, 01, 07);
+            case 'A': return rows(02, 05, 07, 05, 05);
+            case 'B': return rows(06, 05, 06, 05, 06);
+            case 'C': return rows(03, 04, 04, 04, 03);
+            case 'D': return rows(06, 05, 05, 05, 06);
+            case 'E': return rows(07, 04, 06, 04, 07);
+            case 'F': return rows(07, 04, 06, 04, 04);
+            case 'G': return rows(03, 04, 05, 05, 03);
+            case 'H': return rows(05, 05, 07, 05, 05);
+            case 'I': return rows(07, 02, 02, 02, 07);
+            case 'J': return rows(01, 01, 01, 05, 02);
+            case 'K': return rows(05, 05, 06, 05, 05);
+            case 'L': return rows(04, 04, 04, 04, 07);
+            case 'M': return rows(05, 07, 07, 05, 05);
+            case 'N': return rows(06, 05, 05, 05, 05);
+            case 'O': return rows(02, 05, 05, 05, 02);
+            case 'P': return rows(06, 05, 06, 04, 04);
+            case 'Q': return rows(02, 05, 05, 06, 03);
+            case 'R': return rows(06, 05, 06, 05, 05);
+            case 'S': return rows(03, 04, 02, 01, 06);
+            case 'T': return rows(07, 02, 02, 02, 02);
+            case 'U': return rows(05, 05, 05, 05, 07);
+            case 'V': return rows(05, 05, 05, 05, 02);
+            case 'W': return rows(05, 05, 07, 07, 05);
+            case 'X': return rows(05, 05, 02, 05, 05);
+            case 'Y': return rows(05, 05, 02, 02, 02);
+            case 'Z': return rows(07, 01, 02, 04, 07);
+            case '.': return rows(00, 00, 00, 00, 02);
+            case ':': return rows(00, 02, 00, 02, 00);
+            case '-': return rows(00, 00, 07, 00, 00);
+            case '+': return rows(00, 02, 07, 02, 00);
+            case '/': return rows(01, 01, 02, 04, 04);
+            case '%': return rows(05, 01, 02, 04, 05);
+            case '(': return rows(01, 02, 02, 02, 01);
+            case ')': return rows(04, 02, 02, 02, 04);
+            default: return 0;
+        }
+    }
+}
+
+void DrawLabel(sf::RenderTarget& target, sf::Vector2f position, std::string_view text, float pixelSize, sf::Color color)
+{
+    // Reused between calls so HUD labels do not allocate every frame
+    static std::vector<sf::Vertex> vertices;
+    vertices.clear();
+
+    sf::Vector2f pen = position;
+    for (char character : text)
+    {
+        if (character == '\n')
+        {
+            pen = { position.x, pen.y + 6 * pixelSize };
+            continue;
+        }
+
+        uint16_t glyph = GetGlyph(character);
+        for (uint32_t row = 0; row < 5; row++)
+        {
+            for (uint32_t column = 0; column < 3; column++)
+            {
+                if (((glyph >> ((4 - row) * 3 + (2 - column))) & 1) == 0)
+                {
+                    continue;
+                }
+
+                sf::Vector2f topLeft = pen + sf::Vector2f(column * pixelSize, row * pixelSize);
+                sf::Vector2f bottomRight = topLeft + sf::Vector2f(pixelSize, pixelSize);
+                vertices.emplace_back(topLeft, color);
+                vertices.emplace_back(sf::Vector2f(bottomRight.x, topLeft.y), color);
+                vertices.emplace_back(bottomRight, color);
+                vertices.emplace_back(topLeft, color);
+                vertices.emplace_back(bottomRight, color);
+                vertices.emplace_back(sf::Vector2f(topLeft.x, bottomRight.y), color);
+            }
+        }
+        pen.x += 4 * pixelSize;
+    }
+
+    if (!vertices.empty())
+    {
+        target.draw(vertices.data(), vertices.size(), sf::PrimitiveType::Triangles);
+    }
 }
\ No newline at end of file
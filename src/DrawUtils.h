@@ -2,5 +2,41 @@
 
 #include <SFML/Graphics.hpp>
 
+#include <cstddef>
+#include <string_view>
+
+// What components draw on, the window through a render target or an exported image through the software
+// rasterizer (see RasterCanvas). Lines are one pixel wide at any scale, outlines one unit wide outside the shape.
+class Canvas
+{
+public:
+    virtual ~Canvas() = default;
+
+    virtual void DrawLines(const sf::Vertex* vertices, size_t vertexCount) = 0;  // Pairs of vertices
+    virtual void DrawPoint(sf::Vector2f position, float radius, sf::Color color) = 0;
+    virtual void DrawCircleOutline(sf::Vector2f center, float radius, sf::Color color) = 0;
+    virtual void DrawRectOutline(const sf::FloatRect& rect, sf::Color color) = 0;
+};
+
+// The shapes are reused between calls, so drawing every frame does not allocate
 void DrawPoint(sf::RenderTarget& target, sf::Vector2f position, float radius, sf::Color color);
-void DrawFloatRect(sf::RenderTarget& target, const sf::FloatRect& rect, sf::Color color);
\ No newline at end of file
+void DrawCircleOutline(sf::RenderTarget& target, sf::Vector2f center, float radius, sf::Color color);
+void DrawFloatRect(sf::RenderTarget& target, const sf::FloatRect& rect, sf::Color color, float outlineThickness = -1.0f);
+class TargetCanvas : public Canvas
+{
+public:
+    explicit TargetCanvas(sf::RenderTarget& target)
+        : mTarget(target)
+    { }
+
+    virtual void DrawLines(const sf::Vertex* vertices, size_t vertexCount) override;
+    virtual void DrawPoint(sf::Vector2f position, float radius, sf::Color color) override;
+    virtual void DrawCircleOutline(sf::Vector2f center, float radius, sf::Color color) override;
+    virtual void DrawRectOutline(const sf::FloatRect& rect, sf::Color color) override;
+
+private:
+    sf::RenderTarget& mTarget;
+};
+
+// Blocky 3x5 pixel font for HUD labels, the repo ships no font files. Lowercase draws as uppercase.
+void DrawLabel(sf::RenderTarget& target, sf::Vector2f position, std::string_view text, float pixelSize, sf::Color color);
\ No newline at end of file
@@ -9,8 +9,10 @@ class ICircuitBoardNavigator
 {
 public:
     virtual Pin* GetSurroundingPin(Pin& pin, sf::Vector2i offset) = 0;
+    virtual Pin* GetPin(uint32_t pinId) = 0;
     virtual Pin& GetSelectedPin() = 0;
     virtual sf::Vector2f GetGridCoordinateFromPin(Pin& pin) = 0;
+    virtual uint32_t GetSlot(const Pin& pin) const = 0;  // Where per-pin board data of the pin is, see PinLayout
 };
 
 class IComponentPickerObserver
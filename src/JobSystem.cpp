@@ -0,0 +1,257 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+
+namespace
+{
+    constexpr size_t NoWorker = static_cast<size_t>(-1);
+
+    // Which worker of which system the thread is
+    thread_local const JobSystem* tJobSystem = nullptr;
+    thread_local size_t tWorkerIndex = NoWorker;
+}
+
+JobSystem::JobSystem(size_t threadCount)
+{
+    if (threadCount == 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (size_t index = 0; index < threadCount; index++)
+    {
+        mQueues.push_back(std::make_unique<JobQueue>());
+    }
+
+    for (size_t index = 0; index + 1 < threadCount; index++)
+    {
+        mWorkers.emplace_back(&JobSystem::Run, this, index);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(mSleepMutex);
+        mIsStopping = true;
+    }
+    mWakeCondition.notify_all();
+
+    for (std::thread& worker : mWorkers)
+    {
+        worker.join();
+    }
+}
+
+JobSystem& JobSystem::GetShared()
+{
+    static JobSystem jobSystem;
+    return jobSystem;
+}
+
+void JobSystem::Schedule(JobGroup& group, std::function<void()> function, JobGroup* dependency)
+{
+    group.mPendingCount.fetch_add(1, std::memory_order_relaxed);
+    Job job{ std::move(function), &group };
+
+    if (dependency != nullptr)
+    {
+        // The last job of the dependency takes the continuations under the same lock
+        std::lock_guard<std::mutex> lock(dependency->mMutex);
+        if (!dependency->IsDone())
+        {
+            dependency->mContinuations.push_back(std::move(job));
+            return;
+        }
+    }
+    Push(std::move(job));
+}
+
+void JobSystem::Wait(JobGroup& group)
+{
+    while (!group.IsDone())
+    {
+        if (TryRunJob())
+        {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mSleepMutex);
+        mWakeCondition.wait(lock, [&] { return group.IsDone() || mQueuedCount > 0; });
+    }
+
+    // The last job may still be unlocking the group, which the caller is free to destroy once this returns
+    std::lock_guard<std::mutex> lock(group.mMutex);
+}
+
+void JobSystem::ParallelFor(size_t count, const std::function<void(size_t)>& function)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    if (mWorkers.empty() || count == 1)
+    {
+        for (size_t index = 0; index < count; index++)
+        {
+            function(index);
+        }
+        return;
+    }
+
+    // A job per thread rather than per index, whichever thread gets to an index first calls it
+    std::atomic<size_t> nextIndex{ 0 };
+    std::function<void()> runIndices = [&]()
+    {
+        for (size_t index = nextIndex++; index < count; index = nextIndex++)
+        {
+            function(index);
+        }
+    };
+
+    JobGroup group;
+    size_t parkedCount = std::min(mReservedCount.load(), mWorkers.size());
+    size_t helperCount = std::min(count, GetThreadCount() - parkedCount) - 1;
+    for (size_t helper = 0; helper < helperCount; helper++)
+    {
+        Schedule(group, [&runIndices]() { runIndices(); });
+    }
+
+    runIndices();
+    Wait(group);
+}
+
+void JobSystem::Run(size_t workerIndex)
+{
+    tJobSystem = this;
+    tWorkerIndex = workerIndex;
+
+    while (true)
+    {
+        if (!IsParked(workerIndex) && TryRunJob())
+        {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mSleepMutex);
+        mWakeCondition.wait(lock, [this, workerIndex] { return mIsStopping || (mQueuedCount > 0 && !IsParked(workerIndex)); });
+        if (mIsStopping)
+        {
+            return;
+        }
+    }
+}
+
+// The last workers are the ones parked
+bool JobSystem::IsParked(size_t workerIndex) const
+{
+    return workerIndex + mReservedCount.load() >= mWorkers.size();
+}
+
+void JobSystem::ReserveThread()
+{
+    std::lock_guard<std::mutex> lock(mSleepMutex);
+    mReservedCount++;
+}
+
+void JobSystem::ReleaseThread()
+{
+    {
+        std::lock_guard<std::mutex> lock(mSleepMutex);
+        mReservedCount--;
+    }
+    mWakeCondition.notify_all();
+}
+
+void JobSystem::Push(Job&& job)
+{
+    JobQueue& queue = tJobSystem == this ? *mQueues[tWorkerIndex] : *mQueues.back();
+    {
+        std::lock_guard<std::mutex> lock(queue.mMutex);
+        mQueuedCount++;
+        queue.mJobs.push_back(std::move(job));
+    }
+
+    // Taking the lock orders the count before the check of a thread about to sleep. The one woken could be
+    // parked, with reservations every thread is woken.
+    {
+        std::lock_guard<std::mutex> lock(mSleepMutex);
+    }
+    if (mReservedCount.load() > 0)
+    {
+        mWakeCondition.notify_all();
+    }
+    else
+    {
+        mWakeCondition.notify_one();
+    }
+}
+
+bool JobSystem::TryPop(Job& outJob)
+{
+    size_t ownIndex = tJobSystem == this ? tWorkerIndex : mQueues.size() - 1;
+
+    // Newest first from the own queue, the oldest of anyone else's
+    for (size_t offset = 0; offset < mQueues.size(); offset++)
+    {
+        size_t queueIndex = (ownIndex + offset) % mQueues.size();
+        JobQueue& queue = *mQueues[queueIndex];
+        std::lock_guard<std::mutex> lock(queue.mMutex);
+        if (queue.mJobs.empty())
+        {
+            continue;
+        }
+
+        if (offset == 0)
+        {
+            outJob = std::move(queue.mJobs.back());
+            queue.mJobs.pop_back();
+        }
+        else
+        {
+            outJob = std::move(queue.mJobs.front());
+            queue.mJobs.pop_front();
+        }
+        mQueuedCount--;
+        return true;
+    }
+    return false;
+}
+
+bool JobSystem::TryRunJob()
+{
+    Job job;
+    if (!TryPop(job))
+    {
+        return false;
+    }
+
+    job.mFunction();
+    Finish(*job.mGroup);
+    return true;
+}
+
+void JobSystem::Finish(JobGroup& group)
+{
+    std::vector<Job> continuations;
+    {
+        std::lock_guard<std::mutex> lock(group.mMutex);
+        if (group.mPendingCount.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        {
+            return;
+        }
+        continuations.swap(group.mContinuations);
+    }
+
+    for (Job& continuation : continuations)
+    {
+        Push(std::move(continuation));
+    }
+
+    // Wakes the threads waiting for the group
+    {
+        std::lock_guard<std::mutex> lock(mSleepMutex);
+    }
+    mWakeCondition.notify_all();
+}
\ No newline at end of file
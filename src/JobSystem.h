@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobGroup;
+
+struct Job
+{
+    std::function<void()> mFunction;
+    JobGroup* mGroup{ nullptr };
+};
+
+// Jobs counted together, to wait for them or to start other jobs once they are done. A group can be reused
+// once it is done.
+class JobGroup
+{
+public:
+    JobGroup() = default;
+    JobGroup(const JobGroup&) = delete;
+    JobGroup& operator=(const JobGroup&) = delete;
+
+    bool IsDone() const { return mPendingCount.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+
+    std::atomic<size_t> mPendingCount{ 0 };
+    std::mutex mMutex;
+    std::vector<Job> mContinuations;  // Waiting for the group to be done
+};
+
+// Worker threads shared by every subsystem, so the solver, the simulation, the router and whatever else runs
+// in parallel split the cores between them instead of each starting its own threads. Every worker keeps a
+// deque of the jobs it scheduled, runs them newest first and, when it runs out, steals the oldest job of
+// another worker. Jobs scheduled from other threads go to a shared queue. A thread waiting for jobs runs
+// jobs until they are done, so any thread can schedule and wait, jobs included, and a system of one thread
+// runs everything on the waiting thread.
+class JobSystem
+{
+public:
+    explicit JobSystem(size_t threadCount = 0);  // Zero uses every hardware thread
+    ~JobSystem();  // Drops the jobs that have not started
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // The one of the application, for code without a job system of its own
+    static JobSystem& GetShared();
+
+    // The job counts towards the group until it returns. With a dependency it starts once that group is done.
+    void Schedule(JobGroup& group, std::function<void()> function, JobGroup* dependency = nullptr);
+
+    // Runs jobs, of any group, until the group is done
+    void Wait(JobGroup& group);
+
+    // Calls function(index) for every index below count and returns once all calls returned
+    void ParallelFor(size_t count, const std::function<void(size_t)>& function);
+
+    size_t GetThreadCount() const { return mWorkers.size() + 1; }
+
+    // For a busy thread of its own that runs alongside the jobs, like the stepping loop of a simulation. A
+    // worker sleeps for each reservation so the busy threads stay at one per hardware thread, the caller's
+    // own waits still run jobs.
+    void ReserveThread();
+    void ReleaseThread();
+
+private:
+    struct JobQueue
+    {
+        std::mutex mMutex;
+        std::deque<Job> mJobs;
+    };
+
+    void Run(size_t workerIndex);
+    bool IsParked(size_t workerIndex) const;
+    void Push(Job&& job);
+    bool TryPop(Job& outJob);
+    bool TryRunJob();
+    void Finish(JobGroup& group);
+
+    std::vector<std::thread> mWorkers;
+    std::vector<std::unique_ptr<JobQueue>> mQueues;  // One per worker, then the shared one
+
+    std::mutex mSleepMutex;
+    std::condition_variable mWakeCondition;
+    std::atomic<size_t> mQueuedCount{ 0 };  // Never below the jobs in the queues
+    std::atomic<size_t> mReservedCount{ 0 };
+    bool mIsStopping{ false };
+};
\ No newline at end of file
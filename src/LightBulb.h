@@ -13,8 +13,8 @@ public:
     LightBulb(ICircuitBoardNavigator* navigator)
         : Component(navigator, 2)
     { 
-        GetNextNode();
-        GetNextNode();
+        AddNode();
+        AddNode();
         
         AddComponentPin(true);   // 0
         AddComponentPin(true);   // 1
@@ -26,21 +26,64 @@ public:
         mDirectionsMap[1] = { 0, -1 };
         mDirectionsMap[2] = { 1, 0 };
         mDirectionsMap[3] = { 0, 1 };
+
+        SetValue(DefaultResistance);
+    }
+
+    virtual Component* Create(ICircuitBoardNavigator* navigator) const override
+    {
+        return new LightBulb(navigator);
     }
 
-    virtual Component* CreateShape(ICircuitBoardNavigator* navigator) const
+    virtual const char* GetTypeName() const override
     {
-        auto component = new LightBulb(navigator);
-        component->UpdateComponent();
-        return component;
+        return "LightBulb";
     }
 
-    virtual void Move() override
+    // A filament between the left and right pins
+    virtual ElementKind GetElementKind() const override
     {
-        UpdateComponent();
+        return ElementKind::Lamp;
+    }
+
+    virtual std::pair<uint32_t, uint32_t> GetTerminalPinIds() const override
+    {
+        return { 0, 2 };
+    }
+
+    // The top pin joins the left terminal and the bottom pin the right one, so every connectable pin is live
+    virtual std::pair<uint32_t, uint32_t> GetTiedPinIds() const override
+    {
+        return { 1, 3 };
+    }
+
+    virtual void PlaceAt(Pin& anchorPin) override
+    {
+        // Clamp to circuit board
+        Pin* selectedPin = &anchorPin;
+        for (const auto& pair : mDirectionsMap)
+        {
+            if (!GetNeighborCircuitBoardPin(*selectedPin, pair.second))
+            {
+                selectedPin = GetNeighborCircuitBoardPin(*selectedPin, -pair.second);
+                assert(selectedPin);
+            }
+        }
+        
+        // Associate circuit board pins
+        for (const auto& pair : mDirectionsMap)
+        {
+            Pin* circuitBoardPin = GetNeighborCircuitBoardPin(*selectedPin, pair.second);
+            AssociateComponentWithCircuitBoardPin(pair.first, circuitBoardPin);
+        } 
+        AssociateComponentWithCircuitBoardPin(4, selectedPin);
+
+        // Update node positions
+        GetNode(0).SetPosition(GetCircuitBoardPinPosition(4));
+        GetNode(1).SetPosition(GetCircuitBoardPinPosition(0));
     }
 
-    virtual void DrawComponent(sf::RenderTarget& target)
+    virtual void DrawComponent(Canvas& canvas) const override
     {
         // Draw shape
         const sf::Vector2f& position1 = GetNode(0).GetPosition();
@@ -52,14 +95,8 @@ public:
         line[0].color = mColor;
         line[1].color = mColor;
 
-        sf::CircleShape circle(radius);
-        circle.setFillColor({ 0, 0, 0, 0 });
-        circle.setOutlineColor(mColor);
-        circle.setOutlineThickness(1.0f);
-        circle.setPosition(position1 - sf::Vector2f(radius, radius));
-
-        target.draw(line, 2, sf::PrimitiveType::Lines);
-        target.draw(circle);
+        canvas.DrawLines(line, 2);
+        canvas.DrawCircleOutline(position1, radius, mColor);
     }
 
     virtual void DrawIcon(sf::RenderTarget& target, const sf::Transform& transform, const sf::FloatRect& localBounds) override
@@ -79,32 +116,8 @@ public:
     } 
 
 private:
-    void UpdateComponent()
-    {              
-        // Clamp to circuit board
-        Pin* selectedPin = &GetCircuitBoardPinAtCursor();
-        for (const auto& pair : mDirectionsMap)
-        {
-            if (!GetNeighborCircuitBoardPin(*selectedPin, pair.second))
-            {
-                selectedPin = GetNeighborCircuitBoardPin(*selectedPin, -pair.second);
-                assert(selectedPin);
-            }
-        }
-        
-        // Associate circuit board pins
-        for (const auto& pair : mDirectionsMap)
-        {
-            Pin* circuitBoardPin = GetNeighborCircuitBoardPin(*selectedPin, pair.second);
-            AssociateComponentWithCircuitBoardPin(pair.first, circuitBoardPin);
-        } 
-        AssociateComponentWithCircuitBoardPin(4, selectedPin);
+    static constexpr double DefaultResistance = 100.0;
 
-        // Update node positions
-        GetNode(0).SetPosition(GetCircuitBoardPinPosition(4));
-        GetNode(1).SetPosition(GetCircuitBoardPinPosition(0));
-    }
-   
-private:
-    std::unordered_map<uint32_t, sf::Vector2i> mDirectionsMap;
+    std::unordered_map<uint32_t, sf::Vector2i, std::hash<uint32_t>, std::equal_to<uint32_t>,
+        TrackedAllocator<std::pair<const uint32_t, sf::Vector2i>, MemoryTag::Components>> mDirectionsMap;
 };
\ No newline at end of file
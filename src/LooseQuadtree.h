@@ -0,0 +1,191 @@
+#pragma once
+
+#include "MemoryTracker.h"
+
+#include <SFML/Graphics.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+
+// Spatial index over item bounds. An item lives in the deepest node whose cell is at least as large as the
+// item, in the cell holding its center. A node's loose bounds are its cell grown by half a cell on every
+// side, which always contains its items, so insert and remove walk a single path and queries only descend
+// into nodes whose loose bounds overlap. Item ids index a flat array and should be dense.
+class LooseQuadtree
+{
+public:
+    LooseQuadtree(const sf::FloatRect& worldBounds = sf::FloatRect({ 0, 0 }, { 1, 1 }), uint32_t maxDepth = 16)
+        : mOrigin(worldBounds.left, worldBounds.top)
+        , mWorldSize(std::max({ worldBounds.width, worldBounds.height, 1.0f }))
+        , mMaxDepth(std::min(maxDepth, MaxDepthLimit))
+    {
+        mNodes.push_back(Node());
+    }
+
+    void Insert(uint32_t itemId, const sf::FloatRect& bounds)
+    {
+        if (itemId >= mItems.size())
+        {
+            mItems.resize(itemId + 1);
+        }
+        assert(mItems[itemId].mNode == NoIndex);
+
+        // Depth at which the cell size first drops below the item size, capped by the maximum depth
+        float itemSize = std::max(bounds.width, bounds.height);
+        uint32_t depth = itemSize > 0 ? static_cast<uint32_t>(std::max(0.0f, std::floor(std::log2(mWorldSize / itemSize)))) : mMaxDepth;
+        depth = std::min(depth, mMaxDepth);
+
+        sf::Vector2f center(bounds.left + bounds.width / 2.0f - mOrigin.x, bounds.top + bounds.height / 2.0f - mOrigin.y);
+        sf::Vector2f cellPosition;
+        float cellSize = mWorldSize;
+        uint32_t node = 0;
+        for (uint32_t level = 0; level < depth; level++)
+        {
+            cellSize /= 2.0f;
+            uint32_t quadrant = 0;
+            if (center.x >= cellPosition.x + cellSize)
+            {
+                quadrant |= 1;
+                cellPosition.x += cellSize;
+            }
+            if (center.y >= cellPosition.y + cellSize)
+            {
+                quadrant |= 2;
+                cellPosition.y += cellSize;
+            }
+
+            if (mNodes[node].mChildren[quadrant] == NoIndex)
+            {
+                mNodes[node].mChildren[quadrant] = static_cast<uint32_t>(mNodes.size());
+                mNodes.push_back(Node());
+            }
+            node = mNodes[node].mChildren[quadrant];
+        }
+
+        Item& item = mItems[itemId];
+        item.mBounds = bounds;
+        item.mNode = node;
+        item.mPrevious = NoIndex;
+        item.mNext = mNodes[node].mFirstItem;
+        if (item.mNext != NoIndex)
+        {
+            mItems[item.mNext].mPrevious = itemId;
+        }
+        mNodes[node].mFirstItem = itemId;
+        mItemCount++;
+    }
+
+    void Remove(uint32_t itemId)
+    {
+        Item& item = mItems.at(itemId);
+        assert(item.mNode != NoIndex);
+
+        if (item.mPrevious != NoIndex)
+        {
+            mItems[item.mPrevious].mNext = item.mNext;
+        }
+        else
+        {
+            mNodes[item.mNode].mFirstItem = item.mNext;
+        }
+
+        if (item.mNext != NoIndex)
+        {
+            mItems[item.mNext].mPrevious = item.mPrevious;
+        }
+        item = Item();
+        mItemCount--;
+    }
+
+    // Visits every item whose bounds overlap the rectangle, edges included
+    template<typename Function>
+    void Query(const sf::FloatRect& rect, Function function) const
+    {
+        struct Cell
+        {
+            uint32_t mNode;
+            sf::Vector2f mPosition;
+            float mSize;
+        };
+
+        // Depth first, so at most three siblings wait per level
+        Cell stack[3 * MaxDepthLimit + 4];
+        size_t stackSize = 0;
+        stack[stackSize++] = { 0, mOrigin, mWorldSize };
+        while (stackSize > 0)
+        {
+            Cell cell = stack[--stackSize];
+            float looseMargin = cell.mSize / 2.0f;
+            if (!Overlaps(rect, { cell.mPosition.x - looseMargin, cell.mPosition.y - looseMargin }, cell.mSize + 2.0f * looseMargin))
+            {
+                continue;
+            }
+
+            const Node& node = mNodes[cell.mNode];
+            for (uint32_t itemId = node.mFirstItem; itemId != NoIndex; itemId = mItems[itemId].mNext)
+            {
+                const sf::FloatRect& bounds = mItems[itemId].mBounds;
+                if (Overlaps(rect, bounds.getPosition(), bounds.width, bounds.height))
+                {
+                    function(itemId);
+                }
+            }
+
+            float childSize = cell.mSize / 2.0f;
+            for (uint32_t quadrant = 0; quadrant < 4; quadrant++)
+            {
+                if (node.mChildren[quadrant] != NoIndex)
+                {
+                    sf::Vector2f childPosition = cell.mPosition + sf::Vector2f((quadrant & 1) * childSize, (quadrant >> 1) * childSize);
+                    stack[stackSize++] = { node.mChildren[quadrant], childPosition, childSize };
+                }
+            }
+        }
+    }
+
+    template<typename Function>
+    void Query(sf::Vector2f point, Function function) const
+    {
+        Query(sf::FloatRect(point, { 0, 0 }), function);
+    }
+
+    size_t GetItemCount() const { return mItemCount; }
+
+private:
+    static constexpr uint32_t NoIndex = 0xFFFFFFFF;
+    static constexpr uint32_t MaxDepthLimit = 32;
+
+    struct Node
+    {
+        uint32_t mChildren[4]{ NoIndex, NoIndex, NoIndex, NoIndex };
+        uint32_t mFirstItem{ NoIndex };
+    };
+
+    struct Item
+    {
+        sf::FloatRect mBounds;
+        uint32_t mNode{ NoIndex };
+        uint32_t mPrevious{ NoIndex };
+        uint32_t mNext{ NoIndex };
+    };
+
+    static bool Overlaps(const sf::FloatRect& rect, sf::Vector2f position, float width, float height)
+    {
+        return rect.left <= position.x + width && position.x <= rect.left + rect.width
+            && rect.top <= position.y + height && position.y <= rect.top + rect.height;
+    }
+
+    static bool Overlaps(const sf::FloatRect& rect, sf::Vector2f position, float size)
+    {
+        return Overlaps(rect, position, size, size);
+    }
+
+    sf::Vector2f mOrigin;
+    float mWorldSize;
+    uint32_t mMaxDepth;
+    size_t mItemCount{ 0 };
+    TrackedVector<Node, MemoryTag::SpatialIndex> mNodes;
+    TrackedVector<Item, MemoryTag::SpatialIndex> mItems;
+};
\ No newline at end of file
@@ -1,28 +1,54 @@
+#include "AcAnalysis.h"
+#include "AutoSaver.h"
+#include "BoardImageExporter.h"
+#include "BoardLoader.h"
+#include "CircuitBoard.h"
+#include "CircuitSolver.h"
 #include "Component.h"
 #include "Battery.h"
+#include "CurrentSource.h"
 #include "LightBulb.h"
+#include "NetlistImporter.h"
+#include "Resistor.h"
+#include "Simulation.h"
+#include "JobSystem.h"
 #include "Wire.h"
 #include "DrawUtils.h"
 #include "Interfaces.h"
+#include "MemoryTracker.h"
 
 #include <SFML/Graphics.hpp>
 
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <optional>
+#include <thread>
 
-class ComponentFactory : public sf::Transformable
+class ComponentFactory
 {
 public:
+    static constexpr float IconSize = 100.0f;
+
     ComponentFactory(std::unique_ptr<Component> shape)
         : mShape(std::move(shape))
     { }
 
-    void Draw(sf::RenderTarget& target)
+    void DrawIcon(sf::RenderTarget& target, sf::Vector2f position)
     {
+        sf::Transform transform;
+        transform.translate(position);
+
         // Compute local bounds
         float border = 2.0f;
         float padding = 1.0f;
         float totalBorderPadding = border + padding;
-        sf::Vector2f size(100, 100);        
+        sf::Vector2f size(IconSize, IconSize);
         sf::FloatRect localBounds(
             { totalBorderPadding , totalBorderPadding },
             { size.x - 2 * totalBorderPadding , size.y - 2 * totalBorderPadding }
@@ -33,10 +59,10 @@ public:
         background.setFillColor({ sf::Color::Magenta });
         background.setOutlineColor(sf::Color::Red);
         background.setOutlineThickness(-border);
-        target.draw(background, getTransform());
+        target.draw(background, transform);
 
         // Draw component
-        mShape->DrawIcon(target, getTransform(), localBounds);
+        mShape->DrawIcon(target, transform, localBounds);
     }
 
     Component* CreateShape(ICircuitBoardNavigator* navigator)
@@ -44,10 +70,14 @@ public:
         return mShape->CreateShape(navigator);
     }
 
+    const Component* GetPrototype() const { return mShape.get(); }
+
 private:
     std::unique_ptr<Component> mShape;
 };
 
+// Icons are rasterized once into an atlas when their factory is added, drawing the picker is then a
+// single batch of textured quads
 class ComponentPicker
 {
 public:
@@ -63,6 +93,21 @@ public:
             mSelectedComponent = 0;
         }
         mFactories.emplace_back(std::make_unique<ComponentFactory>(std::move(component)));
+
+        size_t factoryCount = mFactories.size();
+        if (factoryCount > mAtlasRows * AtlasColumns)
+        {
+            // Growing loses the texture contents, every icon is drawn again
+            mAtlasRows = std::max<size_t>(1, mAtlasRows * 2);
+            mIconAtlas.create(sf::Vector2u(sf::Vector2f(AtlasColumns, mAtlasRows) * ComponentFactory::IconSize));
+            mIconAtlas.clear(sf::Color::Transparent);
+            for (size_t index = 0; index + 1 < factoryCount; index++)
+            {
+                mFactories[index]->DrawIcon(mIconAtlas, GetIconCell(index).getPosition());
+            }
+        }
+        mFactories.back()->DrawIcon(mIconAtlas, GetIconCell(factoryCount - 1).getPosition());
+        mIconAtlas.display();
     }
 
     void StepForward() 
@@ -108,128 +153,45 @@ public:
 
     void Draw(sf::RenderTarget& target)
     {
-        mFactories[mSelectedComponent.value()]->Draw(target);
-    }
-
-private:
-    std::optional<size_t> mSelectedComponent;
-    std::vector<std::unique_ptr<ComponentFactory>> mFactories;
-    std::vector<IComponentPickerObserver*> mObservers;
-};
-
-class CircuitBoard : public ICircuitBoardNavigator
-{
-public:
-    CircuitBoard()
-        : mSelectedPin(nullptr)
-        , mGrid(10, 10)
-        , mGridSpacing(25)
-    {
-        assert(mGrid.x > 1 && mGrid.y > 1);
-        for (uint32_t index = 0; index < TotalPins(); index++)
-        {
-            mPins.emplace_back(index);
-        }
-        mSelectedPin = &mPins.at(0);
-    }
-
-    void AddComponent(Component* component)
-    {
-        mComponents.push_back(component);
-    }
-
-    ConnectionConnector CollectConnections(const Component* newComponent)
-    {
-        ConnectionConnector connectionConnector;
-        for (Component* component : mComponents)
-        {
-            newComponent->CollectConnections(*component, connectionConnector);
-        }
-        return connectionConnector;
-    }
-
-    void UpdateSelectedPin(sf::Vector2f cursorWorldCoord)
-    {
-        float nearestGridX = std::round(cursorWorldCoord.x / mGridSpacing) * mGridSpacing;
-        float nearestGridY = std::round(cursorWorldCoord.y / mGridSpacing) * mGridSpacing;
-
-        nearestGridX = std::clamp(nearestGridX, 0.0f, (mGrid.x - 1) * mGridSpacing);
-        nearestGridY = std::clamp(nearestGridY, 0.0f, (mGrid.y - 1) * mGridSpacing);
-
-        uint32_t indexX = nearestGridX / mGridSpacing;
-        uint32_t indexY = nearestGridY / mGridSpacing;
-
-        mSelectedPin = &mPins.at(Get1DPinIndex(indexX, indexY));
+        sf::FloatRect cell = GetIconCell(mSelectedComponent.value());
+        sf::Vector2f size = cell.getSize();
+        sf::Vector2f topLeft = cell.getPosition();
+        sf::Vertex quad[] = {
+            { { 0, 0 }, sf::Color::White, topLeft },
+            { { size.x, 0 }, sf::Color::White, topLeft + sf::Vector2f(size.x, 0) },
+            { size, sf::Color::White, topLeft + size },
+            { { 0, 0 }, sf::Color::White, topLeft },
+            { size, sf::Color::White, topLeft + size },
+            { { 0, size.y }, sf::Color::White, topLeft + sf::Vector2f(0, size.y) }
+        };
+        target.draw(quad, 6, sf::PrimitiveType::Triangles, sf::RenderStates(&mIconAtlas.getTexture()));
     }
 
-    void Draw(sf::RenderTarget& target)
+    std::vector<const Component*> GetPrototypes() const
     {
-        for (uint32_t indexY = 0; indexY < mGrid.y; indexY++)
-        {
-            for (uint32_t indexX = 0; indexX < mGrid.x; indexX++)
-            {
-                sf::Vector2f position = sf::Vector2f(indexX, indexY) * mGridSpacing;
-                DrawPoint(target, position, 4, sf::Color::Cyan);
-            }
-        }
-
-        for (Component* component : mComponents)
-        {
-            component->DrawComponent(target);
-        }
-
-        if (mSelectedPin)
+        std::vector<const Component*> prototypes;
+        for (const auto& factory : mFactories)
         {
-            DrawPoint(target, GetGridCoordinateFromPin(*mSelectedPin), 4, sf::Color::White);
+            prototypes.push_back(factory->GetPrototype());
         }
+        return prototypes;
     }
 
 private:
-    // ICircuitBoardNavigator interface
-    virtual Pin& GetSelectedPin()
-    {
-        return *mSelectedPin;
-    }
-
-    virtual Pin* GetSurroundingPin(Pin& pin, sf::Vector2i offset)  // rename to neahbor
+    // Atlas pixels of the icon of a factory
+    sf::FloatRect GetIconCell(size_t factoryIndex) const
     {
-        sf::Vector2i newIndex = sf::Vector2i(Get2DPinIndex(pin.GetId()));
-        newIndex += offset;
-        if (newIndex.x < 0 || newIndex.x >= mGrid.x || newIndex.y < 0 || newIndex.y >= mGrid.y)
-        {
-            return nullptr;
-        }
-        return &mPins.at(Get1DPinIndex(static_cast<uint32_t>(newIndex.x), static_cast<uint32_t>(newIndex.y)));
-    }
-
-    virtual sf::Vector2f GetGridCoordinateFromPin(Pin& pin)
-    {
-        sf::Vector2u index = Get2DPinIndex(pin.GetId());
-        return sf::Vector2f(index) * mGridSpacing;
-    }
-
-    uint32_t Get1DPinIndex(uint32_t xIndex, uint32_t yIndex)
-    {
-        return xIndex + yIndex * mGrid.x;
+        sf::Vector2f position(factoryIndex % AtlasColumns, factoryIndex / AtlasColumns);
+        return sf::FloatRect(position * ComponentFactory::IconSize, { ComponentFactory::IconSize, ComponentFactory::IconSize });
     }
 
-    sf::Vector2u Get2DPinIndex(uint32_t index)
-    {
-        uint32_t xIndex = index % mGrid.y;
-        uint32_t yIndex = index / mGrid.y;
-        return { xIndex, yIndex };
-    }
-
-    uint32_t TotalPins()
-    {
-        return mGrid.x * mGrid.y;
-    }
+    static constexpr size_t AtlasColumns = 16;
 
-    std::vector<Component*> mComponents;
-    Pin* mSelectedPin;
-    std::vector<Pin> mPins;
-    sf::Vector2i mGrid;
-    float mGridSpacing;
+    std::optional<size_t> mSelectedComponent;
+    std::vector<std::unique_ptr<ComponentFactory>> mFactories;
+    std::vector<IComponentPickerObserver*> mObservers;
+    sf::RenderTexture mIconAtlas;
+    size_t mAtlasRows{ 0 };
 };
 
 class CircuitBoardManipulator
@@ -238,22 +200,37 @@ public:
     void SetCircuitBoard(CircuitBoard* circuitBoard)
     {
         mCircuitBoard = circuitBoard;
+        mIsPreviewValid = false;
     }
 
     void CreateComponent(Component* newComponent)
     {        
         mNewComponent = newComponent;
         mCntPin = mNewComponent->GetSelectedNode();
+        mIsPreviewValid = false;
     }
 
-    void MoveComponent()
+    // Moves the component and collects its connections only when the snapped pin, the nodes placed so far
+    // or the board changed since the last time, true when it did
+    bool MoveComponent()
     {        
         assert(mCircuitBoard);
-        if (mNewComponent != nullptr)
+        if (mNewComponent == nullptr)
+        {
+            return false;
+        }
+
+        PreviewKey key{ mCircuitBoard->GetSelectedPinId(), mNewComponent->GetNodes().size(), mCircuitBoard->GetPlacementRevision() };
+        if (mIsPreviewValid && key == mPreviewKey)
         {
-            mNewComponent->Move();
-            mConnectionConnector = mCircuitBoard->CollectConnections(mNewComponent);
+            return false;
         }
+
+        mNewComponent->Move();
+        mCircuitBoard->CollectConnections(mNewComponent, mConnectionConnector);
+        mPreviewKey = key;
+        mIsPreviewValid = true;
+        return true;
     }
 
     Component* TryPlaceComponent()
@@ -271,8 +248,8 @@ public:
                 if (mConnectionConnector.IsPlaceable())
                 {
                     placedComponent = mNewComponent;
-                    mConnectionConnector.Connect();                                        
                     mCircuitBoard->AddComponent(mNewComponent);
+                    mCircuitBoard->AddConnections(mConnectionConnector);
                     mNewComponent = nullptr;                    
                 }
                 else
@@ -289,7 +266,8 @@ public:
     {
         if (mNewComponent)
         {
-            mNewComponent->DrawComponent(target);
+            TargetCanvas canvas(target);
+            mNewComponent->DrawComponent(canvas);
             mNewComponent->DebugDraw(target);
         }
     }    
@@ -302,6 +280,14 @@ public:
         }
     }
 
+    void CancelComponent()
+    {
+        delete mNewComponent;
+        mNewComponent = nullptr;
+        mConnectionConnector.Reset();
+        mIsPreviewValid = false;
+    }
+
     bool IsManipulatingComponent() 
     { 
         return mNewComponent != nullptr;  
@@ -313,7 +299,22 @@ public:
     }
 
 private:
+    // What the preview was computed for
+    struct PreviewKey
+    {
+        uint32_t mSelectedPinId;
+        size_t mNodeCount;
+        uint64_t mPlacementRevision;
+
+        bool operator==(const PreviewKey& other) const
+        {
+            return mSelectedPinId == other.mSelectedPinId && mNodeCount == other.mNodeCount && mPlacementRevision == other.mPlacementRevision;
+        }
+    };
+
     ConnectionConnector mConnectionConnector;
+    PreviewKey mPreviewKey{};
+    bool mIsPreviewValid{ false };
     CircuitBoard* mCircuitBoard{ nullptr };
     Component* mNewComponent{ nullptr };
     Node* mPrvPin{ nullptr };
@@ -324,17 +325,25 @@ class CircuitBoardController : public IComponentPickerObserver
 {
 public:
     CircuitBoardController()
+        : mCircuitBoard(std::make_unique<CircuitBoard>())
     {
-        mCircuitBoardManipulator.SetCircuitBoard(&mCircuitBoard);
+        mCircuitBoardManipulator.SetCircuitBoard(mCircuitBoard.get());
     }
 
-    void Update(sf::Vector2f cursorWorldCoord)
+    ~CircuitBoardController()
     {
-        mCircuitBoard.UpdateSelectedPin(cursorWorldCoord);
+        if (IsRunningTask())
+        {
+            JoinTask();
+        }
+    }
 
-        mCircuitBoardManipulator.MoveComponent();
+    void Update(sf::Vector2f cursorWorldCoord)
+    {
+        mCursorWorldCoord = cursorWorldCoord;
+        mCircuitBoard->UpdateSelectedPin(cursorWorldCoord);
 
-        if (mCircuitBoardManipulator.IsManipulatingComponent())
+        if (mCircuitBoardManipulator.MoveComponent())
         {
             if (mCircuitBoardManipulator.IsComponentPlaceable())
             {
@@ -345,160 +354,1036 @@ public:
                 mCircuitBoardManipulator.SetComponentColor(sf::Color::Cyan);
             }
         }
+
+        if (mCircuitBoardManipulator.IsManipulatingComponent())
+        {
+            mHoveredComponentId.reset();
+        }
+        else
+        {
+            mHoveredComponentId = mCircuitBoard->FindComponentAt(cursorWorldCoord);
+        }
+
+        PostCircuitEdits();
+        CollectCheckpoints();
     }
 
     void TryPlaceComponent()
     {
+        if (IsBoardReadOnly())
+        {
+            return;
+        }
+
         if (Component* component = mCircuitBoardManipulator.TryPlaceComponent())
         {
             component->SetColor(sf::Color::White);
+            PostCircuitEdits();
         }
     }
 
-    void Draw(sf::RenderTarget& target)
+    // Scales the value of the hovered element, a running simulation takes it at its next step
+    void ScaleHoveredValue(double factor)
     {
-        mCircuitBoard.Draw(target);
-        mCircuitBoardManipulator.Draw(target);
+        if (IsBoardReadOnly() || !mHoveredComponentId.has_value())
+        {
+            return;
+        }
+
+        uint32_t componentId = mHoveredComponentId.value();
+        const Component& component = mCircuitBoard->GetComponent(componentId);
+        if (component.GetElementKind() == ElementKind::None)
+        {
+            return;
+        }
+
+        double value = component.GetValue() * factor;
+        mCircuitBoard->SetComponentValue(componentId, value);
+        if (mSimulation.IsRunning())
+        {
+            mPendingValueCommands.push_back(SimulationCommand::SetValue(componentId, value));
+            PostCircuitEdits();
+        }
     }
 
-    // IComponentPickerObserver interface
-    virtual void OnCreateNewComponent(ComponentFactory* factory) override
+    // Selection boxes start on empty board as well as on components, but not while placing one
+    void BeginSelection()
     {
-        Component* newComponent = factory->CreateShape(&mCircuitBoard);
-        mCircuitBoardManipulator.CreateComponent(newComponent);
+        if (!mCircuitBoardManipulator.IsManipulatingComponent())
+        {
+            mSelectionStart = mCursorWorldCoord;
+        }
     }
 
-private:
-    CircuitBoard mCircuitBoard;
-    CircuitBoardManipulator mCircuitBoardManipulator;
-};
+    // A box too small to be dragged selects the topmost component under the cursor
+    void EndSelection()
+    {
+        if (!mSelectionStart.has_value())
+        {
+            return;
+        }
 
-class ViewController
-{
-public:
-    ViewController(sf::RenderWindow& window, sf::View& view)
-        : mWindow(window)
-        , mView(view)
-        , mZoomFactor(1.0f)
-        , mZoomSpeed(0.1f)
-        , mZoomMin(0.3f)
-        , mZoomMax(1.7f)
-    { }
+        sf::FloatRect selectionBox = GetSelectionBox();
+        mSelectionStart.reset();
 
-    void StartPan(const sf::Vector2i& mousePosition)
+        float clickSize = mCircuitBoard->GetGridSpacing() / 4.0f;
+        if (selectionBox.width < clickSize && selectionBox.height < clickSize)
+        {
+            mSelectedComponentIds.clear();
+            if (std::optional<uint32_t> componentId = mCircuitBoard->FindComponentAt(mCursorWorldCoord))
+            {
+                mSelectedComponentIds.push_back(componentId.value());
+            }
+            return;
+        }
+
+        mCircuitBoard->FindComponentsIn(selectionBox, mSelectedComponentIds);
+    }
+
+    void ClearSelection()
     {
-        mLastPanPosition = mousePosition;
+        mSelectionStart.reset();
+        mSelectedComponentIds.clear();
     }
 
-    void UpdatePan()
-    {        
-        sf::Vector2i mousePosition = sf::Mouse::getPosition(mWindow);
+    // DC operating point of the whole board, a board still loading is incomplete
+    void SolveCircuit()
+    {
+        if (IsLoading() || IsBoardReadOnly())
+        {
+            return;
+        }
 
-        // Convert the last pan position and current mouse position to world coordinates
-        sf::Vector2f worldLastPanPosition = mWindow.mapPixelToCoords(mLastPanPosition, mView);
-        sf::Vector2f worldMousePosition = mWindow.mapPixelToCoords(mousePosition, mView);
+        mCircuitSolver.Solve(*mCircuitBoard);
+        mSolvedRevision = mCircuitBoard->GetRevision();
+    }
 
-        // Calculate the pan offset in world coordinates
-        sf::Vector2f panOffsetWorld = worldLastPanPosition - worldMousePosition;
-        mView.move(panOffsetWorld);
+    // Switches whether the partitions too large to factor are solved iteratively, from the next solve or start
+    void ToggleSolverMode()
+    {
+        if (IsBoardReadOnly())
+        {
+            return;
+        }
 
-        // Update the last pan position (in screen coordinates)
-        mLastPanPosition = mousePosition;     
+        bool isIterative = mCircuitBoard->GetSolverMode() == SolverMode::Iterative;
+        mCircuitBoard->SetSolverMode(isIterative ? SolverMode::Dense : SolverMode::Iterative);
     }
 
-    void ZoomIn() { Zoom(-mZoomSpeed); }
-    void ZoomOut() { Zoom(mZoomSpeed); }
+    SolverMode GetSolverMode() const { return mCircuitBoard->GetSolverMode(); }
 
-    sf::Vector2f MapPixelToCoords(sf::Vector2i pixel)
-    {        
-        return mWindow.mapPixelToCoords(pixel, mView);
+    // Null until the board is solved and after it changed
+    const CircuitSolveStats* GetSolveStats() const
+    {
+        return IsSolved() ? &mCircuitSolver.GetStats() : nullptr;
     }
 
-private:
-    void Zoom(float zoomSpeed)
+    // Voltage across the terminals of the hovered element, none when its partition was not solved. False
+    // when no element is hovered.
+    bool GetHoveredVoltage(std::optional<double>& outVoltage)
     {
-        sf::Vector2i mousePosition = sf::Mouse::getPosition(mWindow);
+        if (!IsSolved() || !mHoveredComponentId.has_value())
+        {
+            return false;
+        }
 
-        // Zoom 
-        sf::Vector2f mouseWorldBeforeZoom = mWindow.mapPixelToCoords(mousePosition, mView);
-        mView.zoom(1.0f / mZoomFactor);  // Reset zoom factor to 1.0f
-        mZoomFactor = Clamp(mZoomFactor + zoomSpeed, mZoomMin, mZoomMax);
-        mView.zoom(mZoomFactor);
+        uint32_t componentId = mHoveredComponentId.value();
+        const Component& component = mCircuitBoard->GetComponent(componentId);
+        if (component.GetElementKind() == ElementKind::None)
+        {
+            return false;
+        }
 
-        // Ensure same pixel is zoomed in/out on
-        sf::Vector2f mouseWorldAfterZoom = mWindow.mapPixelToCoords(mousePosition, mView);
-        sf::Vector2f adjustment = mouseWorldBeforeZoom - mouseWorldAfterZoom;
-        mView.move(adjustment);
+        auto [firstPinId, secondPinId] = component.GetTerminalPinIds();
+        std::optional<double> firstVoltage = mCircuitSolver.GetVoltage(*mCircuitBoard, componentId, firstPinId);
+        std::optional<double> secondVoltage = mCircuitSolver.GetVoltage(*mCircuitBoard, componentId, secondPinId);
+        outVoltage.reset();
+        if (firstVoltage.has_value() && secondVoltage.has_value())
+        {
+            outVoltage = firstVoltage.value() - secondVoltage.value();
+        }
+        return true;
     }
 
-    float Clamp(float value, float minValue, float maxValue)
+    // Probes the first terminal of the hovered element, or removes the probe already there. Probes take
+    // effect when the next simulation starts.
+    void ToggleProbe()
     {
-        return std::max(minValue, std::min(value, maxValue));
-    }
-
-    sf::RenderWindow& mWindow;
-    sf::View& mView;
-    float mZoomFactor;
-    float mZoomSpeed;
-    float mZoomMin;
-    float mZoomMax;
-    sf::Vector2i mLastPanPosition;    
-};
+        if (!mHoveredComponentId.has_value())
+        {
+            return;
+        }
 
-class Application
-{
-public:
-    Application()
-        : mWindow(sf::VideoMode(sf::Vector2u(1600, 960), 32), "SFML works!")        
-    {        
-        mView = mWindow.getDefaultView();
-        mHUDView = mWindow.getDefaultView();
+        uint32_t componentId = mHoveredComponentId.value();
+        const Component& component = mCircuitBoard->GetComponent(componentId);
+        if (component.GetElementKind() == ElementKind::None)
+        {
+            return;
+        }
 
-        mViewController = std::make_unique<ViewController>(mWindow, mView);
-        mComponentPicker.Subscribe(&mCircuitBoardController);
-        mComponentPicker.AddComponent(std::make_unique<LightBulb>());
+        auto probe = std::find_if(mProbes.begin(), mProbes.end(), [&](const Probe& probe) { return probe.mComponentId == componentId; });
+        if (probe != mProbes.end())
+        {
+            mProbes.erase(probe);
+        }
+        else if (mProbes.size() < Simulation::MaxProbes)
+        {
+            mProbes.push_back({ componentId, component.GetTerminalPinIds().first });
+        }
     }
 
-    void Run()
+    // Frequency response of the probes to the hovered source, written to a CSV file a point at a time. The
+    // circuit is taken from the board right away, the points are solved and written by a background task.
+    void SweepFrequencies(const std::string& filePath)
     {
-        bool isMiddleButtonPressed = false;
+        if (IsLoading() || IsRunningTask() || !mHoveredComponentId.has_value() || mProbes.empty())
+        {
+            return;
+        }
 
-        while (mWindow.isOpen())
+        AcSweepSettings settings;
+        settings.mSourceComponentId = mHoveredComponentId.value();
+        std::string error;
+        auto analysis = std::make_shared<AcAnalysis>(mJobSystem);
+        if (!analysis->Prepare(*mCircuitBoard, mProbes, settings, error))
         {
-            sf::Vector2i mousePosition = sf::Mouse::getPosition(mWindow);            
-            bool isLeftButtonJustReleased = false;
-            bool createShape = false;      
+            std::cerr << "AC sweep failed: " << error << std::endl;
+            return;
+        }
 
-            sf::Event event;
-            while (mWindow.pollEvent(event))
-            {
-                if (event.type == sf::Event::Closed)
-                {
-                    mWindow.close();
-                }
+        std::FILE* file = std::fopen(filePath.c_str(), "w");
+        if (file == nullptr)
+        {
+            std::cerr << "Cannot create " << filePath << std::endl;
+            return;
+        }
 
-                // Pan
-                if (event.type == sf::Event::MouseButtonPressed)
+        // Columns are named after the probed component and pin
+        std::fprintf(file, "frequency");
+        for (const Probe& probe : mProbes)
+        {
+            std::fprintf(file, ",magnitude %u.%u,phase %u.%u", probe.mComponentId, probe.mComponentPinId, probe.mComponentId, probe.mComponentPinId);
+        }
+        std::fprintf(file, "\n");
+
+        auto pointCount = std::make_shared<std::atomic<uint32_t>>(0);
+        size_t probeCount = mProbes.size();
+        StartTask("SWEEPING", false, [pointCount, settings]()
+        {
+            return static_cast<float>(pointCount->load()) / settings.mPointCount;
+        },
+        [analysis, pointCount, file, probeCount]()
+        {
+            std::string error;
+            bool isSwept = analysis->Run([&](double frequency, const std::complex<double>* probeVoltages)
+            {
+                std::fprintf(file, "%g", frequency);
+                for (size_t probe = 0; probe < probeCount; probe++)
                 {
-                    if (event.mouseButton.button == sf::Mouse::Button::Middle)
-                    {                
-                        mViewController->StartPan(mousePosition);
-                        isMiddleButtonPressed = true;                        
-                    } 
+                    std::fprintf(file, ",%g,%g", std::abs(probeVoltages[probe]), std::arg(probeVoltages[probe]) * 180.0 / 3.14159265358979323846);
                 }
+                std::fprintf(file, "\n");
+                (*pointCount)++;
+            }, error);
+            std::fclose(file);
 
-                if (event.type == sf::Event::MouseButtonReleased)
-                {
-                    if (event.mouseButton.button == sf::Mouse::Button::Middle)
-                    {
-                        isMiddleButtonPressed = false;
-                    }
+            if (!isSwept)
+            {
+                std::cerr << "AC sweep failed: " << error << std::endl;
+            }
+        });
+    }
 
-                    if (event.mouseButton.button == sf::Mouse::Button::Left)
-                    {
-                        isLeftButtonJustReleased = true;
-                    }
-                }
+    // The whole board at one pixel per unit, whatever part of it is on screen. The export reads the board
+    // on a background task, the board takes no edits until it is done.
+    void ExportImage(const std::string& filePath)
+    {
+        if (IsLoading() || IsRunningTask())
+        {
+            return;
+        }
+
+        auto exporter = std::make_shared<BoardImageExporter>(mJobSystem);
+        const CircuitBoard* circuitBoard = mCircuitBoard.get();
+        StartTask("EXPORTING", true, [exporter]()
+        {
+            return exporter->GetProgress();
+        },
+        [exporter, circuitBoard, filePath]()
+        {
+            std::string error;
+            if (!exporter->Export(*circuitBoard, filePath, BoardImageSettings(), error))
+            {
+                std::cerr << "Image export failed: " << error << std::endl;
+            }
+        });
+    }
+
+    void ToggleSimulation()
+    {
+        if (mSimulation.IsRunning())
+        {
+            mSimulation.Stop();
+            return;
+        }
+
+        std::string error;
+        if (!IsLoading() && !mSimulation.Start(*mCircuitBoard, mProbes, "waveforms.cswf", error))
+        {
+            std::cerr << "Simulation failed to start: " << error << std::endl;
+            return;
+        }
+
+        mPostedComponentCount = mCircuitBoard->GetComponentCount();
+        mPostedConnectionCount = mCircuitBoard->GetConnectionCount();
+        mPendingValueCommands.clear();
+    }
+
+    // The checkpoint arrives a step later, it is kept for resuming and written to disk
+    void CheckpointSimulation()
+    {
+        if (mSimulation.IsRunning())
+        {
+            mSimulation.PostCommand(SimulationCommand::Checkpoint(mSimulation.GetTime()));
+        }
+    }
+
+    // Restarts the simulation from the last checkpoint, or from the checkpoint file when there is none. The
+    // board must start with the components and connections of the checkpoint, the ones added since and the
+    // values changed since are then posted to the resumed run.
+    void ResumeSimulation()
+    {
+        std::string error;
+        if (!mCheckpoint)
+        {
+            mCheckpoint = ReadCheckpointFile(mCheckpointPath, error);
+            if (!mCheckpoint)
+            {
+                std::cerr << "Reading checkpoint failed: " << error << std::endl;
+                return;
+            }
+        }
+
+        const SimulationState& state = mCheckpoint->mState;
+        size_t componentCount = state.mNetwork.GetComponentCount();
+        size_t connectionCount = state.mNetwork.GetConnectionCount();
+        if (IsLoading() || componentCount > mCircuitBoard->GetComponentCount() || connectionCount > mCircuitBoard->GetConnectionCount()
+            || !(BoardFingerprint::Of(*mCircuitBoard, componentCount, connectionCount) == state.mFingerprint))
+        {
+            std::cerr << "The checkpoint does not belong to this board" << std::endl;
+            return;
+        }
+
+        mSimulation.SetSolverMode(mCircuitBoard->GetSolverMode());
+        if (!mSimulation.Start(*mCheckpoint, "waveforms.cswf", error))
+        {
+            std::cerr << "Simulation failed to resume: " << error << std::endl;
+            return;
+        }
+
+        mProbes = state.mProbes;
+        mPostedComponentCount = componentCount;
+        mPostedConnectionCount = connectionCount;
+        mPendingValueCommands.clear();
+        for (uint32_t componentId = 0; componentId < componentCount; componentId++)
+        {
+            std::optional<double> value = state.GetComponentValue(componentId);
+            double boardValue = mCircuitBoard->GetComponent(componentId).GetValue();
+            if (value.has_value() && value.value() != boardValue)
+            {
+                mPendingValueCommands.push_back(SimulationCommand::SetValue(componentId, boardValue));
+            }
+        }
+        PostCircuitEdits();
+    }
+
+    Simulation& GetSimulation() { return mSimulation; }
+
+    // First call marks the start pin, second call auto-routes a wire to the selected pin
+    void MarkWireEndpoint()
+    {
+        // Routes could cross tiles that are not loaded yet
+        if (IsLoading() || IsBoardReadOnly())
+        {
+            return;
+        }
+
+        uint32_t selectedPinId = mCircuitBoard->GetSelectedPinId();
+        if (!mWireStartPinId.has_value())
+        {
+            mWireStartPinId = selectedPinId;
+            return;
+        }
+
+        mCircuitBoard->RouteWires({ { mWireStartPinId.value(), selectedPinId } });
+        mWireStartPinId.reset();
+    }
+
+    void Draw(sf::RenderTarget& target)
+    {
+        mCircuitBoard->Draw(target);
+        DrawSelection(target);
+        mCircuitBoardManipulator.Draw(target);
+    }
+
+    // The board is replaced right away and filled in by UpdateLoading over the following frames
+    bool LoadCircuitBoard(const std::string& filePath, const std::vector<const Component*>& prototypes)
+    {
+        if (IsBoardReadOnly())
+        {
+            return false;
+        }
+
+        std::string error;
+        auto boardLoader = std::make_unique<BoardLoader>();
+        std::unique_ptr<CircuitBoard> circuitBoard = boardLoader->Open(filePath, prototypes, error);
+        if (!circuitBoard)
+        {
+            std::cerr << "Loading " << filePath << " failed: " << error << std::endl;
+            return false;
+        }
+
+        ReplaceCircuitBoard(std::move(circuitBoard), std::move(boardLoader));
+        return true;
+    }
+
+    // The netlist is imported into a new board over the following frames by UpdateLoading. The current board
+    // stays until the import is done, and when it fails.
+    bool ImportNetlist(const std::string& filePath, const std::vector<const Component*>& prototypes)
+    {
+        std::string error;
+        auto netlistImporter = std::make_unique<NetlistImporter>(prototypes);
+        if (!netlistImporter->Open(filePath, error))
+        {
+            std::cerr << "Importing " << filePath << " failed: " << error << std::endl;
+            return false;
+        }
+
+        mNetlistImporter = std::move(netlistImporter);
+        return true;
+    }
+
+    void UpdateLoading(const sf::FloatRect& visibleArea)
+    {
+        if (IsRunningTask() && mIsTaskDone)
+        {
+            JoinTask();
+        }
+
+        std::string error;
+        if (IsLoading() && !mBoardLoader->Update(visibleArea, mLoadingTimeBudget, error))
+        {
+            std::cerr << "Loading stopped: " << error << std::endl;
+        }
+
+        if (!mNetlistImporter)
+        {
+            return;
+        }
+
+        if (!mNetlistImporter->Update(mLoadingTimeBudget, error))
+        {
+            std::cerr << "Importing failed: " << error << std::endl;
+            mNetlistImporter.reset();
+        }
+        else if (!mNetlistImporter->IsImporting() && !IsBoardReadOnly())
+        {
+            ReplaceCircuitBoard(mNetlistImporter->TakeCircuitBoard(), nullptr);
+        }
+    }
+
+    bool IsLoading() const { return mBoardLoader && mBoardLoader->IsLoading(); }
+    // Nothing to load, write out or hand to the simulation, a frame of it should not allocate
+    bool IsIdle() const { return !IsLoading() && !IsImporting() && !IsRunningTask() && mNewCheckpoints.empty() && mPendingValueCommands.empty(); }
+    float GetLoadingProgress() const { return mBoardLoader ? mBoardLoader->GetProgress() : 1.0f; }
+    bool IsImporting() const { return mNetlistImporter != nullptr; }
+    float GetImportProgress() const { return mNetlistImporter ? mNetlistImporter->GetProgress() : 1.0f; }
+    bool IsRunningTask() const { return mTaskThread.joinable(); }
+    bool IsBoardReadOnly() const { return IsRunningTask() && mIsTaskReadingBoard; }
+    const char* GetTaskLabel() const { return mTaskLabel; }
+    float GetTaskProgress() const { return IsRunningTask() ? mGetTaskProgress() : 1.0f; }
+
+    const CircuitBoard& GetCircuitBoard() const { return *mCircuitBoard; }
+
+    // IComponentPickerObserver interface
+    virtual void OnCreateNewComponent(ComponentFactory* factory) override
+    {
+        Component* newComponent = factory->CreateShape(mCircuitBoard.get());
+        mCircuitBoardManipulator.CreateComponent(newComponent);
+    }
+
+private:
+    // Runs a long job on its own thread, which takes one of the job system's threads while it runs. There is
+    // one task at a time, UpdateLoading collects it once it is done. A task reading the board keeps it read
+    // only until then.
+    void StartTask(const char* label, bool isReadingBoard, std::function<float()> getProgress, std::function<void()> task)
+    {
+        mTaskLabel = label;
+        mIsTaskReadingBoard = isReadingBoard;
+        mGetTaskProgress = std::move(getProgress);
+        mIsTaskDone = false;
+        mJobSystem.ReserveThread();
+        mTaskThread = std::thread([this, task = std::move(task)]()
+        {
+            task();
+            mIsTaskDone = true;
+        });
+    }
+
+    void JoinTask()
+    {
+        mTaskThread.join();
+        mJobSystem.ReleaseThread();
+        mGetTaskProgress = nullptr;
+    }
+
+    // Hands the board edits made since the simulation started to it, in board order. What does not fit in
+    // the command queue is posted on a later call.
+    void PostCircuitEdits()
+    {
+        if (!mSimulation.IsRunning())
+        {
+            return;
+        }
+
+        for (; mPostedComponentCount < mCircuitBoard->GetComponentCount(); mPostedComponentCount++)
+        {
+            uint32_t componentId = static_cast<uint32_t>(mPostedComponentCount);
+            if (!mSimulation.PostCommand(SimulationCommand::AddComponent(componentId, mCircuitBoard->GetComponent(componentId))))
+            {
+                return;
+            }
+        }
+
+        for (; mPostedConnectionCount < mCircuitBoard->GetConnectionCount(); mPostedConnectionCount++)
+        {
+            if (!mSimulation.PostCommand(SimulationCommand::AddConnection(mCircuitBoard->GetConnection(mPostedConnectionCount))))
+            {
+                return;
+            }
+        }
+
+        size_t postedCount = 0;
+        while (postedCount < mPendingValueCommands.size() && mSimulation.PostCommand(mPendingValueCommands[postedCount]))
+        {
+            postedCount++;
+        }
+        mPendingValueCommands.erase(mPendingValueCommands.begin(), mPendingValueCommands.begin() + postedCount);
+    }
+
+    void CollectCheckpoints()
+    {
+        mNewCheckpoints.clear();
+        mSimulation.TakeCheckpoints(mNewCheckpoints);
+        for (std::shared_ptr<const SimulationCheckpoint>& checkpoint : mNewCheckpoints)
+        {
+            std::string error;
+            if (!WriteCheckpointFile(*checkpoint, mCheckpointPath, error))
+            {
+                std::cerr << "Writing checkpoint failed: " << error << std::endl;
+            }
+            mCheckpoint = std::move(checkpoint);
+        }
+    }
+
+    bool IsSolved() const
+    {
+        return mSolvedRevision.has_value() && mSolvedRevision.value() == mCircuitBoard->GetRevision();
+    }
+
+    sf::FloatRect GetSelectionBox() const
+    {
+        sf::Vector2f start = mSelectionStart.value();
+        sf::Vector2f min(std::min(start.x, mCursorWorldCoord.x), std::min(start.y, mCursorWorldCoord.y));
+        sf::Vector2f max(std::max(start.x, mCursorWorldCoord.x), std::max(start.y, mCursorWorldCoord.y));
+        return sf::FloatRect(min, max - min);
+    }
+
+    // Outlines of the selected components in view go into one batch, selections can be huge
+    void DrawSelection(sf::RenderTarget& target)
+    {
+        const sf::View& view = target.getView();
+        sf::FloatRect visibleArea(view.getCenter() - view.getSize() / 2.0f, view.getSize());
+
+        mSelectionVertices.clear();
+        for (uint32_t componentId : mSelectedComponentIds)
+        {
+            sf::FloatRect bounds = mCircuitBoard->GetComponentBounds(componentId);
+            if (bounds.left > visibleArea.left + visibleArea.width || bounds.left + bounds.width < visibleArea.left
+                || bounds.top > visibleArea.top + visibleArea.height || bounds.top + bounds.height < visibleArea.top)
+            {
+                continue;
+            }
+
+            sf::Vector2f corners[] = {
+                bounds.getPosition(),
+                { bounds.left + bounds.width, bounds.top },
+                bounds.getPosition() + bounds.getSize(),
+                { bounds.left, bounds.top + bounds.height }
+            };
+            for (size_t index = 0; index < 4; index++)
+            {
+                mSelectionVertices.emplace_back(corners[index], sf::Color(255, 140, 0));
+                mSelectionVertices.emplace_back(corners[(index + 1) % 4], sf::Color(255, 140, 0));
+            }
+        }
+        target.draw(mSelectionVertices.data(), mSelectionVertices.size(), sf::PrimitiveType::Lines);
+
+        for (const Probe& probe : mProbes)
+        {
+            DrawFloatRect(target, mCircuitBoard->GetComponentBounds(probe.mComponentId), sf::Color::Cyan);
+        }
+
+        if (mHoveredComponentId.has_value())
+        {
+            DrawFloatRect(target, mCircuitBoard->GetComponentBounds(mHoveredComponentId.value()), sf::Color::Yellow);
+        }
+
+        if (mSelectionStart.has_value())
+        {
+            DrawFloatRect(target, GetSelectionBox(), sf::Color::White);
+        }
+    }
+
+    void ReplaceCircuitBoard(std::unique_ptr<CircuitBoard> circuitBoard, std::unique_ptr<BoardLoader> boardLoader)
+    {
+        // The component being placed belongs to the old board
+        mCircuitBoardManipulator.CancelComponent();
+        mCircuitBoardManipulator.SetCircuitBoard(circuitBoard.get());
+        mBoardLoader.reset();
+        mCircuitBoard = std::move(circuitBoard);
+        mBoardLoader = std::move(boardLoader);
+        mNetlistImporter.reset();  // The newer board wins
+        mWireStartPinId.reset();
+        mHoveredComponentId.reset();
+        ClearSelection();
+        mCircuitSolver.Reset();
+        mSolvedRevision.reset();
+        mSimulation.Stop();
+        mProbes.clear();
+        mCheckpoint.reset();
+    }
+
+    std::unique_ptr<CircuitBoard> mCircuitBoard;
+    std::unique_ptr<BoardLoader> mBoardLoader;
+    sf::Time mLoadingTimeBudget{ sf::milliseconds(8) };
+    std::unique_ptr<NetlistImporter> mNetlistImporter;
+    CircuitBoardManipulator mCircuitBoardManipulator;
+    std::optional<uint32_t> mWireStartPinId;
+    sf::Vector2f mCursorWorldCoord;
+    std::optional<uint32_t> mHoveredComponentId;
+    std::optional<sf::Vector2f> mSelectionStart;
+    std::vector<uint32_t> mSelectedComponentIds;
+    TrackedVector<sf::Vertex, MemoryTag::RenderCaches> mSelectionVertices;
+    JobSystem& mJobSystem{ JobSystem::GetShared() };
+    CircuitSolver mCircuitSolver{ mJobSystem };
+    std::optional<uint64_t> mSolvedRevision;
+    std::vector<Probe> mProbes;
+    Simulation mSimulation{ mJobSystem };
+    size_t mPostedComponentCount{ 0 };
+    size_t mPostedConnectionCount{ 0 };
+    std::vector<SimulationCommand> mPendingValueCommands;
+    std::string mCheckpointPath{ "checkpoint.csck" };
+    std::shared_ptr<const SimulationCheckpoint> mCheckpoint;
+    const char* mTaskLabel{ "" };
+    std::function<float()> mGetTaskProgress;
+    bool mIsTaskReadingBoard{ false };
+    std::atomic<bool> mIsTaskDone{ false };
+    std::thread mTaskThread;
+    std::vector<std::shared_ptr<const SimulationCheckpoint>> mNewCheckpoints;
+};
+
+class ViewController
+{
+public:
+    ViewController(sf::RenderWindow& window, sf::View& view)
+        : mWindow(window)
+        , mView(view)
+        , mZoomFactor(1.0f)
+        , mZoomSpeed(0.1f)
+        , mZoomMin(0.3f)
+        , mZoomMax(1.7f)
+    { }
+
+    void StartPan(const sf::Vector2i& mousePosition)
+    {
+        mLastPanPosition = mousePosition;
+    }
+
+    void UpdatePan()
+    {        
+        sf::Vector2i mousePosition = sf::Mouse::getPosition(mWindow);
+
+        // Convert the last pan position and current mouse position to world coordinates
+        sf::Vector2f worldLastPanPosition = mWindow.mapPixelToCoords(mLastPanPosition, mView);
+        sf::Vector2f worldMousePosition = mWindow.mapPixelToCoords(mousePosition, mView);
+
+        // Calculate the pan offset in world coordinates
+        sf::Vector2f panOffsetWorld = worldLastPanPosition - worldMousePosition;
+        mView.move(panOffsetWorld);
+
+        // Update the last pan position (in screen coordinates)
+        mLastPanPosition = mousePosition;     
+    }
+
+    void ZoomIn() { Zoom(-mZoomSpeed); }
+    void ZoomOut() { Zoom(mZoomSpeed); }
+
+    sf::Vector2f MapPixelToCoords(sf::Vector2i pixel)
+    {        
+        return mWindow.mapPixelToCoords(pixel, mView);
+    }
+
+    sf::FloatRect GetVisibleArea() const
+    {
+        return sf::FloatRect(mView.getCenter() - mView.getSize() / 2.0f, mView.getSize());
+    }
+
+private:
+    void Zoom(float zoomSpeed)
+    {
+        sf::Vector2i mousePosition = sf::Mouse::getPosition(mWindow);
+
+        // Zoom 
+        sf::Vector2f mouseWorldBeforeZoom = mWindow.mapPixelToCoords(mousePosition, mView);
+        mView.zoom(1.0f / mZoomFactor);  // Reset zoom factor to 1.0f
+        mZoomFactor = Clamp(mZoomFactor + zoomSpeed, mZoomMin, mZoomMax);
+        mView.zoom(mZoomFactor);
+
+        // Ensure same pixel is zoomed in/out on
+        sf::Vector2f mouseWorldAfterZoom = mWindow.mapPixelToCoords(mousePosition, mView);
+        sf::Vector2f adjustment = mouseWorldBeforeZoom - mouseWorldAfterZoom;
+        mView.move(adjustment);
+    }
+
+    float Clamp(float value, float minValue, float maxValue)
+    {
+        return std::max(minValue, std::min(value, maxValue));
+    }
+
+    sf::RenderWindow& mWindow;
+    sf::View& mView;
+    float mZoomFactor;
+    float mZoomSpeed;
+    float mZoomMin;
+    float mZoomMax;
+    sf::Vector2i mLastPanPosition;    
+};
+
+class MemoryPanel
+{
+public:
+    void ToggleVisible() { mIsVisible = !mIsVisible; }
+
+    void Draw(sf::RenderTarget& target, sf::Vector2f position)
+    {
+        if (!mIsVisible)
+        {
+            return;
+        }
+
+        // Counters change every frame, refreshing the text a few times a second keeps it readable
+        if (mText.empty() || mRefreshClock.getElapsedTime().asSeconds() > 0.5f)
+        {
+            RefreshText();
+            mRefreshClock.restart();
+        }
+        DrawLabel(target, position, mText, 2.0f, sf::Color::White);
+    }
+
+private:
+    void RefreshText()
+    {
+        mText.clear();
+
+        char line[96];
+        int64_t totalBytes = 0;
+        for (size_t index = 0; index < static_cast<size_t>(MemoryTag::Count); index++)
+        {
+            MemoryTag tag = static_cast<MemoryTag>(index);
+            MemoryTagStats stats = MemoryTracker::GetStats(tag);
+            totalBytes += stats.mBytes;
+
+            std::snprintf(line, sizeof(line), "%-14s %9.2f MB  PEAK %9.2f MB\n",
+                MemoryTracker::GetTagName(tag), ToMegabytes(stats.mBytes), ToMegabytes(stats.mPeakBytes));
+            mText += line;
+        }
+
+        std::snprintf(line, sizeof(line), "%-14s %9.2f MB", "Total", ToMegabytes(totalBytes));
+        mText += line;
+    }
+
+    static double ToMegabytes(int64_t bytes)
+    {
+        return static_cast<double>(bytes) / (1024.0 * 1024.0);
+    }
+
+    bool mIsVisible{ false };
+    std::string mText;
+    sf::Clock mRefreshClock;
+};
+
+// Oscilloscope traces of the probes of the running simulation, stacked down the right edge of the HUD
+class ProbePlotPanel
+{
+public:
+    // Drains the probe queues, a trace starts over when the simulation restarts
+    void Update(Simulation& simulation)
+    {
+        if (!simulation.IsRunning())
+        {
+            mTraces.clear();
+            return;
+        }
+
+        mTraces.resize(simulation.GetProbeCount());
+        mVertices.reserve(2 * HistoryLength * mTraces.size());
+        for (size_t probe = 0; probe < mTraces.size(); probe++)
+        {
+            Trace& trace = mTraces[probe];
+            ProbeSample sample;
+            while (simulation.GetProbeQueue(probe).TryPop(sample))
+            {
+                if (trace.mCount > 0 && sample.mTime < trace.mSamples[(trace.mNext + HistoryLength - 1) % HistoryLength].mTime)
+                {
+                    trace.mCount = 0;
+                    trace.mNext = 0;
+                }
+                trace.mSamples[trace.mNext] = sample;
+                trace.mNext = (trace.mNext + 1) % HistoryLength;
+                trace.mCount = std::min(trace.mCount + 1, HistoryLength);
+            }
+        }
+    }
+
+    void Draw(sf::RenderTarget& target)
+    {
+        sf::Vector2f position(target.getView().getSize().x - PlotWidth - 10.0f, 10.0f);
+        mVertices.clear();
+        for (size_t probe = 0; probe < mTraces.size(); probe++)
+        {
+            const Trace& trace = mTraces[probe];
+            sf::FloatRect plot({ position.x, position.y + probe * (PlotHeight + 20.0f) + 12.0f }, { PlotWidth, PlotHeight });
+            DrawFloatRect(target, plot, sf::Color(80, 80, 80));
+            if (trace.mCount == 0)
+            {
+                continue;
+            }
+
+            // Scaled to the range of the visible history, unsolved samples are NaN and left out
+            size_t first = (trace.mNext + HistoryLength - trace.mCount) % HistoryLength;
+            float minimum = std::numeric_limits<float>::infinity();
+            float maximum = -std::numeric_limits<float>::infinity();
+            for (size_t index = 0; index < trace.mCount; index++)
+            {
+                const ProbeSample& sample = trace.mSamples[(first + index) % HistoryLength];
+                minimum = std::min(minimum, sample.mMinimum);
+                maximum = std::max(maximum, sample.mMaximum);
+            }
+            float range = std::max(maximum - minimum, 1e-6f);
+
+            auto toY = [&](float value) { return plot.top + plot.height - 2.0f - (value - minimum) / range * (plot.height - 4.0f); };
+            for (size_t index = 0; index < trace.mCount; index++)
+            {
+                const ProbeSample& sample = trace.mSamples[(first + index) % HistoryLength];
+                if (std::isnan(sample.mMinimum))
+                {
+                    continue;
+                }
+
+                float x = plot.left + (HistoryLength - trace.mCount + index) * PlotWidth / HistoryLength;
+                mVertices.emplace_back(sf::Vector2f(x, toY(sample.mMaximum)), sf::Color::Green);
+                mVertices.emplace_back(sf::Vector2f(x, toY(sample.mMinimum) + 1.0f), sf::Color::Green);
+            }
+
+            const ProbeSample& latest = trace.mSamples[(trace.mNext + HistoryLength - 1) % HistoryLength];
+            char label[64];
+            if (std::isnan(latest.mMaximum))
+            {
+                std::snprintf(label, sizeof(label), "P%zu UNSOLVED  T %.1f S", probe + 1, latest.mTime);
+            }
+            else
+            {
+                std::snprintf(label, sizeof(label), "P%zu %.4g V  T %.1f S", probe + 1, latest.mMaximum, latest.mTime);
+            }
+            DrawLabel(target, { plot.left, plot.top - 12.0f }, label, 2.0f, sf::Color::Green);
+        }
+        target.draw(mVertices.data(), mVertices.size(), sf::PrimitiveType::Lines);
+    }
+
+private:
+    static constexpr size_t HistoryLength = 400;
+    static constexpr float PlotWidth = 400.0f;
+    static constexpr float PlotHeight = 40.0f;
+
+    struct Trace
+    {
+        std::array<ProbeSample, HistoryLength> mSamples;
+        size_t mNext{ 0 };
+        size_t mCount{ 0 };
+    };
+
+    std::vector<Trace> mTraces;
+    TrackedVector<sf::Vertex, MemoryTag::RenderCaches> mVertices;
+};
+
+// Heap allocations the main thread made in each phase of the last frame, in builds that count them. A frame
+// without input and without loading, checkpoints or saves to handle is steady, debug builds assert it
+// allocates nothing while the panel is shown.
+class FrameAllocationPanel
+{
+public:
+    enum class Phase : uint8_t
+    {
+        Input,
+        Update,
+        Draw,
+        Count
+    };
+
+    void ToggleVisible() { mIsVisible = !mIsVisible; }
+
+    void BeginFrame()
+    {
+        mPhaseStart = MemoryTracker::GetThreadAllocations();
+    }
+
+    void EndPhase(Phase phase)
+    {
+        AllocationCount now = MemoryTracker::GetThreadAllocations();
+        mCurrent[static_cast<size_t>(phase)] = now - mPhaseStart;
+        mPhaseStart = now;
+    }
+
+    void EndFrame(bool isSteady)
+    {
+        mLast = mCurrent;
+        if (mIsVisible && isSteady)
+        {
+            for (const AllocationCount& count : mLast)
+            {
+                assert(count.mAllocations == 0 && "Steady frame allocated");
+                (void)count;
+            }
+        }
+    }
+
+    void Draw(sf::RenderTarget& target, sf::Vector2f position)
+    {
+        if (!mIsVisible)
+        {
+            return;
+        }
+
+        if (!MemoryTracker::IsCountingAllocations)
+        {
+            DrawLabel(target, position, "ALLOCATIONS ARE NOT COUNTED IN THIS BUILD", 2.0f, sf::Color::White);
+            return;
+        }
+
+        static constexpr const char* PhaseNames[] = { "INPUT", "UPDATE", "DRAW" };
+        char text[160];
+        int length = 0;
+        for (size_t phase = 0; phase < static_cast<size_t>(Phase::Count); phase++)
+        {
+            length += std::snprintf(text + length, sizeof(text) - length, "%-8s %6llu ALLOCS %9llu B\n", PhaseNames[phase],
+                static_cast<unsigned long long>(mLast[phase].mAllocations), static_cast<unsigned long long>(mLast[phase].mBytes));
+        }
+        DrawLabel(target, position, std::string_view(text, length - 1), 2.0f, sf::Color::White);
+    }
+
+private:
+    bool mIsVisible{ false };
+    AllocationCount mPhaseStart;
+    std::array<AllocationCount, static_cast<size_t>(Phase::Count)> mCurrent{};
+    std::array<AllocationCount, static_cast<size_t>(Phase::Count)> mLast{};
+};
+
+class Application
+{
+public:
+    Application()
+        : mWindow(sf::VideoMode(sf::Vector2u(1600, 960), 32), "SFML works!")        
+    {        
+        mView = mWindow.getDefaultView();
+        mHUDView = mWindow.getDefaultView();
+
+        mViewController = std::make_unique<ViewController>(mWindow, mView);
+        mComponentPicker.Subscribe(&mCircuitBoardController);
+        mComponentPicker.AddComponent(std::make_unique<LightBulb>());
+        mComponentPicker.AddComponent(std::make_unique<Resistor>());
+        mComponentPicker.AddComponent(std::make_unique<Battery>());
+        mComponentPicker.AddComponent(std::make_unique<CurrentSource>());
+    }
+
+    void Run()
+    {
+        bool isMiddleButtonPressed = false;
+
+        while (mWindow.isOpen())
+        {
+            sf::Vector2i mousePosition = sf::Mouse::getPosition(mWindow);            
+            bool isLeftButtonJustPressed = false;
+            bool isLeftButtonJustReleased = false;
+            bool createShape = false;      
+            bool markWireEndpoint = false;
+            bool toggleMemoryPanel = false;
+            bool toggleAllocationPanel = false;
+            bool hadEvents = false;
+            bool saveBoard = false;
+            bool loadBoard = false;
+            bool importNetlist = false;
+            bool writeMemoryReport = false;
+            bool clearSelection = false;
+            bool solveCircuit = false;
+            bool toggleSimulation = false;
+            bool toggleSolverMode = false;
+            bool sweepFrequencies = false;
+            bool exportImage = false;
+            bool toggleProbe = false;
+            bool checkpointSimulation = false;
+            bool resumeSimulation = false;
+            std::optional<double> valueScale;
+
+            mFrameAllocationPanel.BeginFrame();
+
+            sf::Event event;
+            while (mWindow.pollEvent(event))
+            {
+                hadEvents = true;
+
+                if (event.type == sf::Event::Closed)
+                {
+                    mWindow.close();
+                }
+
+                // Pan
+                if (event.type == sf::Event::MouseButtonPressed)
+                {
+                    if (event.mouseButton.button == sf::Mouse::Button::Middle)
+                    {                
+                        mViewController->StartPan(mousePosition);
+                        isMiddleButtonPressed = true;                        
+                    } 
+
+                    if (event.mouseButton.button == sf::Mouse::Button::Left)
+                    {
+                        isLeftButtonJustPressed = true;
+                    }
+                }
+
+                if (event.type == sf::Event::MouseButtonReleased)
+                {
+                    if (event.mouseButton.button == sf::Mouse::Button::Middle)
+                    {
+                        isMiddleButtonPressed = false;
+                    }
+
+                    if (event.mouseButton.button == sf::Mouse::Button::Left)
+                    {
+                        isLeftButtonJustReleased = true;
+                    }
+                }
 
                 // Zoom
                 if (event.type == sf::Event::MouseWheelScrolled)
@@ -531,7 +1416,103 @@ public:
                 {
                     createShape = true;
                 }
+
+                // Wires
+                if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Key::W)
+                {
+                    markWireEndpoint = true;
+                }
+
+                // Selection
+                if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Key::Escape)
+                {
+                    clearSelection = true;
+                }
+
+                // Memory
+                if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Key::M)
+                {
+                    toggleMemoryPanel = true;
+                }
+
+                if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Key::F1)
+                {
+                    writeMemoryReport = true;
+                }
+
+                if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Key::F2)
+                {
+                    toggleAllocationPanel = true;
+                }
+
+                // Save and load
+                if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Key::F5)
+                {
+                    saveBoard = true;
+                }
+
+                if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Key::F9)
+                {
+                    loadBoard = true;
+                }
+
+                if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Key::F8)
+                {
+                    importNetlist = true;
+                }
+
+                // Simulation
+                if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Key::F6)
+                {
+                    solveCircuit = true;
+                }
+
+                if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Key::F7)
+                {
+                    toggleSimulation = true;
+                }
+
+                if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Key::F4)
+                {
+                    toggleSolverMode = true;
+                }
+
+                if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Key::F3)
+                {
+                    sweepFrequencies = true;
+                }
+
+                if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Key::F12)
+                {
+                    exportImage = true;
+                }
+
+                if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Key::P)
+                {
+                    toggleProbe = true;
+                }
+
+                if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Key::F10)
+                {
+                    checkpointSimulation = true;
+                }
+
+                if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Key::F11)
+                {
+                    resumeSimulation = true;
+                }
+
+                if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Key::PageUp)
+                {
+                    valueScale = 1.25;
+                }
+
+                if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Key::PageDown)
+                {
+                    valueScale = 0.8;
+                }
             }            
+            mFrameAllocationPanel.EndPhase(FrameAllocationPanel::Phase::Input);
 
             if (isMiddleButtonPressed)
             {
@@ -546,10 +1527,112 @@ public:
             sf::Vector2f cursorWorldCoord = mViewController->MapPixelToCoords(mousePosition);
             mCircuitBoardController.Update(cursorWorldCoord);
 
+            if (isLeftButtonJustPressed)
+            {
+                mCircuitBoardController.BeginSelection();
+            }
+
             if (isLeftButtonJustReleased)
             {
                 mCircuitBoardController.TryPlaceComponent();
+                mCircuitBoardController.EndSelection();
+            }
+
+            if (clearSelection)
+            {
+                mCircuitBoardController.ClearSelection();
+            }
+
+            if (markWireEndpoint)
+            {
+                mCircuitBoardController.MarkWireEndpoint();
+            }
+
+            if (loadBoard)
+            {
+                mCircuitBoardController.LoadCircuitBoard("board.csb", mComponentPicker.GetPrototypes());
+            }
+
+            if (importNetlist)
+            {
+                mCircuitBoardController.ImportNetlist("netlist.cir", mComponentPicker.GetPrototypes());
+            }
+
+            mCircuitBoardController.UpdateLoading(mViewController->GetVisibleArea());
+
+            if (toggleSolverMode)
+            {
+                mCircuitBoardController.ToggleSolverMode();
+            }
+
+            if (solveCircuit)
+            {
+                mCircuitBoardController.SolveCircuit();
+            }
+
+            if (toggleProbe)
+            {
+                mCircuitBoardController.ToggleProbe();
+            }
+
+            if (sweepFrequencies)
+            {
+                mCircuitBoardController.SweepFrequencies("ac.csv");
+            }
+
+            if (exportImage)
+            {
+                mCircuitBoardController.ExportImage("board.tif");
+            }
+
+            if (valueScale.has_value())
+            {
+                mCircuitBoardController.ScaleHoveredValue(valueScale.value());
+            }
+
+            if (toggleSimulation)
+            {
+                mCircuitBoardController.ToggleSimulation();
+            }
+
+            if (checkpointSimulation)
+            {
+                mCircuitBoardController.CheckpointSimulation();
+            }
+
+            if (resumeSimulation)
+            {
+                mCircuitBoardController.ResumeSimulation();
+            }
+            mProbePlotPanel.Update(mCircuitBoardController.GetSimulation());
+
+            // A board still loading is incomplete, saving it would lose the rest
+            bool isSaving = false;
+            if (!mCircuitBoardController.IsLoading())
+            {
+                if (saveBoard)
+                {
+                    mAutoSaver.Save(mCircuitBoardController.GetCircuitBoard(), "board.csb");
+                }
+
+                isSaving = mAutoSaver.Update(mCircuitBoardController.GetCircuitBoard());
+            }
+
+            if (toggleMemoryPanel)
+            {
+                mMemoryPanel.ToggleVisible();
+            }
+
+            if (toggleAllocationPanel)
+            {
+                mFrameAllocationPanel.ToggleVisible();
+            }
+
+            if (writeMemoryReport)
+            {
+                MemoryTracker::WriteReport("memory_report.txt");
             }
+            mFrameAllocationPanel.EndPhase(FrameAllocationPanel::Phase::Update);
             
             mWindow.setView(mView);
             mWindow.clear();
@@ -559,14 +1642,68 @@ public:
             // DRAW BOUNDs
             mWindow.setView(mHUDView);
             mComponentPicker.Draw(mWindow);
+            mMemoryPanel.Draw(mWindow, { 10, 110 });
+            mProbePlotPanel.Draw(mWindow);
+            mFrameAllocationPanel.Draw(mWindow, { 120, 70 });
+
+            if (mCircuitBoardController.IsLoading())
+            {
+                char label[32];
+                std::snprintf(label, sizeof(label), "LOADING %d%%", static_cast<int>(mCircuitBoardController.GetLoadingProgress() * 100));
+                DrawLabel(mWindow, { 120, 10 }, label, 2.0f, sf::Color::White);
+            }
+            else if (mCircuitBoardController.IsImporting())
+            {
+                char label[32];
+                std::snprintf(label, sizeof(label), "IMPORTING %d%%", static_cast<int>(mCircuitBoardController.GetImportProgress() * 100));
+                DrawLabel(mWindow, { 120, 10 }, label, 2.0f, sf::Color::White);
+            }
+            else if (mCircuitBoardController.IsRunningTask())
+            {
+                char label[32];
+                std::snprintf(label, sizeof(label), "%s %d%%", mCircuitBoardController.GetTaskLabel(), static_cast<int>(mCircuitBoardController.GetTaskProgress() * 100));
+                DrawLabel(mWindow, { 120, 10 }, label, 2.0f, sf::Color::White);
+            }
+
+            if (const CircuitSolveStats* solveStats = mCircuitBoardController.GetSolveStats())
+            {
+                char label[64];
+                std::snprintf(label, sizeof(label), "DC %zu/%zu PARTITIONS %.1f MS", solveStats->mSolvedCount, solveStats->mPartitionCount, solveStats->mMilliseconds);
+                if (mCircuitBoardController.GetSolverMode() == SolverMode::Iterative)
+                {
+                    size_t length = std::strlen(label);
+                    std::snprintf(label + length, sizeof(label) - length, " CG %zu IT", solveStats->mIterations);
+                }
+                DrawLabel(mWindow, { 120, 30 }, label, 2.0f, sf::Color::White);
+
+                std::optional<double> voltage;
+                if (mCircuitBoardController.GetHoveredVoltage(voltage))
+                {
+                    if (voltage.has_value())
+                    {
+                        std::snprintf(label, sizeof(label), "%.4g V", voltage.value());
+                    }
+                    else
+                    {
+                        std::snprintf(label, sizeof(label), "UNSOLVED");
+                    }
+                    DrawLabel(mWindow, { 120, 50 }, label, 2.0f, sf::Color::Yellow);
+                }
+            }
 
             mWindow.display();                 
+            mFrameAllocationPanel.EndPhase(FrameAllocationPanel::Phase::Draw);
+            mFrameAllocationPanel.EndFrame(!hadEvents && !isSaving && mCircuitBoardController.IsIdle());
         }
     }
 
 private:   
     CircuitBoardController mCircuitBoardController;
     ComponentPicker mComponentPicker;    
+    MemoryPanel mMemoryPanel;
+    ProbePlotPanel mProbePlotPanel;
+    FrameAllocationPanel mFrameAllocationPanel;
+    AutoSaver mAutoSaver{ "autosave.csb", 30.0f };
     std::unique_ptr<ViewController> mViewController;
 
     sf::RenderWindow mWindow;    
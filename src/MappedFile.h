@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read-only memory mapping of a whole file
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    bool Open(const std::string& filePath);
+    void Close();
+
+    const uint8_t* GetData() const { return mData; }
+    size_t GetSize() const { return mSize; }
+
+private:
+    const uint8_t* mData{ nullptr };
+    size_t mSize{ 0 };
+#ifdef _WIN32
+    void* mFileHandle{ nullptr };
+    void* mMappingHandle{ nullptr };
+#endif
+};
\ No newline at end of file
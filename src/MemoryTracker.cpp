@@ -0,0 +1,145 @@
+#include "MemoryTracker.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+
+#ifdef ALLOCATION_COUNTING
+namespace
+{
+    // Plain thread locals, operator new may run before any dynamic initialization
+    thread_local uint64_t ThreadAllocations = 0;
+    thread_local uint64_t ThreadAllocatedBytes = 0;
+
+    void* AllocateAligned(size_t bytes, size_t alignment)
+    {
+#ifdef _WIN32
+        return _aligned_malloc(bytes, alignment);
+#else
+        // aligned_alloc takes whole multiples of the alignment
+        return std::aligned_alloc(alignment, (bytes + alignment - 1) / alignment * alignment);
+#endif
+    }
+
+    void FreeAligned(void* pointer)
+    {
+#ifdef _WIN32
+        _aligned_free(pointer);
+#else
+        std::free(pointer);
+#endif
+    }
+}
+
+// The replaceable global forms. The array and nothrow forms call these, the sized and aligned ones are
+// replaced as well so no allocation bypasses the count and no pointer goes to the wrong free.
+void* operator new(size_t bytes)
+{
+    ThreadAllocations++;
+    ThreadAllocatedBytes += bytes;
+    void* pointer = std::malloc(bytes > 0 ? bytes : 1);
+    if (pointer == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void* operator new(size_t bytes, std::align_val_t alignment)
+{
+    ThreadAllocations++;
+    ThreadAllocatedBytes += bytes;
+    void* pointer = AllocateAligned(bytes > 0 ? bytes : 1, static_cast<size_t>(alignment));
+    if (pointer == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+    FreeAligned(pointer);
+}
+
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept
+{
+    FreeAligned(pointer);
+}
+
+AllocationCount MemoryTracker::GetThreadAllocations()
+{
+    return { ThreadAllocations, ThreadAllocatedBytes };
+}
+#else
+AllocationCount MemoryTracker::GetThreadAllocations()
+{
+    return {};
+}
+#endif
+
+const char* MemoryTracker::GetTagName(MemoryTag tag)
+{
+    switch (tag)
+    {
+        case MemoryTag::BoardGrid: return "Board grid";
+        case MemoryTag::Components: return "Components";
+        case MemoryTag::Connectivity: return "Connectivity";
+        case MemoryTag::RenderCaches: return "Render caches";
+        case MemoryTag::Solver: return "Solver";
+        case MemoryTag::BoardRecords: return "Board records";
+        case MemoryTag::SpatialIndex: return "Spatial index";
+        default: return "Unknown";
+    }
+}
+
+void MemoryTracker::WriteReport(std::ostream& stream)
+{
+    stream << std::left << std::setw(16) << "Subsystem"
+        << std::right << std::setw(16) << "Bytes"
+        << std::setw(16) << "Peak bytes"
+        << std::setw(14) << "Allocations" << "\n";
+
+    MemoryTagStats total;
+    for (size_t index = 0; index < static_cast<size_t>(MemoryTag::Count); index++)
+    {
+        MemoryTag tag = static_cast<MemoryTag>(index);
+        MemoryTagStats stats = GetStats(tag);
+
+        stream << std::left << std::setw(16) << GetTagName(tag)
+            << std::right << std::setw(16) << stats.mBytes
+            << std::setw(16) << stats.mPeakBytes
+            << std::setw(14) << stats.mAllocations << "\n";
+
+        total.mBytes += stats.mBytes;
+        total.mAllocations += stats.mAllocations;
+    }
+
+    // Peaks of different subsystems are not simultaneous, so there is no meaningful total peak
+    stream << std::left << std::setw(16) << "Total"
+        << std::right << std::setw(16) << total.mBytes
+        << std::setw(16) << "-"
+        << std::setw(14) << total.mAllocations << "\n";
+}
+
+bool MemoryTracker::WriteReport(const char* filePath)
+{
+    std::ofstream file(filePath);
+    if (!file)
+    {
+        return false;
+    }
+
+    WriteReport(file);
+    return static_cast<bool>(file);
+}
\ No newline at end of file
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <ostream>
+#include <vector>
+
+enum class MemoryTag : uint8_t
+{
+    BoardGrid,
+    Components,
+    Connectivity,
+    RenderCaches,
+    Solver,
+    BoardRecords,
+    SpatialIndex,
+    Count
+};
+
+struct MemoryTagStats
+{
+    int64_t mBytes{ 0 };
+    int64_t mPeakBytes{ 0 };
+    int64_t mAllocations{ 0 };  // Live allocations
+};
+
+// Made so far, never decreases, differences tell what a stretch of code allocated
+struct AllocationCount
+{
+    uint64_t mAllocations{ 0 };
+    uint64_t mBytes{ 0 };
+
+    AllocationCount operator-(const AllocationCount& other) const
+    {
+        return { mAllocations - other.mAllocations, mBytes - other.mBytes };
+    }
+};
+
+// Process wide byte counts per subsystem, fed by TrackedAllocator and the tracked operator new overloads
+class MemoryTracker
+{
+public:
+    static void Allocate(MemoryTag tag, size_t bytes)
+    {
+        Counters& counters = GetCounters(tag);
+        int64_t total = counters.mBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        counters.mAllocations.fetch_add(1, std::memory_order_relaxed);
+
+        int64_t peak = counters.mPeakBytes.load(std::memory_order_relaxed);
+        while (total > peak && !counters.mPeakBytes.compare_exchange_weak(peak, total, std::memory_order_relaxed))
+        { }
+    }
+
+    static void Deallocate(MemoryTag tag, size_t bytes)
+    {
+        Counters& counters = GetCounters(tag);
+        counters.mBytes.fetch_sub(bytes, std::memory_order_relaxed);
+        counters.mAllocations.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    static MemoryTagStats GetStats(MemoryTag tag)
+    {
+        const Counters& counters = GetCounters(tag);
+        return {
+            counters.mBytes.load(std::memory_order_relaxed),
+            counters.mPeakBytes.load(std::memory_order_relaxed),
+            counters.mAllocations.load(std::memory_order_relaxed)
+        };
+    }
+
+    // Every heap allocation through the global operator new by the calling thread, tagged or not. Counting
+    // replaces operator new, so only instrumented builds (ALLOCATION_COUNTING) count, the others read zero.
+    static AllocationCount GetThreadAllocations();
+#ifdef ALLOCATION_COUNTING
+    static constexpr bool IsCountingAllocations = true;
+#else
+    static constexpr bool IsCountingAllocations = false;
+#endif
+
+    static const char* GetTagName(MemoryTag tag);
+    static void WriteReport(std::ostream& stream);
+    static bool WriteReport(const char* filePath);
+
+private:
+    struct Counters
+    {
+        std::atomic<int64_t> mBytes{ 0 };
+        std::atomic<int64_t> mPeakBytes{ 0 };
+        std::atomic<int64_t> mAllocations{ 0 };
+    };
+
+    static Counters& GetCounters(MemoryTag tag)
+    {
+        static std::array<Counters, static_cast<size_t>(MemoryTag::Count)> counters;
+        return counters[static_cast<size_t>(tag)];
+    }
+};
+
+template<typename T, MemoryTag Tag>
+class TrackedAllocator
+{
+public:
+    using value_type = T;
+
+    template<typename U>
+    struct rebind { using other = TrackedAllocator<U, Tag>; };
+
+    TrackedAllocator() = default;
+
+    template<typename U>
+    TrackedAllocator(const TrackedAllocator<U, Tag>&) { }
+
+    T* allocate(size_t count)
+    {
+        MemoryTracker::Allocate(Tag, count * sizeof(T));
+        return static_cast<T*>(::operator new(count * sizeof(T)));
+    }
+
+    void deallocate(T* pointer, size_t count)
+    {
+        MemoryTracker::Deallocate(Tag, count * sizeof(T));
+        ::operator delete(pointer);
+    }
+
+    template<typename U>
+    bool operator==(const TrackedAllocator<U, Tag>&) const { return true; }
+
+    template<typename U>
+    bool operator!=(const TrackedAllocator<U, Tag>&) const { return false; }
+};
+
+template<typename T, MemoryTag Tag>
+using TrackedVector = std::vector<T, TrackedAllocator<T, Tag>>;
+
+// Derive from this to account every heap instance of a class (including subclasses) under a tag
+template<MemoryTag Tag>
+class TrackedObject
+{
+public:
+    static void* operator new(size_t bytes)
+    {
+        MemoryTracker::Allocate(Tag, bytes);
+        return ::operator new(bytes);
+    }
+
+    static void operator delete(void* pointer, size_t bytes)
+    {
+        MemoryTracker::Deallocate(Tag, bytes);
+        ::operator delete(pointer);
+    }
+};
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded lock-free queue from any number of producer threads to exactly one consumer thread. Every cell
+// carries a sequence number telling whose turn it is, producers claim cells by advancing the tail with a
+// compare-and-swap and publish them through the sequence, so a stalled producer never blocks the others
+// from claiming. Nothing allocates, a full queue refuses the push and an empty one the pop.
+template<typename T, size_t Capacity>
+class MpscQueue
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    MpscQueue()
+    {
+        for (size_t index = 0; index < Capacity; index++)
+        {
+            mCells[index].mSequence.store(index, std::memory_order_relaxed);
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // Producer side, any thread
+    bool TryPush(const T& value)
+    {
+        size_t tail = mTail.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true)
+        {
+            cell = &mCells[tail & (Capacity - 1)];
+            size_t sequence = cell->mSequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(tail);
+            if (difference == 0)
+            {
+                if (mTail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (difference < 0)
+            {
+                return false;  // The consumer has not freed the cell a lap ago
+            }
+            else
+            {
+                tail = mTail.load(std::memory_order_relaxed);  // Another producer claimed it
+            }
+        }
+
+        cell->mValue = value;
+        cell->mSequence.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool TryPop(T& outValue)
+    {
+        Cell& cell = mCells[mHead & (Capacity - 1)];
+        if (cell.mSequence.load(std::memory_order_acquire) != mHead + 1)
+        {
+            return false;  // Empty, or the producer that claimed the cell has not published yet
+        }
+
+        outValue = cell.mValue;
+        cell.mSequence.store(mHead + Capacity, std::memory_order_release);
+        mHead++;
+        return true;
+    }
+
+private:
+    static constexpr size_t CacheLineSize = 64;
+
+    struct alignas(CacheLineSize) Cell
+    {
+        std::atomic<size_t> mSequence;
+        T mValue{};
+    };
+
+    alignas(CacheLineSize) std::atomic<size_t> mTail{ 0 };
+    alignas(CacheLineSize) size_t mHead{ 0 };  // Only the consumer touches it
+    std::array<Cell, Capacity> mCells;
+};
\ No newline at end of file
@@ -0,0 +1,629 @@
+#include "NetlistImporter.h"
+#include "CircuitBoard.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdio>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <memory>
+
+NetlistImporter::NetlistImporter(const std::vector<const Component*>& prototypes)
+{
+    for (const Component* prototype : prototypes)
+    {
+        const char* typeName = prototype->GetTypeName();
+        if (std::strcmp(typeName, "Resistor") == 0)
+        {
+            mResistor = prototype;
+        }
+        else if (std::strcmp(typeName, "LightBulb") == 0)
+        {
+            mLightBulb = prototype;
+        }
+        else if (std::strcmp(typeName, "Battery") == 0)
+        {
+            mBattery = prototype;
+        }
+        else if (std::strcmp(typeName, "CurrentSource") == 0)
+        {
+            mCurrentSource = prototype;
+        }
+    }
+}
+
+NetlistImporter::~NetlistImporter() = default;
+
+bool NetlistImporter::Open(const std::string& filePath, std::string& outError)
+{
+    Stop();
+    mCircuitBoard.reset();
+    mFile.reset(std::fopen(filePath.c_str(), "rb"));
+    if (!mFile)
+    {
+        outError = "Cannot open " + filePath;
+        return false;
+    }
+
+    // Only for the progress
+    std::error_code error;
+    mFileSize = std::filesystem::file_size(filePath, error);
+    if (error)
+    {
+        mFileSize = 0;
+    }
+
+    mFilePath = filePath;
+    mBuffer.resize(ReadBufferSize);
+    ResetPass();
+    mStage = Stage::Counting;
+    return true;
+}
+
+bool NetlistImporter::Update(sf::Time timeBudget, std::string& outError)
+{
+    sf::Clock clock;
+    bool isGood = true;
+    while (isGood && mStage != Stage::Done && (timeBudget <= sf::Time::Zero || clock.getElapsedTime() < timeBudget))
+    {
+        isGood = ImportNextLine(outError);
+    }
+
+    if (!isGood)
+    {
+        Stop();
+        mCircuitBoard.reset();
+    }
+    return isGood;
+}
+
+float NetlistImporter::GetProgress() const
+{
+    if (!IsImporting() || mFileSize == 0)
+    {
+        return 1.0f;
+    }
+
+    // Each pass reads the whole file
+    uint64_t consumed = mReadCount - (mFilled - mLineStart);
+    uint64_t passStart = mStage == Stage::Placing ? mFileSize : 0;
+    return static_cast<float>(static_cast<double>(passStart + consumed) / (2.0 * mFileSize));
+}
+
+std::unique_ptr<CircuitBoard> NetlistImporter::TakeCircuitBoard()
+{
+    return IsImporting() ? nullptr : std::move(mCircuitBoard);
+}
+
+// One physical line a call, the buffer is refilled once it holds no complete line. A pass ends at the end
+// of the file or at .END.
+bool NetlistImporter::ImportNextLine(std::string& outError)
+{
+    if (mIsEnded)
+    {
+        return FinishPass(outError);
+    }
+
+    const char* lineStart = mBuffer.data() + mLineStart;
+    const char* newline = static_cast<const char*>(std::memchr(lineStart, '\n', mFilled - mLineStart));
+    if (newline == nullptr && !mIsEndOfFile)
+    {
+        return Refill(outError);
+    }
+
+    // Last line without a newline
+    size_t lineEnd = newline != nullptr ? newline - mBuffer.data() : mFilled;
+    if (newline == nullptr && lineEnd == mLineStart)
+    {
+        return FinishPass(outError);
+    }
+
+    bool isGood = ProcessPhysicalLine(std::string_view(lineStart, lineEnd - mLineStart), outError);
+    mLineStart = newline != nullptr ? lineEnd + 1 : lineEnd;
+    return isGood;
+}
+
+bool NetlistImporter::Refill(std::string& outError)
+{
+    if (mLineStart == 0 && mFilled == mBuffer.size())
+    {
+        outError = GetLineError("Line is longer than " + std::to_string(ReadBufferSize) + " bytes");
+        return false;
+    }
+
+    std::memmove(mBuffer.data(), mBuffer.data() + mLineStart, mFilled - mLineStart);
+    mFilled -= mLineStart;
+    mLineStart = 0;
+
+    size_t readCount = std::fread(mBuffer.data() + mFilled, 1, mBuffer.size() - mFilled, mFile.get());
+    mIsEndOfFile = readCount < mBuffer.size() - mFilled;
+    if (mIsEndOfFile && std::ferror(mFile.get()))
+    {
+        outError = "Cannot read " + mFilePath;
+        return false;
+    }
+    mFilled += readCount;
+    mReadCount += readCount;
+    return true;
+}
+
+// After counting, the board gets a square lattice of cells, one per element, and the netlist is read again
+bool NetlistImporter::FinishPass(std::string& outError)
+{
+    if (!Finish(outError))
+    {
+        return false;
+    }
+
+    if (mStage == Stage::Placing)
+    {
+        Stop();
+        return true;
+    }
+
+    uint64_t elementCount = std::max<uint64_t>(mStats.mComponentCount, 1);
+    uint64_t columns = static_cast<uint64_t>(std::ceil(std::sqrt(static_cast<double>(elementCount))));
+    uint64_t rows = (elementCount + columns - 1) / columns;
+
+    // Cells start a pin in, the last one ends a pin before the edge
+    uint64_t gridX = columns * PlacementCellSize - 1;
+    uint64_t gridY = rows * PlacementCellSize - 1;
+    if (gridX > std::numeric_limits<int32_t>::max() || gridY > std::numeric_limits<int32_t>::max()
+        || !PinLayout::IsGridSupported(sf::Vector2u(static_cast<uint32_t>(gridX), static_cast<uint32_t>(gridY))))
+    {
+        outError = "The netlist has too many elements for one board";
+        return false;
+    }
+
+    mCircuitBoard = std::make_unique<CircuitBoard>(sf::Vector2i(static_cast<int32_t>(gridX), static_cast<int32_t>(gridY)));
+    std::rewind(mFile.get());
+    ResetPass();
+    mStage = Stage::Placing;
+    return true;
+}
+
+void NetlistImporter::ResetPass()
+{
+    mNets.clear();
+    mSubcircuits.clear();
+    mPendingInstances.clear();
+    mDefinition.reset();
+    mConnections.Reset();
+    mPlacementCursor = 0;
+    mStatement.clear();
+    mStatementLineNumber = 0;
+    mIsEnded = false;
+    mStats = NetlistImportStats();
+
+    mReadCount = 0;
+    mFilled = 0;
+    mLineStart = 0;
+    mIsEndOfFile = false;
+}
+
+void NetlistImporter::Stop()
+{
+    mStage = Stage::Done;
+    mFile.reset();
+}
+
+bool NetlistImporter::ProcessPhysicalLine(std::string_view line, std::string& outError)
+{
+    mStats.mLineCount++;
+    if (!line.empty() && line.back() == '\r')
+    {
+        line.remove_suffix(1);
+    }
+
+    // The first line is the title
+    if (mStats.mLineCount == 1)
+    {
+        return true;
+    }
+
+    if (!line.empty() && line.front() == '+')
+    {
+        mStatement += ' ';
+        mStatement.append(line.substr(1));
+        return true;
+    }
+
+    bool isGood = mStatement.empty() || ProcessStatement(mStatement, outError);
+    mStatement.assign(line);
+    mStatementLineNumber = mStats.mLineCount;
+    return isGood;
+}
+
+bool NetlistImporter::ProcessStatement(std::string_view statement, std::string& outError)
+{
+    Tokenize(statement, mTokens);
+    if (mTokens.empty())
+    {
+        return true;
+    }
+
+    if (mDefinition.has_value())
+    {
+        if (IsKeyword(mTokens[0], ".SUBCKT"))
+        {
+            outError = GetLineError("Nested .SUBCKT definitions are not supported");
+            return false;
+        }
+
+        if (!IsKeyword(mTokens[0], ".ENDS"))
+        {
+            mDefinition->second.mLines.emplace_back(statement);
+            return true;
+        }
+
+        // Instances met before the definition are expanded now
+        std::string name = std::move(mDefinition->first);
+        mSubcircuits[name] = std::move(mDefinition->second);
+        mDefinition.reset();
+
+        auto pending = mPendingInstances.find(name);
+        if (pending != mPendingInstances.end())
+        {
+            std::vector<PendingInstance> instances = std::move(pending->second);
+            mPendingInstances.erase(pending);
+            for (PendingInstance& instance : instances)
+            {
+                if (!Instantiate(name, instance.mPath, std::move(instance.mNets), instance.mDepth, outError))
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    if (IsKeyword(mTokens[0], ".SUBCKT"))
+    {
+        if (mTokens.size() < 2)
+        {
+            outError = GetLineError(".SUBCKT without a name");
+            return false;
+        }
+
+        Subcircuit subcircuit;
+        for (size_t index = 2; index < mTokens.size(); index++)
+        {
+            subcircuit.mPorts.push_back(ToUpper(mTokens[index]));
+        }
+        mDefinition.emplace(ToUpper(mTokens[1]), std::move(subcircuit));
+        return true;
+    }
+
+    if (IsKeyword(mTokens[0], ".END"))
+    {
+        mIsEnded = true;
+        return true;
+    }
+
+    static const std::string topLevelPath;
+    static const std::vector<std::string> noPorts;
+    return ProcessElement(Scope{ topLevelPath, noPorts, noPorts, 0 }, outError);
+}
+
+bool NetlistImporter::ProcessLine(std::string_view line, const Scope& scope, std::string& outError)
+{
+    Tokenize(line, mTokens);
+    return mTokens.empty() || ProcessElement(scope, outError);
+}
+
+bool NetlistImporter::ProcessElement(const Scope& scope, std::string& outError)
+{
+    switch (std::toupper(static_cast<unsigned char>(mTokens[0][0])))
+    {
+        case '*': return true;
+        case 'R': return AddElement(mResistor, mTokens, scope, outError);
+        case 'B': return AddElement(mLightBulb, mTokens, scope, outError);
+        case 'V': return AddElement(mBattery, mTokens, scope, outError);
+        case 'I': return AddElement(mCurrentSource, mTokens, scope, outError);
+        case 'X': return AddInstance(mTokens, scope, outError);
+        default:
+            mStats.mSkippedCount++;
+            return true;
+    }
+}
+
+bool NetlistImporter::AddElement(const Component* prototype, const std::vector<std::string_view>& tokens, const Scope& scope, std::string& outError)
+{
+    if (prototype == nullptr)
+    {
+        outError = GetLineError("No component type for " + ToUpper(tokens[0]));
+        return false;
+    }
+
+    // Sources may name their DC value
+    size_t valueIndex = tokens.size() > 4 && IsKeyword(tokens[3], "DC") ? 4 : 3;
+    double value = 0;
+    if (tokens.size() <= valueIndex || !ParseValue(tokens[valueIndex], value))
+    {
+        outError = GetLineError(ToUpper(tokens[0]) + " needs two nodes and a value");
+        return false;
+    }
+
+    if (mStage == Stage::Counting)
+    {
+        mStats.mComponentCount++;
+        return true;
+    }
+
+    Component* component = PlaceComponent(prototype);
+    if (component == nullptr)
+    {
+        outError = GetLineError("The board is full");
+        return false;
+    }
+
+    component->SetValue(value);
+    mCircuitBoard->AddComponent(component);
+    mStats.mComponentCount++;
+
+    auto [firstPinId, secondPinId] = component->GetTerminalPinIds();
+    ConnectToNet(ResolveNet(tokens[1], scope), component->GetConnector(firstPinId));
+    ConnectToNet(ResolveNet(tokens[2], scope), component->GetConnector(secondPinId));
+
+    if (mConnections.GetConnectorPairCount() >= ConnectionBatchSize)
+    {
+        FlushConnections();
+    }
+    return true;
+}
+
+bool NetlistImporter::AddInstance(const std::vector<std::string_view>& tokens, const Scope& scope, std::string& outError)
+{
+    if (tokens.size() < 2)
+    {
+        outError = GetLineError("Subcircuit instance without a subcircuit name");
+        return false;
+    }
+
+    // Everything is copied out of the tokens, expanding the instance tokenizes other lines
+    std::string name = ToUpper(tokens[0]);
+    std::string path = scope.mPath.empty() ? name : scope.mPath + "." + name;
+    std::vector<std::string> nets;
+    for (size_t index = 1; index + 1 < tokens.size(); index++)
+    {
+        nets.push_back(ResolveNet(tokens[index], scope));
+    }
+    return Instantiate(ToUpper(tokens.back()), path, std::move(nets), scope.mDepth + 1, outError);
+}
+
+bool NetlistImporter::Instantiate(const std::string& subcircuitName, const std::string& path, std::vector<std::string> nets, uint32_t depth, std::string& outError)
+{
+    if (depth > MaxSubcircuitDepth)
+    {
+        outError = GetLineError("Subcircuit " + subcircuitName + " nests too deep");
+        return false;
+    }
+
+    auto subcircuit = mSubcircuits.find(subcircuitName);
+    if (subcircuit == mSubcircuits.end())
+    {
+        mPendingInstances[subcircuitName].push_back({ path, std::move(nets), depth, mStatementLineNumber });
+        return true;
+    }
+
+    if (nets.size() != subcircuit->second.mPorts.size())
+    {
+        outError = GetLineError(path + " connects " + std::to_string(nets.size()) + " nodes, subcircuit " + subcircuitName
+            + " has " + std::to_string(subcircuit->second.mPorts.size()) + " ports");
+        return false;
+    }
+
+    Scope scope{ path, subcircuit->second.mPorts, nets, depth };
+    for (const std::string& line : subcircuit->second.mLines)
+    {
+        if (!ProcessLine(line, scope, outError))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool NetlistImporter::Finish(std::string& outError)
+{
+    if (!mStatement.empty() && !mIsEnded)
+    {
+        if (!ProcessStatement(mStatement, outError))
+        {
+            return false;
+        }
+        mStatement.clear();
+    }
+
+    if (mDefinition.has_value())
+    {
+        outError = "Subcircuit " + mDefinition->first + " has no .ENDS";
+        return false;
+    }
+
+    if (!mPendingInstances.empty())
+    {
+        const auto& [name, instances] = *mPendingInstances.begin();
+        outError = "Line " + std::to_string(instances.front().mLineNumber) + ": Unknown subcircuit " + name;
+        return false;
+    }
+
+    FlushConnections();
+    mStats.mNetCount = mNets.size();
+    return true;
+}
+
+const std::string& NetlistImporter::ResolveNet(std::string_view node, const Scope& scope)
+{
+    mNetScratch.assign(node);
+    for (char& character : mNetScratch)
+    {
+        character = static_cast<char>(std::toupper(static_cast<unsigned char>(character)));
+    }
+
+    if (scope.mPath.empty() || mNetScratch == "0")
+    {
+        return mNetScratch;
+    }
+
+    auto port = std::find(scope.mPorts.begin(), scope.mPorts.end(), mNetScratch);
+    if (port != scope.mPorts.end())
+    {
+        return scope.mNets[port - scope.mPorts.begin()];
+    }
+
+    // Local to the instance
+    mNetScratch.insert(0, ".");
+    mNetScratch.insert(0, scope.mPath);
+    return mNetScratch;
+}
+
+void NetlistImporter::ConnectToNet(const std::string& net, Connector* connector)
+{
+    // Chaining keeps every connector at two connections at most, a star would grow one huge hub per net
+    auto [entry, isNew] = mNets.try_emplace(net, connector);
+    if (!isNew)
+    {
+        mConnections.AddConnectorPair(connector, entry->second);
+        entry->second = connector;
+    }
+}
+
+Component* NetlistImporter::PlaceComponent(const Component* prototype)
+{
+    // Cells are visited row by row from where the previous component went, so a lattice cell already
+    // taken by something else costs one failed attempt
+    const sf::Vector2i& grid = mCircuitBoard->GetGrid();
+    uint32_t columns = (grid.x + 1) / PlacementCellSize;
+    uint32_t rows = (grid.y + 1) / PlacementCellSize;
+    while (mPlacementCursor < columns * rows)
+    {
+        uint32_t x = mPlacementCursor % columns * PlacementCellSize + 1;
+        uint32_t y = mPlacementCursor / columns * PlacementCellSize + 1;
+        mPlacementCursor++;
+
+        Component* component = prototype->CreateShapeAt(mCircuitBoard.get(), x + y * grid.x);
+        ConnectionConnector connectionConnector;
+        mCircuitBoard->CollectConnections(component, connectionConnector);
+        if (connectionConnector.IsPlaceable() && connectionConnector.GetConnectorPairCount() == 0)
+        {
+            return component;
+        }
+        delete component;
+    }
+    return nullptr;
+}
+
+void NetlistImporter::FlushConnections()
+{
+    if (mConnections.GetConnectorPairCount() > 0)
+    {
+        mStats.mConnectionCount += mConnections.GetConnectorPairCount();
+        mCircuitBoard->AddConnections(mConnections);
+        mConnections.Reset();
+    }
+}
+
+std::string NetlistImporter::GetLineError(const std::string& message) const
+{
+    return "Line " + std::to_string(mStatementLineNumber) + ": " + message;
+}
+
+void NetlistImporter::Tokenize(std::string_view line, std::vector<std::string_view>& outTokens)
+{
+    auto isSeparator = [](char character)
+    {
+        return std::isspace(static_cast<unsigned char>(character)) || character == '=' || character == ',' || character == '(' || character == ')';
+    };
+
+    outTokens.clear();
+    size_t index = 0;
+    while (index < line.size() && line[index] != ';')
+    {
+        if (isSeparator(line[index]))
+        {
+            index++;
+            continue;
+        }
+
+        size_t start = index;
+        while (index < line.size() && line[index] != ';' && !isSeparator(line[index]))
+        {
+            index++;
+        }
+        outTokens.push_back(line.substr(start, index - start));
+    }
+}
+
+bool NetlistImporter::ParseValue(std::string_view token, double& outValue)
+{
+    // from_chars takes no leading plus sign
+    if (!token.empty() && token.front() == '+')
+    {
+        token.remove_prefix(1);
+    }
+
+    auto [end, error] = std::from_chars(token.data(), token.data() + token.size(), outValue);
+    if (error != std::errc())
+    {
+        return false;
+    }
+
+    // Scale suffix, anything after it is a unit
+    std::string suffix = ToUpper(std::string_view(end, token.data() + token.size() - end));
+    if (suffix.compare(0, 3, "MEG") == 0)
+    {
+        outValue *= 1e6;
+    }
+    else if (suffix.compare(0, 3, "MIL") == 0)
+    {
+        outValue *= 25.4e-6;
+    }
+    else if (!suffix.empty())
+    {
+        switch (suffix[0])
+        {
+            case 'T': outValue *= 1e12; break;
+            case 'G': outValue *= 1e9; break;
+            case 'K': outValue *= 1e3; break;
+            case 'M': outValue *= 1e-3; break;
+            case 'U': outValue *= 1e-6; break;
+            case 'N': outValue *= 1e-9; break;
+            case 'P': outValue *= 1e-12; break;
+            case 'F': outValue *= 1e-15; break;
+            default: break;
+        }
+    }
+    return true;
+}
+
+bool NetlistImporter::IsKeyword(std::string_view token, std::string_view keyword)
+{
+    return token.size() == keyword.size() && std::equal(token.begin(), token.end(), keyword.begin(), [](char tokenCharacter, char keywordCharacter)
+    {
+        return std::toupper(static_cast<unsigned char>(tokenCharacter)) == keywordCharacter;
+    });
+}
+
+std::string NetlistImporter::ToUpper(std::string_view text)
+{
+    std::string upper(text);
+    for (char& character : upper)
+    {
+        character = static_cast<char>(std::toupper(static_cast<unsigned char>(character)));
+    }
+    return upper;
+}
+
+std::unique_ptr<CircuitBoard> ImportNetlistFile(const std::string& filePath, const std::vector<const Component*>& prototypes, std::string& outError)
+{
+    NetlistImporter netlistImporter(prototypes);
+    if (!netlistImporter.Open(filePath, outError) || !netlistImporter.Update(sf::Time::Zero, outError))
+    {
+        return nullptr;
+    }
+    return netlistImporter.TakeCircuitBoard();
+}
\ No newline at end of file
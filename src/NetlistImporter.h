@@ -0,0 +1,161 @@
+#pragma once
+
+#include "Component.h"
+
+#include <SFML/Graphics.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class CircuitBoard;
+
+struct NetlistImportStats
+{
+    size_t mLineCount{ 0 };
+    size_t mComponentCount{ 0 };
+    size_t mConnectionCount{ 0 };
+    size_t mNetCount{ 0 };
+    size_t mSkippedCount{ 0 };  // Unsupported elements and dot commands
+};
+
+// Imports a SPICE-like netlist into a new board, streaming it through a fixed size read buffer. A first pass
+// counts the elements, subcircuits expanded, so the board can be sized to a square lattice of one cell per
+// element. The second places each component on its cell and connects it per net directly, without wires.
+// Both go a line at a time so the import can be spread over frames. Memory is bounded by the nets, the
+// subcircuit definitions and the board, never by the netlist size.
+//
+//   Rname n1 n2 value            Resistor
+//   Bname n1 n2 value            Light bulb, a resistive load
+//   Vname n+ n- [DC] value       Voltage source
+//   Iname n+ n- [DC] value       Current source
+//   Xname n1 n2 ... subname      Subcircuit instance
+//   .SUBCKT subname p1 p2 ...    Subcircuit definition up to .ENDS, may come after its instances
+//   .END                         Stops the import
+//
+// The first line is the title, '*' starts a comment line, ';' an inline comment and '+' continues the
+// previous line. Names are case insensitive, values take the SPICE scale suffixes and node 0 is global.
+class NetlistImporter
+{
+public:
+    // Prototypes are looked up by type name: Resistor, LightBulb, Battery and CurrentSource
+    explicit NetlistImporter(const std::vector<const Component*>& prototypes);
+    ~NetlistImporter();
+
+    bool Open(const std::string& filePath, std::string& outError);
+
+    // Imports until timeBudget is spent, a zero budget imports everything. On an error importing stops for
+    // good and the board is dropped.
+    bool Update(sf::Time timeBudget, std::string& outError);
+
+    bool IsImporting() const { return mStage != Stage::Done; }
+    float GetProgress() const;
+
+    // The board, once the import is done
+    std::unique_ptr<CircuitBoard> TakeCircuitBoard();
+
+    // Of the placing pass
+    const NetlistImportStats& GetStats() const { return mStats; }
+
+private:
+    enum class Stage
+    {
+        Counting,
+        Placing,
+        Done
+    };
+
+    struct Subcircuit
+    {
+        std::vector<std::string> mPorts;
+        std::vector<std::string> mLines;
+    };
+
+    struct PendingInstance
+    {
+        std::string mPath;
+        std::vector<std::string> mNets;
+        uint32_t mDepth;
+        size_t mLineNumber;
+    };
+
+    // Resolves node names inside a subcircuit instance, top level statements have no ports
+    struct Scope
+    {
+        const std::string& mPath;
+        const std::vector<std::string>& mPorts;
+        const std::vector<std::string>& mNets;
+        uint32_t mDepth;
+    };
+
+    bool ImportNextLine(std::string& outError);
+    bool Refill(std::string& outError);
+    bool FinishPass(std::string& outError);
+    void ResetPass();
+    void Stop();
+    bool ProcessPhysicalLine(std::string_view line, std::string& outError);
+    bool ProcessStatement(std::string_view statement, std::string& outError);
+    bool ProcessLine(std::string_view line, const Scope& scope, std::string& outError);
+    bool ProcessElement(const Scope& scope, std::string& outError);  // Of the tokens of the current line
+    bool AddElement(const Component* prototype, const std::vector<std::string_view>& tokens, const Scope& scope, std::string& outError);
+    bool AddInstance(const std::vector<std::string_view>& tokens, const Scope& scope, std::string& outError);
+    bool Instantiate(const std::string& subcircuitName, const std::string& path, std::vector<std::string> nets, uint32_t depth, std::string& outError);
+    bool Finish(std::string& outError);
+
+    const std::string& ResolveNet(std::string_view node, const Scope& scope);
+    void ConnectToNet(const std::string& net, Connector* connector);
+    Component* PlaceComponent(const Component* prototype);
+    void FlushConnections();
+    std::string GetLineError(const std::string& message) const;
+
+    static void Tokenize(std::string_view line, std::vector<std::string_view>& outTokens);
+    static bool ParseValue(std::string_view token, double& outValue);
+    static bool IsKeyword(std::string_view token, std::string_view keyword);  // Keyword in upper case
+    static std::string ToUpper(std::string_view text);
+
+    static constexpr size_t ReadBufferSize = 1 << 20;
+    static constexpr size_t ConnectionBatchSize = 4096;
+    static constexpr uint32_t MaxSubcircuitDepth = 64;
+    static constexpr uint32_t PlacementCellSize = 4;  // In board pins, leaves a free pin between components
+
+    std::unique_ptr<CircuitBoard> mCircuitBoard;
+    const Component* mResistor{ nullptr };
+    const Component* mLightBulb{ nullptr };
+    const Component* mBattery{ nullptr };
+    const Component* mCurrentSource{ nullptr };
+
+    std::unordered_map<std::string, Connector*> mNets;  // Last connector on each net
+    std::unordered_map<std::string, Subcircuit> mSubcircuits;
+    std::unordered_map<std::string, std::vector<PendingInstance>> mPendingInstances;
+    std::optional<std::pair<std::string, Subcircuit>> mDefinition;  // Subcircuit being read
+    ConnectionConnector mConnections;
+    uint32_t mPlacementCursor{ 0 };
+
+    // Lines are handed out of the buffer in place, a partial line at the end moves to the front on refill
+    Stage mStage{ Stage::Done };
+    std::unique_ptr<std::FILE, int(*)(std::FILE*)> mFile{ nullptr, &std::fclose };
+    std::string mFilePath;
+    uint64_t mFileSize{ 0 };
+    uint64_t mReadCount{ 0 };  // Of the current pass
+    std::vector<char> mBuffer;
+    size_t mFilled{ 0 };
+    size_t mLineStart{ 0 };
+    bool mIsEndOfFile{ false };
+
+    std::string mStatement;  // Logical line, continuation lines appended
+    size_t mStatementLineNumber{ 0 };
+    bool mIsEnded{ false };
+    std::string mNetScratch;
+    std::vector<std::string_view> mTokens;
+    NetlistImportStats mStats;
+};
+
+// Imports the whole netlist at once
+std::unique_ptr<CircuitBoard> ImportNetlistFile(const std::string& filePath, const std::vector<const Component*>& prototypes, std::string& outError);
\ No newline at end of file
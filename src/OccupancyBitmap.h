@@ -0,0 +1,149 @@
+#pragma once
+
+#include "MemoryTracker.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <utility>
+
+// Board pins claimed by a single component, grouped into the 64-bit words of an OccupancyBitmap. Pins go by
+// their slot in the board's PinLayout, so a word is one 8x8 tile and a small footprint touches one to four.
+class OccupancyFootprint
+{
+public:
+    using WordMask = std::pair<size_t, uint64_t>;
+
+    void Reset()
+    {
+        mPinWords.clear();
+        mBlockingPinWords.clear();
+    }
+
+    void AddPin(uint32_t slot, bool isConnectable)
+    {
+        Accumulate(mPinWords, slot);
+        if (!isConnectable)
+        {
+            Accumulate(mBlockingPinWords, slot);
+        }
+    }
+
+    template<typename Function>
+    void ForEachPin(Function function) const
+    {
+        for (const auto& [wordIndex, mask] : mPinWords)
+        {
+            for (uint32_t bit = 0; bit < 64; bit++)
+            {
+                if ((mask >> bit) & 1)
+                {
+                    function(static_cast<uint32_t>(wordIndex * 64 + bit));
+                }
+            }
+        }
+    }
+
+    size_t GetPinCount() const
+    {
+        size_t pinCount = 0;
+        ForEachPin([&](uint32_t) { pinCount++; });
+        return pinCount;
+    }
+
+    const std::vector<WordMask>& GetPinWords() const { return mPinWords; }
+    const std::vector<WordMask>& GetBlockingPinWords() const { return mBlockingPinWords; }
+
+private:
+    static void Accumulate(std::vector<WordMask>& wordMasks, uint32_t slot)
+    {
+        size_t wordIndex = slot / 64;
+        uint64_t bit = uint64_t(1) << (slot % 64);
+
+        // Footprints are a handful of pins, a linear search beats any lookup structure
+        for (WordMask& wordMask : wordMasks)
+        {
+            if (wordMask.first == wordIndex)
+            {
+                wordMask.second |= bit;
+                return;
+            }
+        }
+        wordMasks.push_back({ wordIndex, bit });
+    }
+
+    std::vector<WordMask> mPinWords;
+    std::vector<WordMask> mBlockingPinWords;
+};
+
+// Tracks which circuit board pins are claimed by placed components, by slot like the footprints. Connectable
+// pins may be shared between components (that is how they connect), non-connectable pins block the pin entirely.
+class OccupancyBitmap
+{
+public:
+    void Resize(uint32_t slotCount)
+    {
+        size_t totalWords = (static_cast<size_t>(slotCount) + 63) / 64;
+        mOccupiedWords.assign(totalWords, 0);
+        mBlockedWords.assign(totalWords, 0);
+    }
+
+    bool CanPlace(const OccupancyFootprint& footprint) const
+    {
+        for (const auto& [wordIndex, mask] : footprint.GetPinWords())
+        {
+            if (mBlockedWords[wordIndex] & mask)
+            {
+                return false;
+            }
+        }
+
+        for (const auto& [wordIndex, mask] : footprint.GetBlockingPinWords())
+        {
+            if (mOccupiedWords[wordIndex] & mask)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool Intersects(const OccupancyFootprint& footprint) const
+    {
+        for (const auto& [wordIndex, mask] : footprint.GetPinWords())
+        {
+            if (mOccupiedWords[wordIndex] & mask)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Claim(const OccupancyFootprint& footprint)
+    {
+        for (const auto& [wordIndex, mask] : footprint.GetPinWords())
+        {
+            mOccupiedWords[wordIndex] |= mask;
+        }
+
+        for (const auto& [wordIndex, mask] : footprint.GetBlockingPinWords())
+        {
+            mBlockedWords[wordIndex] |= mask;
+        }
+    }
+
+    bool IsOccupied(uint32_t slot) const
+    {
+        return (mOccupiedWords[slot / 64] >> (slot % 64)) & 1;
+    }
+
+    bool IsBlocked(uint32_t slot) const
+    {
+        return (mBlockedWords[slot / 64] >> (slot % 64)) & 1;
+    }
+
+private:
+    TrackedVector<uint64_t, MemoryTag::BoardGrid> mOccupiedWords;
+    TrackedVector<uint64_t, MemoryTag::BoardGrid> mBlockedWords;
+};
\ No newline at end of file
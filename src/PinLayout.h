@@ -0,0 +1,91 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+#include <cstdint>
+#include <limits>
+
+// Where per-pin board data is stored. Pins are grouped into 8x8 tiles laid out row by row, and inside a tile
+// they follow the Morton (Z) curve, so a pin and its neighbors share a tile and, at four bytes a pin, every
+// aligned 4x4 block shares a cache line. Rows of tiles are padded to a power of two so slots and positions
+// convert with shifts and masks alone. Pin ids stay row major, they are what the records and files use.
+class PinLayout
+{
+public:
+    static constexpr uint32_t TileShift = 3;
+    static constexpr uint32_t TileSize = 1 << TileShift;
+    static constexpr uint32_t NoPin = std::numeric_limits<uint32_t>::max();  // Id of the padding slots
+
+    PinLayout(sf::Vector2u grid = { 0, 0 })
+        : mGrid(grid)
+    {
+        uint32_t tileCountX = (grid.x + TileSize - 1) >> TileShift;
+        while ((1u << mTileRowShift) < tileCountX)
+        {
+            mTileRowShift++;
+        }
+        mTileRowCount = (grid.y + TileSize - 1) >> TileShift;
+    }
+
+    uint32_t GetSlotCount() const
+    {
+        return (mTileRowCount << mTileRowShift) << (2 * TileShift);
+    }
+
+    // Whether the padded slots of the grid can be numbered in 32 bits, counted in 64 so that no grid wraps
+    static bool IsGridSupported(sf::Vector2u grid)
+    {
+        uint64_t tileRowSize = 1;
+        while (tileRowSize < ((static_cast<uint64_t>(grid.x) + TileSize - 1) >> TileShift))
+        {
+            tileRowSize <<= 1;
+        }
+        uint64_t tileRowCount = (static_cast<uint64_t>(grid.y) + TileSize - 1) >> TileShift;
+        return tileRowCount * tileRowSize <= (std::numeric_limits<uint32_t>::max() >> (2 * TileShift));
+    }
+
+    uint32_t GetSlot(uint32_t x, uint32_t y) const
+    {
+        uint32_t tile = ((y >> TileShift) << mTileRowShift) | (x >> TileShift);
+        return (tile << (2 * TileShift)) | Interleave(x & (TileSize - 1)) | (Interleave(y & (TileSize - 1)) << 1);
+    }
+
+    // The one conversion that divides, ids come from outside the board
+    uint32_t GetSlot(uint32_t pinId) const
+    {
+        return GetSlot(pinId % mGrid.x, pinId / mGrid.x);
+    }
+
+    sf::Vector2u GetPosition(uint32_t slot) const
+    {
+        uint32_t tile = slot >> (2 * TileShift);
+        uint32_t x = ((tile & ((1u << mTileRowShift) - 1)) << TileShift) | Deinterleave(slot);
+        uint32_t y = ((tile >> mTileRowShift) << TileShift) | Deinterleave(slot >> 1);
+        return { x, y };
+    }
+
+    uint32_t GetPinId(uint32_t slot) const
+    {
+        sf::Vector2u position = GetPosition(slot);
+        return position.x < mGrid.x && position.y < mGrid.y ? position.x + position.y * mGrid.x : NoPin;
+    }
+
+private:
+    // Spreads the three low bits to every other bit, and back
+    static uint32_t Interleave(uint32_t value)
+    {
+        value = (value | (value << 2)) & 0x13;
+        return (value | (value << 1)) & 0x15;
+    }
+
+    static uint32_t Deinterleave(uint32_t value)
+    {
+        value &= 0x15;
+        value = (value | (value >> 1)) & 0x13;
+        return (value | (value >> 2)) & 0x07;
+    }
+
+    sf::Vector2u mGrid;
+    uint32_t mTileRowShift{ 0 };
+    uint32_t mTileRowCount{ 0 };
+};
\ No newline at end of file
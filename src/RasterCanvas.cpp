@@ -0,0 +1,166 @@
+#include "RasterCanvas.h"
+
+#include <algorithm>
+#include <cmath>
+
+void RasterCanvas::Reset(sf::Vector2u size, sf::Vector2f worldOrigin, float pixelsPerUnit, sf::Color background)
+{
+    mSize = size;
+    mWorldOrigin = worldOrigin;
+    mPixelsPerUnit = pixelsPerUnit;
+    mPixels.assign(static_cast<size_t>(size.x) * size.y, background);
+}
+
+void RasterCanvas::DrawLines(const sf::Vertex* vertices, size_t vertexCount)
+{
+    for (size_t index = 0; index + 1 < vertexCount; index += 2)
+    {
+        DrawLine(ToPixel(vertices[index].position), ToPixel(vertices[index + 1].position), vertices[index].color);
+    }
+}
+
+void RasterCanvas::DrawPoint(sf::Vector2f position, float radius, sf::Color color)
+{
+    FillRing(ToPixel(position), 0.0f, std::max(radius * mPixelsPerUnit, 0.5f), color);
+}
+
+void RasterCanvas::DrawCircleOutline(sf::Vector2f center, float radius, sf::Color color)
+{
+    float innerRadius = radius * mPixelsPerUnit;
+    FillRing(ToPixel(center), innerRadius, innerRadius + std::max(mPixelsPerUnit, 1.0f), color);
+}
+
+void RasterCanvas::DrawRectOutline(const sf::FloatRect& rect, sf::Color color)
+{
+    sf::Vector2f topLeft = ToPixel(rect.getPosition());
+    sf::Vector2f bottomRight = ToPixel(rect.getPosition() + rect.getSize());
+    float thickness = std::max(mPixelsPerUnit, 1.0f);
+
+    FillRect(topLeft.x - thickness, topLeft.y - thickness, bottomRight.x + thickness, topLeft.y, color);
+    FillRect(topLeft.x - thickness, bottomRight.y, bottomRight.x + thickness, bottomRight.y + thickness, color);
+    FillRect(topLeft.x - thickness, topLeft.y, topLeft.x, bottomRight.y, color);
+    FillRect(bottomRight.x, topLeft.y, bottomRight.x + thickness, bottomRight.y, color);
+}
+
+// Steps one pixel at a time along the longer axis, after clipping to just outside the image so a line
+// far off screen costs nothing
+void RasterCanvas::DrawLine(sf::Vector2f start, sf::Vector2f end, sf::Color color)
+{
+    sf::Vector2f delta = end - start;
+    float first = 0.0f;
+    float last = 1.0f;
+    auto clip = [&](float direction, float distance)
+    {
+        if (direction == 0.0f)
+        {
+            return distance >= 0.0f;
+        }
+
+        float t = distance / direction;
+        if (direction < 0.0f)
+        {
+            first = std::max(first, t);
+        }
+        else
+        {
+            last = std::min(last, t);
+        }
+        return first <= last;
+    };
+
+    float maxX = static_cast<float>(mSize.x) + 1.0f;
+    float maxY = static_cast<float>(mSize.y) + 1.0f;
+    if (!clip(-delta.x, start.x + 1.0f) || !clip(delta.x, maxX - start.x)
+        || !clip(-delta.y, start.y + 1.0f) || !clip(delta.y, maxY - start.y))
+    {
+        return;
+    }
+
+    sf::Vector2f from = start + delta * first;
+    sf::Vector2f span = delta * (last - first);
+    int32_t stepCount = static_cast<int32_t>(std::ceil(std::max(std::abs(span.x), std::abs(span.y))));
+    for (int32_t step = 0; step <= stepCount; step++)
+    {
+        sf::Vector2f position = stepCount == 0 ? from : from + span * (static_cast<float>(step) / stepCount);
+        int32_t x = static_cast<int32_t>(std::floor(position.x));
+        int32_t y = static_cast<int32_t>(std::floor(position.y));
+        if (x >= 0 && y >= 0 && x < static_cast<int32_t>(mSize.x) && y < static_cast<int32_t>(mSize.y))
+        {
+            Blend(mPixels[static_cast<size_t>(y) * mSize.x + x], color);
+        }
+    }
+}
+
+// A disc when the inner radius is zero, one or two spans a row
+void RasterCanvas::FillRing(sf::Vector2f center, float innerRadius, float outerRadius, sf::Color color)
+{
+    float height = static_cast<float>(mSize.y);
+    int32_t top = static_cast<int32_t>(std::floor(std::clamp(center.y - outerRadius, 0.0f, height)));
+    int32_t bottom = static_cast<int32_t>(std::ceil(std::clamp(center.y + outerRadius, 0.0f, height)));
+    for (int32_t y = top; y < bottom; y++)
+    {
+        float offsetY = y + 0.5f - center.y;
+        if (std::abs(offsetY) > outerRadius)
+        {
+            continue;
+        }
+
+        float outerHalf = std::sqrt(outerRadius * outerRadius - offsetY * offsetY);
+        if (std::abs(offsetY) < innerRadius)
+        {
+            float innerHalf = std::sqrt(innerRadius * innerRadius - offsetY * offsetY);
+            FillSpan(y, center.x - outerHalf, center.x - innerHalf, color);
+            FillSpan(y, center.x + innerHalf, center.x + outerHalf, color);
+        }
+        else
+        {
+            FillSpan(y, center.x - outerHalf, center.x + outerHalf, color);
+        }
+    }
+}
+
+void RasterCanvas::FillRect(float left, float top, float right, float bottom, sf::Color color)
+{
+    float height = static_cast<float>(mSize.y);
+    int32_t firstRow = static_cast<int32_t>(std::ceil(std::clamp(top, 0.0f, height) - 0.5f));
+    int32_t endRow = static_cast<int32_t>(std::ceil(std::clamp(bottom, 0.0f, height) - 0.5f));
+    for (int32_t y = firstRow; y < endRow; y++)
+    {
+        FillSpan(y, left, right, color);
+    }
+}
+
+// Pixels whose centers lie in [left, right)
+void RasterCanvas::FillSpan(int32_t y, float left, float right, sf::Color color)
+{
+    if (y < 0 || y >= static_cast<int32_t>(mSize.y) || !(left < right))
+    {
+        return;
+    }
+
+    float width = static_cast<float>(mSize.x);
+    int32_t first = static_cast<int32_t>(std::ceil(std::clamp(left, 0.0f, width) - 0.5f));
+    int32_t end = static_cast<int32_t>(std::ceil(std::clamp(right, 0.0f, width) - 0.5f));
+    sf::Color* row = mPixels.data() + static_cast<size_t>(y) * mSize.x;
+    for (int32_t x = first; x < end; x++)
+    {
+        Blend(row[x], color);
+    }
+}
+
+void RasterCanvas::Blend(sf::Color& pixel, sf::Color color)
+{
+    if (color.a == 255)
+    {
+        pixel = color;
+        return;
+    }
+
+    uint32_t alpha = color.a;
+    auto mix = [&](uint8_t source, uint8_t destination)
+    {
+        return static_cast<uint8_t>((source * alpha + destination * (255 - alpha) + 127) / 255);
+    };
+    pixel = sf::Color(mix(color.r, pixel.r), mix(color.g, pixel.g), mix(color.b, pixel.b),
+        static_cast<uint8_t>(alpha + (pixel.a * (255 - alpha) + 127) / 255));
+}
\ No newline at end of file
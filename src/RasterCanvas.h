@@ -0,0 +1,44 @@
+#pragma once
+
+#include "DrawUtils.h"
+#include "MemoryTracker.h"
+
+#include <SFML/Graphics.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+// Software rasterizer behind the canvas, for images that are rendered without a window or a GPU. Draws
+// a rectangle of the world into a pixel buffer that is reused from one image to the next. Edges are not
+// antialiased, a pixel is covered when its center is.
+class RasterCanvas : public Canvas
+{
+public:
+    // World origin is the top left corner of the image
+    void Reset(sf::Vector2u size, sf::Vector2f worldOrigin, float pixelsPerUnit, sf::Color background);
+
+    sf::Vector2u GetSize() const { return mSize; }
+    const sf::Color* GetPixels() const { return mPixels.data(); }  // Row major
+
+    virtual void DrawLines(const sf::Vertex* vertices, size_t vertexCount) override;
+    virtual void DrawPoint(sf::Vector2f position, float radius, sf::Color color) override;
+    virtual void DrawCircleOutline(sf::Vector2f center, float radius, sf::Color color) override;
+    virtual void DrawRectOutline(const sf::FloatRect& rect, sf::Color color) override;
+
+private:
+    sf::Vector2f ToPixel(sf::Vector2f position) const
+    {
+        return (position - mWorldOrigin) * mPixelsPerUnit;
+    }
+
+    void DrawLine(sf::Vector2f start, sf::Vector2f end, sf::Color color);  // In pixels
+    void FillRing(sf::Vector2f center, float innerRadius, float outerRadius, sf::Color color);
+    void FillRect(float left, float top, float right, float bottom, sf::Color color);
+    void FillSpan(int32_t y, float left, float right, sf::Color color);
+    void Blend(sf::Color& pixel, sf::Color color);
+
+    sf::Vector2u mSize;
+    sf::Vector2f mWorldOrigin;
+    float mPixelsPerUnit{ 1.0f };
+    TrackedVector<sf::Color, MemoryTag::RenderCaches> mPixels;
+};
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "TwoTerminalComponent.h"
+
+class Resistor : public TwoTerminalComponent
+{
+public:
+    Resistor() = default;
+    Resistor(ICircuitBoardNavigator* navigator)
+        : TwoTerminalComponent(navigator, DefaultResistance)
+    { }
+
+    virtual Component* Create(ICircuitBoardNavigator* navigator) const override
+    {
+        return new Resistor(navigator);
+    }
+
+    virtual const char* GetTypeName() const override
+    {
+        return "Resistor";
+    }
+
+    virtual ElementKind GetElementKind() const override
+    {
+        return ElementKind::Resistor;
+    }
+
+    virtual void DrawComponent(Canvas& canvas) const override
+    {
+        sf::FloatRect body = DrawLeads(canvas);
+
+        canvas.DrawRectOutline(body, mColor);
+    }
+
+    virtual void DrawIcon(sf::RenderTarget& target, const sf::Transform& transform, const sf::FloatRect& localBounds) override
+    {
+        sf::RenderStates states;
+        states.transform = transform;
+
+        sf::RectangleShape rectangle({ localBounds.width, localBounds.height / 3.0f });
+        rectangle.setPosition({ localBounds.left, localBounds.top + localBounds.height / 3.0f });
+        rectangle.setFillColor(sf::Color::Blue);
+
+        target.draw(rectangle, states);
+    }
+
+private:
+    static constexpr double DefaultResistance = 1000.0;
+};
\ No newline at end of file
@@ -0,0 +1,456 @@
+#include "Simulation.h"
+#include "CircuitBoard.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <limits>
+
+SimulationCommand SimulationCommand::AddComponent(uint32_t componentId, const Component& component)
+{
+    auto [firstPinId, secondPinId] = component.GetTerminalPinIds();
+    auto [firstTiedPinId, secondTiedPinId] = component.GetTiedPinIds();
+    return {
+        Type::AddComponent, component.GetElementKind(), componentId, static_cast<uint32_t>(component.GetComponentPins().size()),
+        { firstPinId, secondPinId }, { firstTiedPinId, secondTiedPinId }, 0, 0, component.GetValue()
+    };
+}
+
+SimulationCommand SimulationCommand::AddConnection(const ConnectionRecord& connection)
+{
+    return {
+        Type::AddConnection, ElementKind::None, connection.mSourceComponent, 0,
+        { connection.mSourceComponentPin, 0 }, { 0, 0 }, connection.mTargetComponent, connection.mTargetComponentPin, 0.0
+    };
+}
+
+SimulationCommand SimulationCommand::SetValue(uint32_t componentId, double value)
+{
+    return { Type::SetValue, ElementKind::None, componentId, 0, { 0, 0 }, { 0, 0 }, 0, 0, value };
+}
+
+SimulationCommand SimulationCommand::Checkpoint(double time)
+{
+    return { Type::Checkpoint, ElementKind::None, 0, 0, { 0, 0 }, { 0, 0 }, 0, 0, time };
+}
+
+namespace
+{
+    uint64_t HashWords(uint64_t hash, std::initializer_list<uint32_t> words)
+    {
+        for (uint32_t word : words)
+        {
+            for (uint32_t byte = 0; byte < 4; byte++)
+            {
+                hash = (hash ^ ((word >> (8 * byte)) & 0xFF)) * 1099511628211ull;
+            }
+        }
+        return hash;
+    }
+}
+
+BoardFingerprint BoardFingerprint::Of(const CircuitBoard& circuitBoard, size_t componentCount, size_t connectionCount)
+{
+    BoardFingerprint fingerprint;
+    for (uint32_t componentId = 0; componentId < componentCount; componentId++)
+    {
+        fingerprint.AddComponent(SimulationCommand::AddComponent(componentId, circuitBoard.GetComponent(componentId)));
+    }
+    for (size_t index = 0; index < connectionCount; index++)
+    {
+        fingerprint.AddConnection(SimulationCommand::AddConnection(circuitBoard.GetConnection(index)));
+    }
+    return fingerprint;
+}
+
+void BoardFingerprint::AddComponent(const SimulationCommand& command)
+{
+    mComponentHash = HashWords(mComponentHash, {
+        static_cast<uint32_t>(command.mElementKind), command.mPinCount,
+        command.mPinIds[0], command.mPinIds[1], command.mTiedPinIds[0], command.mTiedPinIds[1]
+    });
+}
+
+void BoardFingerprint::AddConnection(const SimulationCommand& command)
+{
+    mConnectionHash = HashWords(mConnectionHash, { command.mComponentId, command.mPinIds[0], command.mTargetComponentId, command.mTargetPinId });
+}
+
+std::optional<double> SimulationState::GetComponentValue(uint32_t componentId) const
+{
+    if (componentId >= mComponentElements.size() || mComponentElements[componentId] == NoElement)
+    {
+        return std::nullopt;
+    }
+
+    // A lamp's element holds its hot resistance
+    uint32_t elementIndex = mComponentElements[componentId];
+    auto lamp = std::lower_bound(mLamps.begin(), mLamps.end(), elementIndex);
+    if (lamp != mLamps.end() && *lamp == elementIndex)
+    {
+        return mColdResistances[lamp - mLamps.begin()];
+    }
+    return mElements[elementIndex].mValue;
+}
+
+Simulation::Simulation(JobSystem& jobSystem)
+    : mJobSystem(jobSystem)
+    , mSolver(jobSystem)
+{ }
+
+Simulation::~Simulation()
+{
+    Stop();
+}
+
+bool Simulation::Start(CircuitBoard& circuitBoard, const std::vector<Probe>& probes, const std::string& waveformPath, std::string& outError)
+{
+    Stop();
+
+    if (probes.size() > MaxProbes)
+    {
+        outError = "At most " + std::to_string(MaxProbes) + " probes";
+        return false;
+    }
+
+    mSolverMode = circuitBoard.GetSolverMode();
+    mState = SimulationState();
+    mState.mNetwork = circuitBoard.GetNetwork();
+    for (uint32_t componentId = 0; componentId < circuitBoard.GetComponentCount(); componentId++)
+    {
+        const Component& component = circuitBoard.GetComponent(componentId);
+        AddElement(componentId, component.GetElementKind(), component.GetValue(), component.GetTerminalPinIds());
+    }
+    mState.mFingerprint = BoardFingerprint::Of(circuitBoard, circuitBoard.GetComponentCount(), circuitBoard.GetConnectionCount());
+
+    mState.mProbes = probes;
+    mState.mProbeMinimums.assign(probes.size(), 0.0f);
+    mState.mProbeMaximums.assign(probes.size(), 0.0f);
+    return Launch(waveformPath, outError);
+}
+
+bool Simulation::Start(const SimulationCheckpoint& checkpoint, const std::string& waveformPath, std::string& outError)
+{
+    Stop();
+
+    mState = checkpoint.mState;
+    return Launch(waveformPath, outError);
+}
+
+bool Simulation::Launch(const std::string& waveformPath, std::string& outError)
+{
+    // Left over from a previous run
+    SimulationCommand command;
+    while (mCommands->TryPop(command))
+    {
+    }
+    mCheckpointSteps.clear();
+
+    CircuitNetwork& network = mState.mNetwork;
+    mProbeSlots.clear();
+    mProbeQueues.clear();
+    for (const Probe& probe : mState.mProbes)
+    {
+        mProbeSlots.push_back(network.GetSlot(probe.mComponentId, probe.mComponentPinId));
+        mProbeQueues.push_back(std::make_unique<ProbeQueue>());
+    }
+    mProbeValues.assign(mState.mProbes.size(), 0.0f);
+    ResolveNets();
+
+    double startTime = mState.mStepCount * TimeStep;
+    uint32_t probeCount = static_cast<uint32_t>(mState.mProbes.size());
+    if (!waveformPath.empty() && probeCount > 0 && !mWaveformWriter.Open(waveformPath, probeCount, TimeStep, startTime, outError))
+    {
+        return false;
+    }
+
+    mSolver.Reset();
+    mSolver.SetMode(mSolverMode);
+    mSolver.SetDeterministic(mIsDeterministic);
+    mTime = startTime;
+    mIsStopping = false;
+    mJobSystem.ReserveThread();
+    mThread = std::thread(&Simulation::Run, this);
+    return true;
+}
+
+void Simulation::Stop()
+{
+    if (!mThread.joinable())
+    {
+        return;
+    }
+
+    mIsStopping = true;
+    mThread.join();
+    mJobSystem.ReleaseThread();
+
+    if (mWaveformWriter.GetDroppedBlockCount() > 0)
+    {
+        std::cerr << "The disk fell behind, " << mWaveformWriter.GetDroppedBlockCount() << " waveform blocks were dropped" << std::endl;
+    }
+
+    std::string error;
+    if (!mWaveformWriter.Close(error))
+    {
+        std::cerr << error << std::endl;
+    }
+}
+
+void Simulation::TakeCheckpoints(std::vector<std::shared_ptr<const SimulationCheckpoint>>& outCheckpoints)
+{
+    std::lock_guard<std::mutex> lock(mCheckpointMutex);
+    outCheckpoints.insert(outCheckpoints.end(), mCheckpoints.begin(), mCheckpoints.end());
+    mCheckpoints.clear();
+}
+
+void Simulation::Run()
+{
+    auto start = std::chrono::steady_clock::now();
+    uint64_t firstStep = mState.mStepCount;
+    while (!mIsStopping)
+    {
+        Step();
+
+        // Ahead of real time, wait for the wall clock to catch up. Behind it, run flat out.
+        double elapsed = (mState.mStepCount - firstStep) * TimeStep;
+        auto due = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(elapsed));
+        if (due > std::chrono::steady_clock::now())
+        {
+            std::this_thread::sleep_until(due);
+        }
+    }
+}
+
+void Simulation::Step()
+{
+    ApplyCommands();
+
+    if (!mCheckpointSteps.empty() && mCheckpointSteps.back() <= mState.mStepCount)
+    {
+        while (!mCheckpointSteps.empty() && mCheckpointSteps.back() <= mState.mStepCount)
+        {
+            mCheckpointSteps.pop_back();
+        }
+        TakeCheckpoint();
+    }
+
+    std::vector<uint32_t>& lamps = mState.mLamps;
+    std::vector<double>& temperatures = mState.mTemperatures;
+    for (size_t lamp = 0; lamp < lamps.size(); lamp++)
+    {
+        mState.mElements[lamps[lamp]].mValue = mState.mColdResistances[lamp] * (1.0 + FilamentTemperatureCoefficient * temperatures[lamp]);
+        mSolver.MarkChanged(mState.mElements[lamps[lamp]]);
+    }
+
+    // Only partitions with lamps or edits are solved again after the first step
+    if (mIsRegroupNeeded)
+    {
+        mSolver.Solve(mState.mElements, mSlotCount, true);
+        mIsRegroupNeeded = false;
+    }
+    else
+    {
+        mSolver.SolveChanged(mState.mElements);
+    }
+
+    // Explicit Euler on the filament heat balance, the power comes from this step's solution. A filament
+    // whose partition was not solved keeps its temperature.
+    for (size_t lamp = 0; lamp < lamps.size(); lamp++)
+    {
+        const CircuitElement& element = mState.mElements[lamps[lamp]];
+        std::optional<double> elementVoltage = mSolver.GetElementVoltage(element);
+        if (!elementVoltage.has_value())
+        {
+            continue;
+        }
+
+        double voltage = elementVoltage.value();
+        double power = voltage * voltage / std::max(element.mValue, CircuitSolver::MinResistance);
+        temperatures[lamp] += TimeStep * (power - FilamentHeatLoss * temperatures[lamp]) / FilamentHeatCapacity;
+    }
+
+    mState.mStepCount++;
+    double time = mState.mStepCount * TimeStep;
+    mTime.store(time, std::memory_order_relaxed);
+
+    std::vector<float>& minimums = mState.mProbeMinimums;
+    std::vector<float>& maximums = mState.mProbeMaximums;
+    for (size_t probe = 0; probe < mProbeNets.size(); probe++)
+    {
+        std::optional<double> voltage = mSolver.GetNetVoltage(mProbeNets[probe]);
+        float value = voltage.has_value() ? static_cast<float>(voltage.value()) : std::numeric_limits<float>::quiet_NaN();
+        mProbeValues[probe] = value;
+
+        // Unsolved is NaN, which the minimum and maximum skip unless every step of the window is unsolved
+        bool isFirst = mState.mDecimationCount == 0 || std::isnan(minimums[probe]);
+        minimums[probe] = isFirst ? value : std::min(minimums[probe], value);
+        maximums[probe] = isFirst ? value : std::max(maximums[probe], value);
+    }
+
+    if (mWaveformWriter.IsOpen())
+    {
+        mWaveformWriter.Append(mProbeValues.data());
+    }
+
+    if (++mState.mDecimationCount == ProbeDecimation)
+    {
+        mState.mDecimationCount = 0;
+        for (size_t probe = 0; probe < mProbeNets.size(); probe++)
+        {
+            mProbeQueues[probe]->TryPush({ time, minimums[probe], maximums[probe] });
+        }
+    }
+}
+
+void Simulation::ApplyCommands()
+{
+    bool isTopologyChanged = false;
+    size_t firstNewElement = mState.mElements.size();
+    mTouchedPartitions.clear();
+    mChangedElements.clear();
+    SimulationCommand command;
+    while (mCommands->TryPop(command))
+    {
+        switch (command.mType)
+        {
+        case SimulationCommand::Type::AddComponent:
+        {
+            // Components must come in id order
+            bool hasTerminals = command.mPinIds[0] < command.mPinCount && command.mPinIds[1] < command.mPinCount
+                && command.mTiedPinIds[0] < command.mPinCount && command.mTiedPinIds[1] < command.mPinCount;
+            if (command.mComponentId != mState.mNetwork.GetComponentCount() || (command.mElementKind != ElementKind::None && !hasTerminals))
+            {
+                break;
+            }
+
+            std::optional<std::pair<uint32_t, uint32_t>> terminalPinIds;
+            std::optional<std::pair<uint32_t, uint32_t>> tiedPinIds;
+            if (command.mElementKind != ElementKind::None)
+            {
+                terminalPinIds = std::make_pair(command.mPinIds[0], command.mPinIds[1]);
+                tiedPinIds = std::make_pair(command.mTiedPinIds[0], command.mTiedPinIds[1]);
+            }
+            mState.mNetwork.AddComponent(command.mPinCount, terminalPinIds, tiedPinIds);
+            mState.mFingerprint.AddComponent(command);
+            AddElement(command.mComponentId, command.mElementKind, command.mValue, { command.mPinIds[0], command.mPinIds[1] });
+            isTopologyChanged = true;
+            break;
+        }
+
+        case SimulationCommand::Type::AddConnection:
+            if (command.mComponentId < mState.mNetwork.GetComponentCount() && command.mTargetComponentId < mState.mNetwork.GetComponentCount())
+            {
+                CircuitNetwork& network = mState.mNetwork;
+                mTouchedPartitions.push_back(network.FindPartition(network.GetSlot(command.mComponentId, command.mPinIds[0])));
+                mTouchedPartitions.push_back(network.FindPartition(network.GetSlot(command.mTargetComponentId, command.mTargetPinId)));
+                network.AddConnection(command.mComponentId, command.mPinIds[0], command.mTargetComponentId, command.mTargetPinId);
+                mState.mFingerprint.AddConnection(command);
+                isTopologyChanged = true;
+            }
+            break;
+
+        case SimulationCommand::Type::Checkpoint:
+        {
+            uint64_t step = static_cast<uint64_t>(std::max(std::ceil(command.mValue / TimeStep - 1e-9), 0.0));
+            mCheckpointSteps.insert(std::upper_bound(mCheckpointSteps.begin(), mCheckpointSteps.end(), step, std::greater<uint64_t>()), step);
+            break;
+        }
+
+        case SimulationCommand::Type::SetValue:
+        {
+            if (command.mComponentId >= mState.mComponentElements.size() || mState.mComponentElements[command.mComponentId] == SimulationState::NoElement)
+            {
+                break;
+            }
+
+            // A lamp's value is its cold resistance, the hot one follows from it on every step
+            uint32_t elementIndex = mState.mComponentElements[command.mComponentId];
+            mState.mElements[elementIndex].mValue = command.mValue;
+            mChangedElements.push_back(elementIndex);
+            auto lamp = std::lower_bound(mState.mLamps.begin(), mState.mLamps.end(), elementIndex);
+            if (lamp != mState.mLamps.end() && *lamp == elementIndex)
+            {
+                mState.mColdResistances[lamp - mState.mLamps.begin()] = command.mValue;
+            }
+            break;
+        }
+        }
+    }
+
+    // Before the first solve every partition is grouped anyway
+    if (isTopologyChanged && mIsRegroupNeeded)
+    {
+        ResolveNets();
+    }
+    else if (isTopologyChanged)
+    {
+        mSolver.Regroup(mState.mElements, mState.mElementSlots, mState.mNetwork, mTouchedPartitions, firstNewElement);
+        for (size_t probe = 0; probe < mProbeSlots.size(); probe++)
+        {
+            mProbeNets[probe] = mState.mNetwork.FindNet(mProbeSlots[probe]);
+        }
+        mSlotCount = mState.mNetwork.GetSlotCount();
+    }
+
+    for (uint32_t elementIndex : mChangedElements)
+    {
+        mSolver.MarkChanged(mState.mElements[elementIndex]);
+    }
+}
+
+void Simulation::AddElement(uint32_t componentId, ElementKind kind, double value, std::pair<uint32_t, uint32_t> terminalPinIds)
+{
+    if (kind == ElementKind::None)
+    {
+        mState.mComponentElements.push_back(SimulationState::NoElement);
+        return;
+    }
+
+    uint32_t elementIndex = static_cast<uint32_t>(mState.mElements.size());
+    mState.mComponentElements.push_back(elementIndex);
+    mState.mElements.push_back({ kind, value, { 0, 0 }, 0 });
+    mState.mElementSlots.push_back(mState.mNetwork.GetSlot(componentId, terminalPinIds.first));
+    mState.mElementSlots.push_back(mState.mNetwork.GetSlot(componentId, terminalPinIds.second));
+
+    if (kind == ElementKind::Lamp)
+    {
+        mState.mLamps.push_back(elementIndex);
+        mState.mColdResistances.push_back(value);
+        mState.mTemperatures.push_back(0.0);
+    }
+}
+
+// Merges move the root slots, every element and probe looks its nets up again for the full regroup of the first step
+void Simulation::ResolveNets()
+{
+    for (uint32_t elementIndex = 0; elementIndex < mState.mElements.size(); elementIndex++)
+    {
+        CircuitElement& element = mState.mElements[elementIndex];
+        element.mNets[0] = mState.mNetwork.FindNet(mState.mElementSlots[2 * elementIndex]);
+        element.mNets[1] = mState.mNetwork.FindNet(mState.mElementSlots[2 * elementIndex + 1]);
+        element.mPartition = mState.mNetwork.FindPartition(mState.mElementSlots[2 * elementIndex]);
+    }
+
+    mProbeNets.resize(mProbeSlots.size());
+    for (size_t probe = 0; probe < mProbeSlots.size(); probe++)
+    {
+        mProbeNets[probe] = mState.mNetwork.FindNet(mProbeSlots[probe]);
+    }
+
+    mSlotCount = mState.mNetwork.GetSlotCount();
+    mIsRegroupNeeded = true;
+}
+
+void Simulation::TakeCheckpoint()
+{
+    auto checkpoint = std::make_shared<SimulationCheckpoint>();
+    checkpoint->mState = mState;
+    checkpoint->mNetVoltages = mSolver.GetNetVoltages();
+    checkpoint->mWaveformSampleCount = mWaveformWriter.GetSampleCount();
+
+    std::lock_guard<std::mutex> lock(mCheckpointMutex);
+    mCheckpoints.push_back(std::move(checkpoint));
+}
\ No newline at end of file
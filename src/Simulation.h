@@ -0,0 +1,223 @@
+#pragma once
+
+#include "BoardFormat.h"
+#include "CircuitNetwork.h"
+#include "CircuitSolver.h"
+#include "MpscQueue.h"
+#include "SpscQueue.h"
+#include "JobSystem.h"
+#include "WaveformStore.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class CircuitBoard;
+
+// Watches the voltage of the net at a component pin, against the ground of its partition
+struct Probe
+{
+    uint32_t mComponentId;
+    uint32_t mComponentPinId;
+};
+
+// Minimum and maximum of a probe over the steps of one decimation window ending at mTime, NaN when the
+// partition of the probe was not solved in any of them
+struct ProbeSample
+{
+    double mTime;
+    float mMinimum;
+    float mMaximum;
+};
+
+// An edit of the running circuit. Components and connections come in the order they were added to the
+// board, so every connection comes after its components.
+struct SimulationCommand
+{
+    enum class Type : uint8_t
+    {
+        AddComponent,   // mComponentId with mPinCount pins, an element unless mElementKind is None
+        AddConnection,  // mPinIds[0] of mComponentId to mTargetPinId of mTargetComponentId
+        SetValue,       // mValue of the element mComponentId
+        Checkpoint      // At the first step boundary at or after mValue seconds
+    };
+
+    static SimulationCommand AddComponent(uint32_t componentId, const Component& component);
+    static SimulationCommand AddConnection(const ConnectionRecord& connection);
+    static SimulationCommand SetValue(uint32_t componentId, double value);
+    static SimulationCommand Checkpoint(double time);
+
+    Type mType;
+    ElementKind mElementKind;
+    uint32_t mComponentId;
+    uint32_t mPinCount;
+    uint32_t mPinIds[2];  // Terminals of an added element, or the source pin of a connection
+    uint32_t mTiedPinIds[2];  // Of an added element, see Component::GetTiedPinIds
+    uint32_t mTargetComponentId;
+    uint32_t mTargetPinId;
+    double mValue;
+};
+
+// Running hashes over the components and connections a run was built from, in board order, without the
+// element values. A checkpoint resumes only on a board whose first components and connections hash the same.
+struct BoardFingerprint
+{
+    static constexpr uint64_t OffsetBasis = 14695981039346656037ull;  // FNV-1a
+
+    uint64_t mComponentHash{ OffsetBasis };
+    uint64_t mConnectionHash{ OffsetBasis };
+
+    // Of the first components and connections of the board
+    static BoardFingerprint Of(const CircuitBoard& circuitBoard, size_t componentCount, size_t connectionCount);
+
+    void AddComponent(const SimulationCommand& command);
+    void AddConnection(const SimulationCommand& command);
+
+    bool operator==(const BoardFingerprint& other) const
+    {
+        return mComponentHash == other.mComponentHash && mConnectionHash == other.mConnectionHash;
+    }
+};
+
+// Everything a run carries from one step to the next
+struct SimulationState
+{
+    uint64_t mStepCount{ 0 };
+    CircuitNetwork mNetwork;  // Copy of the board's, grows with the edits
+    BoardFingerprint mFingerprint;  // Of the components and connections in mNetwork
+    CircuitElements mElements;
+    TrackedVector<uint32_t, MemoryTag::Solver> mElementSlots;       // Per element, the slots of its terminals
+    TrackedVector<uint32_t, MemoryTag::Solver> mComponentElements;  // Per component id, or NoElement
+
+    // Per lamp in element order, the element index, the cold resistance and the filament temperature
+    // above ambient
+    std::vector<uint32_t> mLamps;
+    std::vector<double> mColdResistances;
+    std::vector<double> mTemperatures;
+
+    // Per probe, with the extremes of the decimation window in progress
+    std::vector<Probe> mProbes;
+    std::vector<float> mProbeMinimums;
+    std::vector<float> mProbeMaximums;
+    uint32_t mDecimationCount{ 0 };
+
+    static constexpr uint32_t NoElement = 0xFFFFFFFF;
+
+    // The value a SetValue command last gave the component, none when it is not an element
+    std::optional<double> GetComponentValue(uint32_t componentId) const;
+};
+
+// The state of a run at a step boundary, with the net voltages solved in the step before it and how far
+// the run had written its waveform file. Checkpoints are immutable once taken, any number of simulations
+// can resume from the same one.
+struct SimulationCheckpoint
+{
+    SimulationState mState;
+    TrackedVector<double, MemoryTag::Solver> mNetVoltages;  // Per slot, set on root slots
+    uint64_t mWaveformSampleCount{ 0 };
+};
+
+bool WriteCheckpointFile(const SimulationCheckpoint& checkpoint, const std::string& filePath, std::string& outError);
+std::shared_ptr<const SimulationCheckpoint> ReadCheckpointFile(const std::string& filePath, std::string& outError);
+
+// Transient run of a copy of the board's circuit on a simulation thread, paced to real time. The thread
+// reserves one of the job system, so a worker sleeps while it runs. Every step solves the circuit on the job
+// system and then advances the lamp filament temperatures. Probe samples are decimated on the
+// simulation thread and handed to the render thread through one wait-free queue per probe, a full queue
+// drops samples rather than stall the simulation, as the waveform file drops blocks when the disk falls behind.
+// Edits reach the running copy through a lock-free command queue and are applied between two steps.
+// Topology edits keep the simulation state, the copy's own network takes the new components and
+// connections and the solver regroups only the partitions they merged. A step solves again only the
+// partitions holding lamps or edited elements, the others keep their voltages.
+// A run can be checkpointed at chosen times without stopping it and started again from a checkpoint.
+class Simulation
+{
+public:
+    static constexpr double TimeStep = 1e-3;          // Simulated seconds per step
+    static constexpr uint32_t ProbeDecimation = 10;   // Steps per probe sample
+    static constexpr size_t ProbeQueueCapacity = 1024;
+    static constexpr size_t MaxProbes = 64;
+    static constexpr size_t CommandQueueCapacity = 1024;
+
+    // Filament resistance rises by TemperatureCoefficient of its cold value per kelvin above ambient
+    static constexpr double FilamentTemperatureCoefficient = 0.0045;
+    static constexpr double FilamentHeatCapacity = 0.01;  // Joules per kelvin
+    static constexpr double FilamentHeatLoss = 0.005;     // Watts per kelvin above ambient
+
+    using ProbeQueue = SpscQueue<ProbeSample, ProbeQueueCapacity>;
+    using CommandQueue = MpscQueue<SimulationCommand, CommandQueueCapacity>;
+
+    explicit Simulation(JobSystem& jobSystem = JobSystem::GetShared());
+    Simulation(const Simulation&) = delete;
+    Simulation& operator=(const Simulation&) = delete;
+    ~Simulation();
+
+    // With a waveform path every probe is also written to a waveform file at the full step rate
+    bool Start(CircuitBoard& circuitBoard, const std::vector<Probe>& probes, const std::string& waveformPath, std::string& outError);
+
+    // Resumes the run of the checkpoint, the waveform file starts at the checkpoint time
+    bool Start(const SimulationCheckpoint& checkpoint, const std::string& waveformPath, std::string& outError);
+    void Stop();
+
+    // Used from the next start, starting from a board takes the mode of the board
+    void SetSolverMode(SolverMode mode) { mSolverMode = mode; }
+
+    // Used from the next start, bitwise reproducible steps on any thread count (see CircuitSolver). On by
+    // default, so a run resumed from a checkpoint repeats the steps of the original run on any machine.
+    void SetDeterministic(bool isDeterministic) { mIsDeterministic = isDeterministic; }
+
+    bool IsRunning() const { return mThread.joinable(); }
+    double GetTime() const { return mTime.load(std::memory_order_relaxed); }
+
+    // Any thread, applied before the next step. A full queue refuses the command, commands posted while
+    // stopped are dropped by the next start.
+    bool PostCommand(const SimulationCommand& command) { return mCommands->TryPush(command); }
+
+    // Checkpoints taken since the last call, oldest first. Taking them copies the state on the simulation
+    // thread, which delays that one step.
+    void TakeCheckpoints(std::vector<std::shared_ptr<const SimulationCheckpoint>>& outCheckpoints);
+
+    // Consumer side, read from one thread only
+    size_t GetProbeCount() const { return mProbeQueues.size(); }
+    ProbeQueue& GetProbeQueue(size_t probe) { return *mProbeQueues[probe]; }
+
+private:
+    bool Launch(const std::string& waveformPath, std::string& outError);
+    void Run();
+    void Step();
+    void ApplyCommands();
+    void AddElement(uint32_t componentId, ElementKind kind, double value, std::pair<uint32_t, uint32_t> terminalPinIds);
+    void ResolveNets();
+    void TakeCheckpoint();
+
+    JobSystem& mJobSystem;
+    CircuitSolver mSolver;
+    SolverMode mSolverMode{ SolverMode::Dense };
+    bool mIsDeterministic{ true };
+    std::unique_ptr<CommandQueue> mCommands{ std::make_unique<CommandQueue>() };
+    SimulationState mState;
+    size_t mSlotCount{ 0 };
+    bool mIsRegroupNeeded{ false };
+    std::vector<uint32_t> mTouchedPartitions;  // Root slots of the partitions this step's edits merged, before the merges
+    std::vector<uint32_t> mChangedElements;
+
+    std::vector<uint64_t> mCheckpointSteps;  // Scheduled, soonest last
+    std::mutex mCheckpointMutex;
+    std::vector<std::shared_ptr<const SimulationCheckpoint>> mCheckpoints;  // Taken, not handed out yet
+
+    std::vector<uint32_t> mProbeSlots;
+    std::vector<uint32_t> mProbeNets;  // Root slots
+    std::vector<std::unique_ptr<ProbeQueue>> mProbeQueues;
+    std::vector<float> mProbeValues;
+    WaveformWriter mWaveformWriter;
+
+    std::atomic<double> mTime{ 0 };
+    std::atomic<bool> mIsStopping{ false };
+    std::thread mThread;
+};
\ No newline at end of file
@@ -0,0 +1,245 @@
+#include "Simulation.h"
+#include "BoardFile.h"
+#include "CheckpointFormat.h"
+#include "MappedFile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+namespace
+{
+    template<typename Values>
+    bool WriteArray(std::FILE* file, const Values& values)
+    {
+        return values.empty() || std::fwrite(values.data(), sizeof(values[0]), values.size(), file) == values.size();
+    }
+
+    // Reads the arrays back to back, every read checked against the end of the file
+    class CheckpointFileReader
+    {
+    public:
+        CheckpointFileReader(const MappedFile& file, uint64_t offset)
+            : mFile(file)
+            , mOffset(offset)
+        { }
+
+        template<typename Values>
+        bool Read(Values& outValues, uint64_t count)
+        {
+            uint64_t valueSize = sizeof(outValues[0]);
+            if (count > mFile.GetSize() / valueSize || !BoardFileView::IsRangeWithin(mOffset, count * valueSize, mFile.GetSize()))
+            {
+                return false;
+            }
+
+            outValues.resize(count);
+            if (count > 0)
+            {
+                std::memcpy(outValues.data(), mFile.GetData() + mOffset, count * valueSize);
+            }
+            mOffset += count * valueSize;
+            return true;
+        }
+
+        bool IsAtEnd() const { return mOffset == mFile.GetSize(); }
+
+    private:
+        const MappedFile& mFile;
+        uint64_t mOffset;
+    };
+
+    // Only what the file could get wrong, the rest holds for any state a run produced
+    bool IsStateValid(SimulationState& state, size_t netVoltageCount)
+    {
+        CircuitNetwork& network = state.mNetwork;
+        size_t elementCount = state.mElements.size();
+        bool isValid = netVoltageCount == network.GetSlotCount()
+            && state.mComponentElements.size() == network.GetComponentCount()
+            && state.mElementSlots.size() == 2 * elementCount
+            && state.mProbes.size() <= Simulation::MaxProbes
+            && state.mDecimationCount < Simulation::ProbeDecimation;
+
+        for (size_t index = 0; isValid && index < elementCount; index++)
+        {
+            ElementKind kind = state.mElements[index].mKind;
+            isValid = kind == ElementKind::Resistor || kind == ElementKind::Lamp || kind == ElementKind::VoltageSource || kind == ElementKind::CurrentSource;
+        }
+        for (size_t index = 0; isValid && index < state.mElementSlots.size(); index++)
+        {
+            isValid = state.mElementSlots[index] < network.GetSlotCount();
+        }
+        for (size_t index = 0; isValid && index < state.mComponentElements.size(); index++)
+        {
+            isValid = state.mComponentElements[index] < elementCount || state.mComponentElements[index] == SimulationState::NoElement;
+        }
+        for (size_t index = 0; isValid && index < state.mLamps.size(); index++)
+        {
+            isValid = state.mLamps[index] < elementCount && (index == 0 || state.mLamps[index] > state.mLamps[index - 1]);
+        }
+        for (size_t index = 0; isValid && index < state.mProbes.size(); index++)
+        {
+            const Probe& probe = state.mProbes[index];
+            isValid = probe.mComponentId < network.GetComponentCount() && network.GetSlot(probe.mComponentId, probe.mComponentPinId) < network.GetSlotCount();
+        }
+        return isValid;
+    }
+}
+
+bool WriteCheckpointFile(const SimulationCheckpoint& checkpoint, const std::string& filePath, std::string& outError)
+{
+    const SimulationState& state = checkpoint.mState;
+    const CircuitNetwork& network = state.mNetwork;
+
+    CheckpointFileHeader header{};
+    header.mMagic = CheckpointFileHeader::Magic;
+    header.mVersion = CheckpointFileHeader::CurrentVersion;
+    header.mTimeStep = Simulation::TimeStep;
+    header.mStepCount = state.mStepCount;
+    header.mComponentCount = network.GetComponentCount();
+    header.mConnectionCount = network.GetConnectionCount();
+    header.mSlotCount = network.GetSlotCount();
+    header.mElementCount = state.mElements.size();
+    header.mLampCount = state.mLamps.size();
+    header.mProbeCount = static_cast<uint32_t>(state.mProbes.size());
+    header.mDecimationCount = state.mDecimationCount;
+    header.mWaveformSampleCount = checkpoint.mWaveformSampleCount;
+    header.mComponentHash = state.mFingerprint.mComponentHash;
+    header.mConnectionHash = state.mFingerprint.mConnectionHash;
+
+    std::vector<CheckpointElementRecord> elementRecords(state.mElements.size());
+    for (size_t index = 0; index < state.mElements.size(); index++)
+    {
+        elementRecords[index].mKind = static_cast<uint32_t>(state.mElements[index].mKind);
+        elementRecords[index].mValue = state.mElements[index].mValue;
+    }
+
+    std::vector<CheckpointProbeRecord> probeRecords(state.mProbes.size());
+    for (size_t index = 0; index < state.mProbes.size(); index++)
+    {
+        probeRecords[index].mComponentId = state.mProbes[index].mComponentId;
+        probeRecords[index].mComponentPinId = state.mProbes[index].mComponentPinId;
+    }
+
+    std::string temporaryPath = filePath + ".tmp";
+    std::FILE* file = std::fopen(temporaryPath.c_str(), "wb");
+    if (file == nullptr)
+    {
+        outError = "Cannot create " + temporaryPath;
+        return false;
+    }
+
+    bool isWritten = std::fwrite(&header, sizeof(header), 1, file) == 1
+        && WriteArray(file, network.GetFirstSlots())
+        && WriteArray(file, network.GetNetParents())
+        && WriteArray(file, network.GetPartitionParents())
+        && WriteArray(file, elementRecords)
+        && WriteArray(file, state.mElementSlots)
+        && WriteArray(file, state.mComponentElements)
+        && WriteArray(file, state.mLamps)
+        && WriteArray(file, state.mColdResistances)
+        && WriteArray(file, state.mTemperatures)
+        && WriteArray(file, probeRecords)
+        && WriteArray(file, state.mProbeMinimums)
+        && WriteArray(file, state.mProbeMaximums)
+        && WriteArray(file, checkpoint.mNetVoltages);
+    isWritten = std::fclose(file) == 0 && isWritten;
+
+    std::error_code error;
+    if (isWritten)
+    {
+        std::filesystem::rename(temporaryPath, filePath, error);
+        isWritten = !error;
+    }
+
+    if (!isWritten)
+    {
+        std::filesystem::remove(temporaryPath, error);
+        outError = "Cannot write " + filePath;
+    }
+    return isWritten;
+}
+
+std::shared_ptr<const SimulationCheckpoint> ReadCheckpointFile(const std::string& filePath, std::string& outError)
+{
+    MappedFile file;
+    if (!file.Open(filePath))
+    {
+        outError = "Cannot open " + filePath;
+        return nullptr;
+    }
+
+    CheckpointFileHeader header{};
+    if (file.GetSize() >= sizeof(header))
+    {
+        std::memcpy(&header, file.GetData(), sizeof(header));
+    }
+
+    if (header.mMagic != CheckpointFileHeader::Magic)
+    {
+        outError = "Not a checkpoint file";
+        return nullptr;
+    }
+
+    if (header.mVersion < CheckpointFileHeader::OldestVersion || header.mVersion > CheckpointFileHeader::CurrentVersion)
+    {
+        outError = "Unsupported checkpoint file version " + std::to_string(header.mVersion);
+        return nullptr;
+    }
+
+    if (header.mTimeStep != Simulation::TimeStep)
+    {
+        outError = "The checkpoint was taken with another time step";
+        return nullptr;
+    }
+
+    auto checkpoint = std::make_shared<SimulationCheckpoint>();
+    SimulationState& state = checkpoint->mState;
+    state.mStepCount = header.mStepCount;
+    state.mDecimationCount = header.mDecimationCount;
+    checkpoint->mWaveformSampleCount = header.mWaveformSampleCount;
+    state.mFingerprint.mComponentHash = header.mComponentHash;
+    state.mFingerprint.mConnectionHash = header.mConnectionHash;
+
+    CircuitNetwork::Forest firstSlots;
+    CircuitNetwork::Forest netParents;
+    CircuitNetwork::Forest partitionParents;
+    std::vector<CheckpointElementRecord> elementRecords;
+    std::vector<CheckpointProbeRecord> probeRecords;
+    CheckpointFileReader reader(file, sizeof(header));
+    bool isRead = reader.Read(firstSlots, header.mComponentCount)
+        && reader.Read(netParents, header.mSlotCount)
+        && reader.Read(partitionParents, header.mSlotCount)
+        && reader.Read(elementRecords, header.mElementCount)
+        && reader.Read(state.mElementSlots, 2 * header.mElementCount)
+        && reader.Read(state.mComponentElements, header.mComponentCount)
+        && reader.Read(state.mLamps, header.mLampCount)
+        && reader.Read(state.mColdResistances, header.mLampCount)
+        && reader.Read(state.mTemperatures, header.mLampCount)
+        && reader.Read(probeRecords, header.mProbeCount)
+        && reader.Read(state.mProbeMinimums, header.mProbeCount)
+        && reader.Read(state.mProbeMaximums, header.mProbeCount)
+        && reader.Read(checkpoint->mNetVoltages, header.mSlotCount)
+        && reader.IsAtEnd();
+
+    state.mElements.resize(elementRecords.size());
+    for (size_t index = 0; index < elementRecords.size(); index++)
+    {
+        state.mElements[index] = { static_cast<ElementKind>(elementRecords[index].mKind), elementRecords[index].mValue, { 0, 0 }, 0 };
+    }
+
+    state.mProbes.resize(probeRecords.size());
+    for (size_t index = 0; index < probeRecords.size(); index++)
+    {
+        state.mProbes[index] = { probeRecords[index].mComponentId, probeRecords[index].mComponentPinId };
+    }
+
+    if (!isRead
+        || !state.mNetwork.Restore(std::move(firstSlots), std::move(netParents), std::move(partitionParents), header.mConnectionCount)
+        || !IsStateValid(state, checkpoint->mNetVoltages.size()))
+    {
+        outError = "Corrupt checkpoint file";
+        return nullptr;
+    }
+    return checkpoint;
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Bounded wait-free queue between exactly one producer thread and one consumer thread. Neither side
+// blocks or allocates, a full queue refuses the push and an empty one the pop. Head and tail live on
+// their own cache lines so the two threads do not fight over them.
+template<typename T, size_t Capacity>
+class SpscQueue
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    // Producer side
+    bool TryPush(const T& value)
+    {
+        size_t tail = mTail.load(std::memory_order_relaxed);
+        if (tail - mCachedHead == Capacity)
+        {
+            mCachedHead = mHead.load(std::memory_order_acquire);
+            if (tail - mCachedHead == Capacity)
+            {
+                return false;
+            }
+        }
+
+        mBuffer[tail & (Capacity - 1)] = value;
+        mTail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool TryPop(T& outValue)
+    {
+        size_t head = mHead.load(std::memory_order_relaxed);
+        if (head == mCachedTail)
+        {
+            mCachedTail = mTail.load(std::memory_order_acquire);
+            if (head == mCachedTail)
+            {
+                return false;
+            }
+        }
+
+        outValue = mBuffer[head & (Capacity - 1)];
+        mHead.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    static constexpr size_t CacheLineSize = 64;
+
+    alignas(CacheLineSize) std::atomic<size_t> mHead{ 0 };
+    size_t mCachedTail{ 0 };  // Consumer's last view of the tail
+    alignas(CacheLineSize) std::atomic<size_t> mTail{ 0 };
+    size_t mCachedHead{ 0 };  // Producer's last view of the head
+    alignas(CacheLineSize) std::array<T, Capacity> mBuffer{};
+};
\ No newline at end of file
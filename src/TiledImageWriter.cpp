@@ -0,0 +1,212 @@
+#include "TiledImageWriter.h"
+
+#include <filesystem>
+#include <limits>
+
+namespace
+{
+    // Field types
+    constexpr uint16_t Short = 3;
+    constexpr uint16_t Long = 4;
+    constexpr uint16_t Long8 = 16;
+
+    constexpr uint16_t SamplesPerPixel = 3;
+    constexpr uint64_t InlineBitsPerSample = 0x0000000800080008;  // Three shorts of 8, fits a BigTIFF entry
+
+    // Everything in the file is little endian
+    void Append(std::vector<uint8_t>& bytes, uint64_t value, size_t size)
+    {
+        for (size_t index = 0; index < size; index++)
+        {
+            bytes.push_back(static_cast<uint8_t>(value >> (8 * index)));
+        }
+    }
+}
+
+TiledImageWriter::~TiledImageWriter()
+{
+    Discard();
+}
+
+bool TiledImageWriter::Open(const std::string& filePath, sf::Vector2u imageSize, uint32_t tileSize, std::string& outError)
+{
+    Discard();
+    if (imageSize.x == 0 || imageSize.y == 0 || tileSize == 0 || tileSize % 16 != 0)
+    {
+        outError = "Invalid image or tile size";
+        return false;
+    }
+
+    mFilePath = filePath;
+    mTemporaryPath = filePath + ".tmp";
+    mImageSize = imageSize;
+    mTileSize = tileSize;
+    mTileCount = { (imageSize.x + tileSize - 1) / tileSize, (imageSize.y + tileSize - 1) / tileSize };
+    mTileOffsets.clear();
+    mTileOffsets.reserve(GetTotalTileCount());
+
+    // Decided up front, the header format depends on it
+    uint64_t tileBytes = uint64_t(tileSize) * tileSize * SamplesPerPixel;
+    mIsBigTiff = GetTotalTileCount() * (tileBytes + 8) + 4096 > std::numeric_limits<uint32_t>::max();
+
+    mFile = std::fopen(mTemporaryPath.c_str(), "wb");
+    if (mFile == nullptr)
+    {
+        outError = "Cannot create " + mTemporaryPath;
+        return false;
+    }
+
+    // The directory offset is filled in on Close
+    mBuffer.clear();
+    Append(mBuffer, 'I' | ('I' << 8), 2);
+    if (mIsBigTiff)
+    {
+        Append(mBuffer, 43, 2);
+        Append(mBuffer, 8, 2);
+        Append(mBuffer, 0, 2);
+        Append(mBuffer, 0, 8);
+    }
+    else
+    {
+        Append(mBuffer, 42, 2);
+        Append(mBuffer, 0, 4);
+    }
+
+    mOffset = mBuffer.size();
+    if (std::fwrite(mBuffer.data(), 1, mBuffer.size(), mFile) != mBuffer.size())
+    {
+        outError = "Cannot write " + mTemporaryPath;
+        Discard();
+        return false;
+    }
+    return true;
+}
+
+bool TiledImageWriter::WriteTile(const sf::Color* pixels, std::string& outError)
+{
+    if (mFile == nullptr || mTileOffsets.size() == GetTotalTileCount())
+    {
+        outError = "No tile left to write";
+        return false;
+    }
+
+    size_t pixelCount = size_t(mTileSize) * mTileSize;
+    mBuffer.resize(pixelCount * SamplesPerPixel);
+    for (size_t pixel = 0; pixel < pixelCount; pixel++)
+    {
+        mBuffer[pixel * 3] = pixels[pixel].r;
+        mBuffer[pixel * 3 + 1] = pixels[pixel].g;
+        mBuffer[pixel * 3 + 2] = pixels[pixel].b;
+    }
+
+    if (std::fwrite(mBuffer.data(), 1, mBuffer.size(), mFile) != mBuffer.size())
+    {
+        outError = "Cannot write " + mTemporaryPath;
+        Discard();
+        return false;
+    }
+    mTileOffsets.push_back(mOffset);
+    mOffset += mBuffer.size();
+    return true;
+}
+
+// The tile arrays, then the one directory, then its offset into the header
+bool TiledImageWriter::Close(std::string& outError)
+{
+    if (mFile == nullptr || mTileOffsets.size() != GetTotalTileCount())
+    {
+        outError = "Image is missing tiles";
+        Discard();
+        return false;
+    }
+
+    size_t offsetSize = mIsBigTiff ? 8 : 4;
+    uint64_t tileBytes = uint64_t(mTileSize) * mTileSize * SamplesPerPixel;
+    size_t tileCount = mTileOffsets.size();
+
+    mBuffer.clear();
+    uint64_t tileOffsetsOffset = mOffset;
+    for (uint64_t tileOffset : mTileOffsets)
+    {
+        Append(mBuffer, tileOffset, offsetSize);
+    }
+    uint64_t tileByteCountsOffset = mOffset + mBuffer.size();
+    for (size_t tile = 0; tile < tileCount; tile++)
+    {
+        Append(mBuffer, tileBytes, offsetSize);
+    }
+    uint64_t bitsPerSampleOffset = mOffset + mBuffer.size();
+    for (uint16_t sample = 0; sample < SamplesPerPixel; sample++)
+    {
+        Append(mBuffer, 8, 2);
+    }
+    if (mBuffer.size() % 2 != 0)
+    {
+        mBuffer.push_back(0);
+    }
+
+    // Values that fit in the entry go in it, left justified
+    uint64_t directoryOffset = mOffset + mBuffer.size();
+    auto entry = [&](uint16_t tag, uint16_t type, uint64_t count, uint64_t value)
+    {
+        Append(mBuffer, tag, 2);
+        Append(mBuffer, type, 2);
+        Append(mBuffer, count, offsetSize);
+        Append(mBuffer, value, offsetSize);
+    };
+    auto array = [&](uint64_t offset, uint64_t firstValue)
+    {
+        return tileCount == 1 ? firstValue : offset;
+    };
+
+    uint16_t offsetType = mIsBigTiff ? Long8 : Long;
+    Append(mBuffer, 11, mIsBigTiff ? 8 : 2);
+    entry(256, Long, 1, mImageSize.x);       // ImageWidth
+    entry(257, Long, 1, mImageSize.y);       // ImageLength
+    entry(258, Short, SamplesPerPixel, mIsBigTiff ? InlineBitsPerSample : bitsPerSampleOffset);
+    entry(259, Short, 1, 1);                 // No compression
+    entry(262, Short, 1, 2);                 // RGB
+    entry(277, Short, 1, SamplesPerPixel);
+    entry(284, Short, 1, 1);                 // Chunky
+    entry(322, Long, 1, mTileSize);          // TileWidth
+    entry(323, Long, 1, mTileSize);          // TileLength
+    entry(324, offsetType, tileCount, array(tileOffsetsOffset, mTileOffsets[0]));
+    entry(325, offsetType, tileCount, array(tileByteCountsOffset, tileBytes));
+    Append(mBuffer, 0, offsetSize);          // No next directory
+
+    std::vector<uint8_t> directoryOffsetBytes;
+    Append(directoryOffsetBytes, directoryOffset, offsetSize);
+
+    bool isWritten = std::fwrite(mBuffer.data(), 1, mBuffer.size(), mFile) == mBuffer.size()
+        && std::fseek(mFile, mIsBigTiff ? 8 : 4, SEEK_SET) == 0
+        && std::fwrite(directoryOffsetBytes.data(), 1, directoryOffsetBytes.size(), mFile) == directoryOffsetBytes.size();
+    isWritten = std::fclose(mFile) == 0 && isWritten;
+    mFile = nullptr;
+
+    std::error_code error;
+    if (isWritten)
+    {
+        std::filesystem::rename(mTemporaryPath, mFilePath, error);
+        isWritten = !error;
+    }
+
+    if (!isWritten)
+    {
+        outError = "Cannot write " + mFilePath;
+        std::filesystem::remove(mTemporaryPath, error);
+    }
+    return isWritten;
+}
+
+void TiledImageWriter::Discard()
+{
+    if (mFile == nullptr)
+    {
+        return;
+    }
+
+    std::fclose(mFile);
+    mFile = nullptr;
+    std::error_code error;
+    std::filesystem::remove(mTemporaryPath, error);
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Streams an image to a tiled TIFF one tile at a time, so memory does not depend on the image size apart
+// from the tile directory, 16 bytes a tile. Tiles are stored uncompressed as 8 bit RGB, an image past
+// 4 GB is written as BigTIFF. Like the board file it goes to a temporary file that replaces filePath on
+// Close.
+class TiledImageWriter
+{
+public:
+    TiledImageWriter() = default;
+    TiledImageWriter(const TiledImageWriter&) = delete;
+    TiledImageWriter& operator=(const TiledImageWriter&) = delete;
+    ~TiledImageWriter();  // Discards an image that was not closed
+
+    // The tile size is a multiple of 16
+    bool Open(const std::string& filePath, sf::Vector2u imageSize, uint32_t tileSize, std::string& outError);
+
+    // The next tile, left to right then top to bottom, tileSize by tileSize pixels row major. Tiles past the
+    // edge of the image are cut off by readers.
+    bool WriteTile(const sf::Color* pixels, std::string& outError);
+
+    // Every tile has to be written
+    bool Close(std::string& outError);
+
+    sf::Vector2u GetTileCount() const { return mTileCount; }
+    size_t GetTotalTileCount() const { return static_cast<size_t>(mTileCount.x) * mTileCount.y; }
+
+private:
+    void Discard();
+
+    std::FILE* mFile{ nullptr };
+    std::string mFilePath;
+    std::string mTemporaryPath;
+    bool mIsBigTiff{ false };
+    sf::Vector2u mImageSize;
+    sf::Vector2u mTileCount;
+    uint32_t mTileSize{ 0 };
+    uint64_t mOffset{ 0 };
+    std::vector<uint64_t> mTileOffsets;
+    std::vector<uint8_t> mBuffer;
+};
\ No newline at end of file
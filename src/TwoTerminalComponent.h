@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Component.h"
+
+// Straight component across three board pins, a terminal either side of a blocking body pin on the anchor pin
+class TwoTerminalComponent : public Component
+{
+public:
+    TwoTerminalComponent() = default;
+    TwoTerminalComponent(ICircuitBoardNavigator* navigator, double value)
+        : Component(navigator, 2)
+    {
+        AddNode();
+        AddNode();
+
+        AddComponentPin(true);   // 0, first terminal
+        AddComponentPin(true);   // 1, second terminal
+        AddComponentPin(false);  // 2, body
+
+        SetValue(value);
+    }
+
+    // The terminals are on one row, the body sticks out above and below it
+    virtual sf::FloatRect GetBounds() const override
+    {
+        sf::FloatRect bounds = Component::GetBounds();
+        float halfBodyHeight = bounds.width / 6.0f;
+        bounds.top -= halfBodyHeight;
+        bounds.height += 2.0f * halfBodyHeight;
+        return bounds;
+    }
+
+    virtual void PlaceAt(Pin& anchorPin) override
+    {
+        // Clamp to circuit board
+        Pin* selectedPin = &anchorPin;
+        if (!GetNeighborCircuitBoardPin(*selectedPin, { -1, 0 }))
+        {
+            selectedPin = GetNeighborCircuitBoardPin(*selectedPin, { 1, 0 });
+        }
+        else if (!GetNeighborCircuitBoardPin(*selectedPin, { 1, 0 }))
+        {
+            selectedPin = GetNeighborCircuitBoardPin(*selectedPin, { -1, 0 });
+        }
+        assert(selectedPin);
+
+        // Associate circuit board pins
+        AssociateComponentWithCircuitBoardPin(0, GetNeighborCircuitBoardPin(*selectedPin, { -1, 0 }));
+        AssociateComponentWithCircuitBoardPin(1, GetNeighborCircuitBoardPin(*selectedPin, { 1, 0 }));
+        AssociateComponentWithCircuitBoardPin(2, selectedPin);
+
+        // Update node positions
+        GetNode(0).SetPosition(GetCircuitBoardPinPosition(0));
+        GetNode(1).SetPosition(GetCircuitBoardPinPosition(1));
+    }
+
+    // Leads run from the terminals to the body, which covers the middle half
+    sf::FloatRect DrawLeads(Canvas& canvas) const
+    {
+        const sf::Vector2f& position1 = GetNode(0).GetPosition();
+        const sf::Vector2f& position2 = GetNode(1).GetPosition();
+        sf::Vector2f quarter = (position2 - position1) / 4.0f;
+        float bodyHeight = (position2.x - position1.x) / 3.0f;
+
+        sf::Vertex lines[] = {
+            { position1, mColor },
+            { position1 + quarter, mColor },
+            { position2 - quarter, mColor },
+            { position2, mColor }
+        };
+        canvas.DrawLines(lines, 4);
+
+        return sf::FloatRect({ position1.x + quarter.x, position1.y - bodyHeight / 2.0f }, { 2.0f * quarter.x, bodyHeight });
+    }
+};
\ No newline at end of file
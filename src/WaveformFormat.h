@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// On-disk waveform file layout. Samples of every channel are taken at a fixed interval. A header is
+// followed by blocks appended as the run goes, and a directory of the blocks plus a footer once the file
+// is closed. All values are little endian.
+//
+// Every channel keeps a min/max pyramid next to its samples. Level 0 holds the samples, an entry of level
+// n >= 1 holds the minimum and maximum of PyramidFactor^n consecutive samples, so a time span can be drawn
+// from the level whose entries are about a pixel wide.
+
+struct WaveformFileHeader
+{
+    static constexpr uint32_t Magic = 0x46575343;  // "CSWF"
+    static constexpr uint32_t CurrentVersion = 2;
+
+    uint32_t mMagic;
+    uint32_t mVersion;
+    uint32_t mChannelCount;
+    uint32_t mChunkEntries;   // Entries per block, the last blocks of a file may hold fewer
+    uint32_t mPyramidFactor;
+    uint32_t mLevelCount;
+    double mSampleInterval;   // Seconds
+    double mStartTime;        // Seconds, of the first sample. Since version 2, a run resumed from a checkpoint starts late.
+
+    // Version 1 headers end before mStartTime
+    static constexpr size_t GetSize(uint32_t version) { return version >= 2 ? sizeof(WaveformFileHeader) : 32; }
+};
+
+// Followed by mByteSize bytes of payload. Level 0 payload is one value stream of the samples, higher levels
+// have the stream of the minimums followed by the stream of the maximums. A value stream stores every
+// float as the LEB128 varint of its bits xor the bits of the previous value, starting from zero, which
+// slowly changing signals shrink to a byte or two.
+struct WaveformBlockHeader
+{
+    static constexpr uint32_t Magic = 0x4B4C4257;  // "WBLK"
+
+    uint32_t mMagic;
+    uint32_t mChannel;
+    uint32_t mLevel;
+    uint32_t mEntryCount;
+    uint64_t mFirstEntry;  // Index of the first entry within its level
+    uint64_t mByteSize;
+};
+
+struct WaveformDirectoryEntry
+{
+    uint32_t mChannel;
+    uint32_t mLevel;
+    uint32_t mEntryCount;
+    uint32_t mReserved;
+    uint64_t mFirstEntry;
+    uint64_t mOffset;  // Of the payload, from the start of the file
+    uint64_t mByteSize;
+};
+
+// Last bytes of a closed file. A file without one was not closed, its blocks are found by walking them.
+struct WaveformFileFooter
+{
+    static constexpr uint32_t Magic = 0x52465743;  // "CWFR"
+
+    uint64_t mDirectoryOffset;
+    uint64_t mBlockCount;
+    uint64_t mSampleCount;
+    uint32_t mMagic;
+    uint32_t mReserved;
+};
+
+static_assert(sizeof(WaveformFileHeader) == 40);
+static_assert(sizeof(WaveformBlockHeader) == 32);
+static_assert(sizeof(WaveformDirectoryEntry) == 40);
+static_assert(sizeof(WaveformFileFooter) == 32);
\ No newline at end of file
@@ -0,0 +1,525 @@
+#include "WaveformStore.h"
+#include "BoardFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    constexpr std::chrono::milliseconds WakeInterval(10);
+
+    void EncodeValues(const std::vector<float>& values, std::vector<uint8_t>& outBytes)
+    {
+        uint32_t previousBits = 0;
+        for (float value : values)
+        {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            uint32_t delta = bits ^ previousBits;
+            previousBits = bits;
+
+            do
+            {
+                uint8_t byte = delta & 0x7F;
+                delta >>= 7;
+                outBytes.push_back(delta != 0 ? byte | 0x80 : byte);
+            } while (delta != 0);
+        }
+    }
+
+    bool DecodeValues(const uint8_t*& data, const uint8_t* end, size_t count, std::vector<float>& outValues)
+    {
+        outValues.resize(count);
+        uint32_t previousBits = 0;
+        for (size_t index = 0; index < count; index++)
+        {
+            uint32_t delta = 0;
+            for (uint32_t shift = 0;; shift += 7)
+            {
+                if (data == end || shift > 28)
+                {
+                    return false;
+                }
+                uint8_t byte = *data++;
+                delta |= static_cast<uint32_t>(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0)
+                {
+                    break;
+                }
+            }
+
+            previousBits ^= delta;
+            std::memcpy(&outValues[index], &previousBits, sizeof(previousBits));
+        }
+        return true;
+    }
+
+    template<typename Record>
+    Record ReadRecord(const uint8_t* data)
+    {
+        Record record;
+        std::memcpy(&record, data, sizeof(record));
+        return record;
+    }
+}
+
+WaveformWriter::~WaveformWriter()
+{
+    std::string error;
+    Close(error);
+}
+
+bool WaveformWriter::Open(const std::string& filePath, uint32_t channelCount, double sampleInterval, double startTime, std::string& outError)
+{
+    std::string error;
+    Close(error);
+
+    if (channelCount == 0)
+    {
+        outError = "A waveform file needs at least one channel";
+        return false;
+    }
+
+    std::FILE* file = std::fopen(filePath.c_str(), "wb");
+    if (file == nullptr)
+    {
+        outError = "Cannot create " + filePath;
+        return false;
+    }
+
+    WaveformFileHeader header{};
+    header.mMagic = WaveformFileHeader::Magic;
+    header.mVersion = WaveformFileHeader::CurrentVersion;
+    header.mChannelCount = channelCount;
+    header.mChunkEntries = ChunkEntries;
+    header.mPyramidFactor = PyramidFactor;
+    header.mLevelCount = LevelCount;
+    header.mSampleInterval = sampleInterval;
+    header.mStartTime = startTime;
+    if (std::fwrite(&header, sizeof(header), 1, file) != 1)
+    {
+        std::fclose(file);
+        outError = "Cannot write " + filePath;
+        return false;
+    }
+
+    mFile = file;
+    mChannelCount = channelCount;
+    mSampleCount = 0;
+    mDroppedBlockCount = 0;
+    mIsClosing = false;
+    mLevels.assign(channelCount * LevelCount, Level());
+    for (Level& level : mLevels)
+    {
+        level.mMinimums.reserve(ChunkEntries);
+        level.mMaximums.reserve(ChunkEntries);
+    }
+    for (Slot& slot : mSlots)
+    {
+        slot.mPayload.reserve(MaxPayloadBytes);
+    }
+
+    mHead = 0;
+    mTail = 0;
+    mIsStopping = false;
+    mOffset = sizeof(header);
+    mDirectory.clear();
+    mIsGood = true;
+    mThread = std::thread(&WaveformWriter::Run, this);
+    return true;
+}
+
+void WaveformWriter::Append(const float* samples)
+{
+    for (uint32_t channel = 0; channel < mChannelCount; channel++)
+    {
+        PushEntry(channel, 0, samples[channel], samples[channel]);
+    }
+    mSampleCount++;
+}
+
+bool WaveformWriter::Close(std::string& outError)
+{
+    if (mFile == nullptr)
+    {
+        return true;
+    }
+
+    // Partial buckets become the last entry of the next level, lowest level first so they cascade
+    mIsClosing = true;
+    for (uint32_t channel = 0; channel < mChannelCount; channel++)
+    {
+        for (uint32_t level = 0; level + 1 < LevelCount; level++)
+        {
+            Level& current = GetLevel(channel, level);
+            if (current.mBucketCount > 0)
+            {
+                current.mBucketCount = 0;
+                PushEntry(channel, level + 1, current.mBucketMinimum, current.mBucketMaximum);
+            }
+        }
+
+        for (uint32_t level = 0; level < LevelCount; level++)
+        {
+            if (!GetLevel(channel, level).mMinimums.empty())
+            {
+                WriteBlock(channel, level);
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mIsStopping = true;
+    }
+    mCondition.notify_all();
+    mThread.join();
+
+    WaveformFileFooter footer{};
+    footer.mDirectoryOffset = mOffset;
+    footer.mBlockCount = mDirectory.size();
+    footer.mSampleCount = mSampleCount;
+    footer.mMagic = WaveformFileFooter::Magic;
+
+    bool isWritten = mIsGood
+        && std::fwrite(mDirectory.data(), sizeof(WaveformDirectoryEntry), mDirectory.size(), mFile) == mDirectory.size()
+        && std::fwrite(&footer, sizeof(footer), 1, mFile) == 1;
+    isWritten = std::fclose(mFile) == 0 && isWritten;
+    mFile = nullptr;
+    mLevels.clear();
+    mDirectory.clear();
+
+    if (!isWritten)
+    {
+        outError = "Writing the waveform file failed";
+    }
+    return isWritten;
+}
+
+void WaveformWriter::PushEntry(uint32_t channel, uint32_t level, float minimum, float maximum)
+{
+    Level& current = GetLevel(channel, level);
+    current.mMinimums.push_back(minimum);
+    if (level > 0)
+    {
+        current.mMaximums.push_back(maximum);
+    }
+
+    if (current.mMinimums.size() == ChunkEntries)
+    {
+        WriteBlock(channel, level);
+    }
+
+    if (level + 1 == LevelCount)
+    {
+        return;
+    }
+
+    // Unsolved samples are NaN, a bucket is NaN only when all of its entries are
+    if (current.mBucketCount == 0 || std::isnan(current.mBucketMinimum))
+    {
+        current.mBucketMinimum = minimum;
+        current.mBucketMaximum = maximum;
+    }
+    else
+    {
+        current.mBucketMinimum = std::min(current.mBucketMinimum, minimum);
+        current.mBucketMaximum = std::max(current.mBucketMaximum, maximum);
+    }
+
+    if (++current.mBucketCount == PyramidFactor)
+    {
+        current.mBucketCount = 0;
+        PushEntry(channel, level + 1, current.mBucketMinimum, current.mBucketMaximum);
+    }
+}
+
+void WaveformWriter::WriteBlock(uint32_t channel, uint32_t level)
+{
+    Level& current = GetLevel(channel, level);
+    size_t head = mHead.load(std::memory_order_relaxed);
+    if (mIsClosing)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        while (head - mTail.load(std::memory_order_acquire) == RingSlots)
+        {
+            mCondition.wait_for(lock, WakeInterval);
+        }
+    }
+    else if (head - mTail.load(std::memory_order_acquire) == RingSlots)
+    {
+        mDroppedBlockCount++;
+        current.mFirstEntry += current.mMinimums.size();
+        current.mMinimums.clear();
+        current.mMaximums.clear();
+        return;
+    }
+
+    // The writer thread never touches the slot at the head, its payload was reserved for a full block
+    Slot& slot = mSlots[head % RingSlots];
+    slot.mPayload.clear();
+    EncodeValues(current.mMinimums, slot.mPayload);
+    if (level > 0)
+    {
+        EncodeValues(current.mMaximums, slot.mPayload);
+    }
+
+    slot.mHeader = WaveformBlockHeader{};
+    slot.mHeader.mMagic = WaveformBlockHeader::Magic;
+    slot.mHeader.mChannel = channel;
+    slot.mHeader.mLevel = level;
+    slot.mHeader.mEntryCount = static_cast<uint32_t>(current.mMinimums.size());
+    slot.mHeader.mFirstEntry = current.mFirstEntry;
+    slot.mHeader.mByteSize = slot.mPayload.size();
+
+    current.mFirstEntry += current.mMinimums.size();
+    current.mMinimums.clear();
+    current.mMaximums.clear();
+
+    mHead.store(head + 1, std::memory_order_release);
+    mCondition.notify_one();
+}
+
+void WaveformWriter::Run()
+{
+    while (true)
+    {
+        // A notification sent between the check and the wait is lost, the timeout bounds the delay it causes
+        size_t tail = mTail.load(std::memory_order_relaxed);
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            while (!mIsStopping && tail == mHead.load(std::memory_order_acquire))
+            {
+                mCondition.wait_for(lock, WakeInterval);
+            }
+        }
+        if (tail == mHead.load(std::memory_order_acquire))
+        {
+            return;
+        }
+
+        const Slot& slot = mSlots[tail % RingSlots];
+        if (mIsGood)
+        {
+            mIsGood = std::fwrite(&slot.mHeader, sizeof(slot.mHeader), 1, mFile) == 1
+                && std::fwrite(slot.mPayload.data(), 1, slot.mPayload.size(), mFile) == slot.mPayload.size();
+        }
+
+        const WaveformBlockHeader& header = slot.mHeader;
+        mDirectory.push_back({ header.mChannel, header.mLevel, header.mEntryCount, 0, header.mFirstEntry, mOffset + sizeof(header), header.mByteSize });
+        mOffset += sizeof(header) + header.mByteSize;
+
+        mTail.store(tail + 1, std::memory_order_release);
+        mCondition.notify_all();
+    }
+}
+
+bool WaveformReader::Open(const std::string& filePath, std::string& outError)
+{
+    mBlocks.clear();
+    mFirstBlocks.clear();
+    mSampleCount = 0;
+    if (!mFile.Open(filePath))
+    {
+        outError = "Cannot open " + filePath;
+        return false;
+    }
+
+    mHeader = WaveformFileHeader{};
+    size_t headerSize = WaveformFileHeader::GetSize(1);
+    if (mFile.GetSize() >= headerSize)
+    {
+        std::memcpy(&mHeader, mFile.GetData(), headerSize);
+    }
+
+    if (mHeader.mMagic != WaveformFileHeader::Magic)
+    {
+        outError = "Not a waveform file";
+        return false;
+    }
+
+    if (mHeader.mVersion == 0 || mHeader.mVersion > WaveformFileHeader::CurrentVersion)
+    {
+        outError = "Unsupported waveform file version " + std::to_string(mHeader.mVersion);
+        return false;
+    }
+
+    mHeaderSize = WaveformFileHeader::GetSize(mHeader.mVersion);
+    if (mFile.GetSize() < mHeaderSize)
+    {
+        outError = "Truncated waveform file header";
+        return false;
+    }
+    std::memcpy(&mHeader, mFile.GetData(), mHeaderSize);
+
+    if (mHeader.mChannelCount == 0 || mHeader.mLevelCount == 0 || mHeader.mLevelCount > 16 || mHeader.mPyramidFactor < 2 || mHeader.mChunkEntries == 0)
+    {
+        outError = "Corrupt waveform file header";
+        return false;
+    }
+
+    WaveformFileFooter footer{};
+    if (mFile.GetSize() >= mHeaderSize + sizeof(footer))
+    {
+        footer = ReadRecord<WaveformFileFooter>(mFile.GetData() + mFile.GetSize() - sizeof(footer));
+    }
+
+    if (footer.mMagic == WaveformFileFooter::Magic)
+    {
+        if (!ReadDirectory(footer, outError))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        ScanBlocks();
+    }
+
+    IndexBlocks();
+    return true;
+}
+
+bool WaveformReader::ReadDirectory(const WaveformFileFooter& footer, std::string& outError)
+{
+    uint64_t directoryEnd = mFile.GetSize() - sizeof(footer);
+    bool isCountValid = footer.mBlockCount <= directoryEnd / sizeof(WaveformDirectoryEntry);
+    if (!isCountValid || !BoardFileView::IsRangeWithin(footer.mDirectoryOffset, footer.mBlockCount * sizeof(WaveformDirectoryEntry), directoryEnd))
+    {
+        outError = "Corrupt waveform directory";
+        return false;
+    }
+
+    mBlocks.resize(footer.mBlockCount);
+    std::memcpy(mBlocks.data(), mFile.GetData() + footer.mDirectoryOffset, mBlocks.size() * sizeof(WaveformDirectoryEntry));
+    for (const WaveformDirectoryEntry& entry : mBlocks)
+    {
+        if (!IsBlockValid(entry) || !BoardFileView::IsRangeWithin(entry.mOffset, entry.mByteSize, footer.mDirectoryOffset))
+        {
+            outError = "Corrupt waveform directory";
+            return false;
+        }
+    }
+    mSampleCount = footer.mSampleCount;
+    return true;
+}
+
+// Walks the blocks of a file that was not closed and stops at the first one that is torn
+void WaveformReader::ScanBlocks()
+{
+    uint64_t offset = mHeaderSize;
+    while (mFile.GetSize() - offset >= sizeof(WaveformBlockHeader))
+    {
+        WaveformBlockHeader header = ReadRecord<WaveformBlockHeader>(mFile.GetData() + offset);
+        uint64_t payloadOffset = offset + sizeof(header);
+        WaveformDirectoryEntry entry{ header.mChannel, header.mLevel, header.mEntryCount, 0, header.mFirstEntry, payloadOffset, header.mByteSize };
+        if (header.mMagic != WaveformBlockHeader::Magic || !IsBlockValid(entry) || !BoardFileView::IsRangeWithin(payloadOffset, header.mByteSize, mFile.GetSize()))
+        {
+            break;
+        }
+
+        mBlocks.push_back(entry);
+        if (entry.mLevel == 0)
+        {
+            mSampleCount = std::max(mSampleCount, entry.mFirstEntry + entry.mEntryCount);
+        }
+        offset = payloadOffset + header.mByteSize;
+    }
+}
+
+bool WaveformReader::IsBlockValid(const WaveformDirectoryEntry& entry) const
+{
+    return entry.mChannel < mHeader.mChannelCount && entry.mLevel < mHeader.mLevelCount
+        && entry.mEntryCount > 0 && entry.mEntryCount <= mHeader.mChunkEntries
+        && entry.mFirstEntry <= std::numeric_limits<uint64_t>::max() - entry.mEntryCount;
+}
+
+void WaveformReader::IndexBlocks()
+{
+    std::stable_sort(mBlocks.begin(), mBlocks.end(), [](const WaveformDirectoryEntry& entry, const WaveformDirectoryEntry& other)
+    {
+        if (entry.mChannel != other.mChannel)
+        {
+            return entry.mChannel < other.mChannel;
+        }
+        if (entry.mLevel != other.mLevel)
+        {
+            return entry.mLevel < other.mLevel;
+        }
+        return entry.mFirstEntry < other.mFirstEntry;
+    });
+
+    size_t levelCount = static_cast<size_t>(mHeader.mChannelCount) * mHeader.mLevelCount;
+    mFirstBlocks.assign(levelCount + 1, 0);
+    for (const WaveformDirectoryEntry& entry : mBlocks)
+    {
+        mFirstBlocks[entry.mChannel * mHeader.mLevelCount + entry.mLevel + 1]++;
+    }
+    for (size_t index = 0; index < levelCount; index++)
+    {
+        mFirstBlocks[index + 1] += mFirstBlocks[index];
+    }
+}
+
+bool WaveformReader::ReadMinMax(uint32_t channel, uint64_t firstSample, uint64_t endSample, size_t bucketCount,
+    std::vector<float>& outMinimums, std::vector<float>& outMaximums, std::string& outError) const
+{
+    outMinimums.assign(bucketCount, std::numeric_limits<float>::infinity());
+    outMaximums.assign(bucketCount, -std::numeric_limits<float>::infinity());
+    endSample = std::min(endSample, mSampleCount);
+    if (channel >= mHeader.mChannelCount || firstSample >= endSample || bucketCount == 0)
+    {
+        return true;
+    }
+
+    // Coarsest level whose entries still fit in a bucket
+    uint64_t spanSamples = endSample - firstSample;
+    uint32_t level = 0;
+    uint64_t entrySamples = 1;
+    while (level + 1 < mHeader.mLevelCount && entrySamples * mHeader.mPyramidFactor * bucketCount <= spanSamples)
+    {
+        level++;
+        entrySamples *= mHeader.mPyramidFactor;
+    }
+
+    uint64_t firstEntry = firstSample / entrySamples;
+    uint64_t endEntry = (endSample + entrySamples - 1) / entrySamples;
+
+    size_t levelIndex = channel * mHeader.mLevelCount + level;
+    auto blockBegin = mBlocks.begin() + mFirstBlocks[levelIndex];
+    auto blockEnd = mBlocks.begin() + mFirstBlocks[levelIndex + 1];
+    auto block = std::upper_bound(blockBegin, blockEnd, firstEntry, [](uint64_t entry, const WaveformDirectoryEntry& block)
+    {
+        return entry < block.mFirstEntry + block.mEntryCount;
+    });
+
+    for (; block != blockEnd && block->mFirstEntry < endEntry; ++block)
+    {
+        const uint8_t* data = mFile.GetData() + block->mOffset;
+        const uint8_t* dataEnd = data + block->mByteSize;
+        bool isDecoded = DecodeValues(data, dataEnd, block->mEntryCount, mMinimums)
+            && (level == 0 || DecodeValues(data, dataEnd, block->mEntryCount, mMaximums));
+        if (!isDecoded)
+        {
+            outError = "Corrupt waveform block";
+            return false;
+        }
+        const std::vector<float>& maximums = level == 0 ? mMinimums : mMaximums;
+
+        uint64_t entryBegin = std::max(firstEntry, block->mFirstEntry);
+        uint64_t entryEnd = std::min(endEntry, block->mFirstEntry + block->mEntryCount);
+        for (uint64_t entry = entryBegin; entry < entryEnd; entry++)
+        {
+            // Entries straddling a bucket border count toward the bucket of their first sample
+            uint64_t sample = std::max(entry * entrySamples, firstSample);
+            size_t bucket = static_cast<size_t>((sample - firstSample) * bucketCount / spanSamples);
+            size_t index = static_cast<size_t>(entry - block->mFirstEntry);
+            outMinimums[bucket] = std::min(outMinimums[bucket], mMinimums[index]);
+            outMaximums[bucket] = std::max(outMaximums[bucket], maximums[index]);
+        }
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "WaveformFormat.h"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Appends samples to a waveform file (see WaveformFormat.h) during a run. Memory stays bounded whatever
+// the length of the run: every channel holds at most one pending block per pyramid level, and encoded
+// blocks pass through a fixed ring of slots to a writer thread. Append never waits for the writer: when every
+// slot is still being written the block is dropped and counted, and its span stays covered by the coarser
+// levels, which gathered its entries already. Close waits for room. The block directory is the one thing
+// that grows, 40 bytes per block.
+class WaveformWriter
+{
+public:
+    static constexpr uint32_t ChunkEntries = 4096;
+    static constexpr uint32_t PyramidFactor = 16;
+    static constexpr uint32_t LevelCount = 8;
+    static constexpr size_t RingSlots = 8;
+    static constexpr size_t MaxPayloadBytes = 2 * ChunkEntries * 5;  // Minimums and maximums of 5 bytes at most
+
+    WaveformWriter() = default;
+    WaveformWriter(const WaveformWriter&) = delete;
+    WaveformWriter& operator=(const WaveformWriter&) = delete;
+    ~WaveformWriter();
+
+    bool Open(const std::string& filePath, uint32_t channelCount, double sampleInterval, double startTime, std::string& outError);
+
+    // One sample of every channel, a sample interval after the previous ones
+    void Append(const float* samples);
+
+    // Writes the partial blocks and pyramid buckets, then the directory and the footer
+    bool Close(std::string& outError);
+
+    bool IsOpen() const { return mFile != nullptr; }
+    uint32_t GetChannelCount() const { return mChannelCount; }
+    uint64_t GetSampleCount() const { return mSampleCount; }
+    uint64_t GetDroppedBlockCount() const { return mDroppedBlockCount; }
+
+private:
+    struct Level
+    {
+        std::vector<float> mMinimums;  // Entries not written yet, the samples themselves on level 0
+        std::vector<float> mMaximums;
+        uint64_t mFirstEntry{ 0 };
+
+        // Entry of the next level being gathered from the entries of this one
+        float mBucketMinimum{ 0 };
+        float mBucketMaximum{ 0 };
+        uint32_t mBucketCount{ 0 };
+    };
+
+    struct Slot
+    {
+        WaveformBlockHeader mHeader;
+        std::vector<uint8_t> mPayload;
+    };
+
+    Level& GetLevel(uint32_t channel, uint32_t level) { return mLevels[channel * LevelCount + level]; }
+    void PushEntry(uint32_t channel, uint32_t level, float minimum, float maximum);
+    void WriteBlock(uint32_t channel, uint32_t level);
+    void Run();
+
+    std::FILE* mFile{ nullptr };
+    uint32_t mChannelCount{ 0 };
+    uint64_t mSampleCount{ 0 };
+    uint64_t mDroppedBlockCount{ 0 };
+    bool mIsClosing{ false };
+    std::vector<Level> mLevels;  // Per channel and level
+
+    // Slots from mTail up to mHead are queued for the writer thread, the producer fills mHead. Only the
+    // writer thread and closing wait on the condition, appending never takes the mutex.
+    std::array<Slot, RingSlots> mSlots;
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::atomic<size_t> mHead{ 0 };
+    std::atomic<size_t> mTail{ 0 };
+    bool mIsStopping{ false };
+    std::thread mThread;
+
+    // Owned by the writer thread while it runs
+    uint64_t mOffset{ 0 };
+    std::vector<WaveformDirectoryEntry> mDirectory;
+    bool mIsGood{ true };
+};
+
+// Reads a waveform file in place through a memory mapping. Drawing a time span touches only the blocks of
+// the pyramid level whose entries are about a bucket wide, so the data read is proportional to the number
+// of buckets, not to the length of the span.
+class WaveformReader
+{
+public:
+    // Files that were not closed are read up to their last complete block
+    bool Open(const std::string& filePath, std::string& outError);
+
+    uint32_t GetChannelCount() const { return mHeader.mChannelCount; }
+    double GetSampleInterval() const { return mHeader.mSampleInterval; }
+    double GetStartTime() const { return mHeader.mStartTime; }
+    uint64_t GetSampleCount() const { return mSampleCount; }
+
+    // Minimum and maximum of the samples in each of bucketCount equal spans of [firstSample, endSample).
+    // A bucket without samples gets a minimum above its maximum, as does one whose samples are all NaN, the
+    // steps where the probe was not solved.
+    bool ReadMinMax(uint32_t channel, uint64_t firstSample, uint64_t endSample, size_t bucketCount,
+        std::vector<float>& outMinimums, std::vector<float>& outMaximums, std::string& outError) const;
+
+private:
+    bool ReadDirectory(const WaveformFileFooter& footer, std::string& outError);
+    void ScanBlocks();
+    bool IsBlockValid(const WaveformDirectoryEntry& entry) const;
+    void IndexBlocks();
+
+    MappedFile mFile;
+    WaveformFileHeader mHeader{};
+    size_t mHeaderSize{ 0 };  // Depends on the file version
+    uint64_t mSampleCount{ 0 };
+    std::vector<WaveformDirectoryEntry> mBlocks;  // By channel, level and first entry
+    std::vector<size_t> mFirstBlocks;             // Per channel and level, one past the end last
+
+    mutable std::vector<float> mMinimums;  // Decoded block
+    mutable std::vector<float> mMaximums;
+};
\ No newline at end of file
@@ -31,7 +31,7 @@ public:
         UpdateComponent(cursor);
     }
 
-    virtual void DrawComponent(sf::RenderTarget& target)
+    virtual void DrawComponent(Canvas& canvas) const override
     {
         sf::Vertex line[] = {
             GetNode(0).GetPosition(),
@@ -41,7 +41,7 @@ public:
         line[0].color = mColor;
         line[1].color = mColor; 
 
-        target.draw(line, 2, sf::PrimitiveType::Lines);
+        canvas.DrawLines(line, 2);
     }
 
     virtual void DrawIcon(sf::RenderTarget& target, const sf::Transform& transform, const sf::FloatRect& localBounds) override
@@ -0,0 +1,121 @@
+#include "Test.h"
+
+#include "Battery.h"
+#include "BoardFile.h"
+#include "BoardGenerator.h"
+#include "BoardLoader.h"
+#include "CircuitBoard.h"
+#include "LightBulb.h"
+#include "Resistor.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    // Components and connections by the board pins they sit on, which do not depend on the order they
+    // were added in. A loaded board adds them tile by tile.
+    struct CanonicalBoard
+    {
+        std::vector<std::tuple<std::string, double, std::vector<uint32_t>>> mComponents;
+        std::vector<std::pair<uint32_t, uint32_t>> mConnections;
+    };
+
+    CanonicalBoard MakeCanonical(const BoardRecords& records)
+    {
+        auto getBoardPinId = [&](uint32_t componentId, uint32_t componentPinId)
+        {
+            return records.mComponentPins[records.mComponents[componentId].mFirstPin + componentPinId].mBoardPinId;
+        };
+
+        CanonicalBoard board;
+        for (uint32_t componentId = 0; componentId < records.mComponents.Size(); componentId++)
+        {
+            const ComponentRecord& component = records.mComponents[componentId];
+            std::vector<uint32_t> boardPinIds;
+            for (uint32_t componentPinId = 0; componentPinId < component.mPinCount; componentPinId++)
+            {
+                boardPinIds.push_back(getBoardPinId(componentId, componentPinId));
+            }
+            board.mComponents.emplace_back(records.mComponentTypes[component.mTypeId].mName, records.mComponentValues[componentId], boardPinIds);
+        }
+
+        for (size_t index = 0; index < records.mConnections.Size(); index++)
+        {
+            const ConnectionRecord& connection = records.mConnections[index];
+            uint32_t sourcePinId = getBoardPinId(connection.mSourceComponent, connection.mSourceComponentPin);
+            uint32_t targetPinId = getBoardPinId(connection.mTargetComponent, connection.mTargetComponentPin);
+            board.mConnections.emplace_back(std::min(sourcePinId, targetPinId), std::max(sourcePinId, targetPinId));
+        }
+
+        std::sort(board.mComponents.begin(), board.mComponents.end());
+        std::sort(board.mConnections.begin(), board.mConnections.end());
+        return board;
+    }
+}
+
+TEST(BoardFileRoundTrip)
+{
+    Battery battery;
+    Resistor resistor;
+    LightBulb lightBulb;
+    std::vector<const Component*> prototypes{ &battery, &resistor, &lightBulb };
+
+    BoardGeneratorSettings settings;
+    settings.mGrid = { 256, 256 };
+    settings.mComponentCount = 800;
+    settings.mSeed = 3;
+    CircuitBoard written(settings.mGrid);
+    BoardGeneratorStats stats = BoardGenerator(settings).Populate(written, prototypes);
+    CHECK(stats.mPlacedComponents > 0 && stats.mConnectedComponents > 0);
+
+    std::string filePath = GetTestFilePath("RoundTrip.csb");
+    CHECK(WriteBoardFile(written.TakeSnapshot(), filePath));
+
+    std::string error;
+    BoardLoader boardLoader;
+    std::unique_ptr<CircuitBoard> read = boardLoader.Open(filePath, prototypes, error);
+    CHECK(read != nullptr);
+    CHECK(boardLoader.Update(sf::FloatRect(), sf::Time::Zero, error));
+    CHECK(!boardLoader.IsLoading());
+
+    BoardRecords writtenRecords = written.TakeSnapshot();
+    BoardRecords readRecords = read->TakeSnapshot();
+    CHECK(readRecords.mGrid == writtenRecords.mGrid);
+    CHECK(readRecords.mGridSpacing == writtenRecords.mGridSpacing);
+    CHECK(readRecords.mFlags == writtenRecords.mFlags);
+    CHECK(read->GetComponentCount() == written.GetComponentCount());
+    CHECK(read->GetConnectionCount() == written.GetConnectionCount());
+    CHECK(read->GetNetwork().GetSlotCount() == written.GetNetwork().GetSlotCount());
+
+    CanonicalBoard writtenBoard = MakeCanonical(writtenRecords);
+    CanonicalBoard readBoard = MakeCanonical(readRecords);
+    CHECK(readBoard.mComponents == writtenBoard.mComponents);
+    CHECK(readBoard.mConnections == writtenBoard.mConnections);
+}
+
+TEST(BoardFileRejectsTruncated)
+{
+    Resistor resistor;
+    std::vector<const Component*> prototypes{ &resistor };
+
+    BoardGeneratorSettings settings;
+    settings.mGrid = { 64, 64 };
+    settings.mComponentCount = 50;
+    CircuitBoard written(settings.mGrid);
+    BoardGenerator(settings).Populate(written, prototypes);
+
+    std::string filePath = GetTestFilePath("Truncated.csb");
+    CHECK(WriteBoardFile(written.TakeSnapshot(), filePath));
+    std::filesystem::resize_file(filePath, std::filesystem::file_size(filePath) / 2);
+
+    std::string error;
+    BoardLoader boardLoader;
+    CHECK(boardLoader.Open(filePath, prototypes, error) == nullptr);
+    CHECK(!error.empty());
+}
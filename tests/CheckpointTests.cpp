@@ -0,0 +1,130 @@
+#include "Test.h"
+
+#include "Battery.h"
+#include "BoardBuilder.h"
+#include "CircuitBoard.h"
+#include "JobSystem.h"
+#include "LightBulb.h"
+#include "Resistor.h"
+#include "Simulation.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    template<typename Values>
+    bool AreBitwiseEqual(const Values& first, const Values& second)
+    {
+        return first.size() == second.size() && (first.empty() || std::memcmp(first.data(), second.data(), first.size() * sizeof(first[0])) == 0);
+    }
+
+    // A battery lighting a lamp through a resistor, the lamp heats up over the first steps
+    void BuildLampCircuit(CircuitBoard& circuitBoard, uint32_t& outResistorId)
+    {
+        Battery battery;
+        LightBulb lightBulb;
+        Resistor resistor;
+        BoardBuilder boardBuilder(circuitBoard);
+        Component* source = boardBuilder.Place(battery, sf::Vector2u(10, 10), 9.0);
+        Component* lamp = boardBuilder.Place(lightBulb, sf::Vector2u(30, 30));
+        Component* load = boardBuilder.Place(resistor, sf::Vector2u(50, 50), 2.0);
+        auto [sourcePlus, sourceMinus] = source->GetTerminalPinIds();
+        auto [lampFirst, lampSecond] = lamp->GetTerminalPinIds();
+        auto [loadFirst, loadSecond] = load->GetTerminalPinIds();
+        boardBuilder.Connect(*source, sourcePlus, *lamp, lampFirst);
+        boardBuilder.Connect(*lamp, lampSecond, *load, loadFirst);
+        boardBuilder.Connect(*load, loadSecond, *source, sourceMinus);
+        outResistorId = load->GetId();
+    }
+}
+
+TEST(CheckpointRoundTrip)
+{
+    CircuitBoard circuitBoard({ 64, 64 });
+    uint32_t resistorId = 0;
+    BuildLampCircuit(circuitBoard, resistorId);
+
+    std::string error;
+    JobSystem jobSystem(2);
+    std::vector<std::shared_ptr<const SimulationCheckpoint>> checkpoints;
+    {
+        Simulation simulation(jobSystem);
+        CHECK(simulation.Start(circuitBoard, { { resistorId, 0 } }, "", error));
+        simulation.PostCommand(SimulationCommand::Checkpoint(0.05));
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (checkpoints.empty() && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            simulation.TakeCheckpoints(checkpoints);
+        }
+    }
+    CHECK(checkpoints.size() == 1);
+
+    const SimulationCheckpoint& written = *checkpoints[0];
+    std::string filePath = GetTestFilePath("RoundTrip.csck");
+    CHECK(WriteCheckpointFile(written, filePath, error));
+    std::shared_ptr<const SimulationCheckpoint> read = ReadCheckpointFile(filePath, error);
+    CHECK(read != nullptr);
+
+    const SimulationState& writtenState = written.mState;
+    const SimulationState& readState = read->mState;
+    CHECK(readState.mStepCount == writtenState.mStepCount && readState.mStepCount >= 50);
+    CHECK(readState.mFingerprint == writtenState.mFingerprint);
+    CHECK(readState.mFingerprint == BoardFingerprint::Of(circuitBoard, circuitBoard.GetComponentCount(), circuitBoard.GetConnectionCount()));
+    CHECK(readState.mNetwork.GetComponentCount() == writtenState.mNetwork.GetComponentCount());
+    CHECK(readState.mNetwork.GetConnectionCount() == writtenState.mNetwork.GetConnectionCount());
+    CHECK(AreBitwiseEqual(readState.mNetwork.GetFirstSlots(), writtenState.mNetwork.GetFirstSlots()));
+    CHECK(readState.mElements.size() == writtenState.mElements.size());
+    for (size_t index = 0; index < readState.mElements.size(); index++)
+    {
+        CHECK(readState.mElements[index].mKind == writtenState.mElements[index].mKind);
+        CHECK(readState.mElements[index].mValue == writtenState.mElements[index].mValue);
+    }
+    CHECK(AreBitwiseEqual(readState.mElementSlots, writtenState.mElementSlots));
+    CHECK(AreBitwiseEqual(readState.mComponentElements, writtenState.mComponentElements));
+    CHECK(AreBitwiseEqual(readState.mLamps, writtenState.mLamps));
+    CHECK(AreBitwiseEqual(readState.mColdResistances, writtenState.mColdResistances));
+    CHECK(AreBitwiseEqual(readState.mTemperatures, writtenState.mTemperatures));
+    CHECK(!readState.mTemperatures.empty() && readState.mTemperatures[0] > 0.0);
+    CHECK(readState.mProbes.size() == 1 && readState.mProbes[0].mComponentId == resistorId);
+    CHECK(AreBitwiseEqual(readState.mProbeMinimums, writtenState.mProbeMinimums));
+    CHECK(AreBitwiseEqual(readState.mProbeMaximums, writtenState.mProbeMaximums));
+    CHECK(readState.mDecimationCount == writtenState.mDecimationCount);
+    CHECK(AreBitwiseEqual(read->mNetVoltages, written.mNetVoltages));
+    CHECK(read->mWaveformSampleCount == written.mWaveformSampleCount);
+}
+
+TEST(CheckpointRejectsCorrupt)
+{
+    CircuitBoard circuitBoard({ 64, 64 });
+    uint32_t resistorId = 0;
+    BuildLampCircuit(circuitBoard, resistorId);
+
+    std::string error;
+    JobSystem jobSystem(1);
+    Simulation simulation(jobSystem);
+    CHECK(simulation.Start(circuitBoard, {}, "", error));
+    simulation.PostCommand(SimulationCommand::Checkpoint(0.0));
+    std::vector<std::shared_ptr<const SimulationCheckpoint>> checkpoints;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (checkpoints.empty() && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        simulation.TakeCheckpoints(checkpoints);
+    }
+    simulation.Stop();
+    CHECK(!checkpoints.empty());
+
+    std::string filePath = GetTestFilePath("Corrupt.csck");
+    CHECK(WriteCheckpointFile(*checkpoints[0], filePath, error));
+    std::filesystem::resize_file(filePath, std::filesystem::file_size(filePath) - 3);
+    CHECK(ReadCheckpointFile(filePath, error) == nullptr);
+}
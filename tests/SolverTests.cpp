@@ -0,0 +1,125 @@
+#include "Test.h"
+
+#include "Battery.h"
+#include "BoardGenerator.h"
+#include "CircuitBoard.h"
+#include "CircuitSolver.h"
+#include "JobSystem.h"
+#include "LightBulb.h"
+#include "Resistor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <optional>
+#include <vector>
+
+namespace
+{
+    // Partitions of this many nets or fewer are factored, the larger ones go to the iterative solver
+    constexpr size_t TestDenseNetLimit = 8;
+
+    // Conjugate gradients stop at a relative residual of IterativeTolerance, the stiff voltage sources make
+    // the voltages themselves a few orders of magnitude less exact
+    constexpr double VoltageTolerance = 1e-4;
+
+    void GenerateBoard(CircuitBoard& circuitBoard, CircuitElements& outElements)
+    {
+        Battery battery;
+        Resistor resistor;
+        LightBulb lightBulb;
+        BoardGeneratorSettings settings;
+        settings.mGrid = { 192, 192 };
+        settings.mComponentCount = 1500;
+        settings.mConnectivity = 0.9f;
+        settings.mSeed = 11;
+        BoardGenerator(settings).Populate(circuitBoard, { &battery, &resistor, &resistor, &lightBulb });
+        CircuitSolver::CollectElements(circuitBoard, outElements);
+    }
+
+    std::vector<std::optional<double>> GetElementVoltages(const CircuitSolver& solver, const CircuitElements& elements)
+    {
+        std::vector<std::optional<double>> voltages;
+        for (const CircuitElement& element : elements)
+        {
+            voltages.push_back(solver.GetElementVoltage(element));
+        }
+        return voltages;
+    }
+
+    bool AreBitwiseEqual(const std::vector<std::optional<double>>& first, const std::vector<std::optional<double>>& second)
+    {
+        for (size_t index = 0; index < first.size(); index++)
+        {
+            if (first[index].has_value() != second[index].has_value()
+                || (first[index].has_value() && std::memcmp(&first[index].value(), &second[index].value(), sizeof(double)) != 0))
+            {
+                return false;
+            }
+        }
+        return first.size() == second.size();
+    }
+}
+
+TEST(DenseMatchesIterative)
+{
+    CircuitBoard circuitBoard({ 192, 192 });
+    CircuitElements elements;
+    GenerateBoard(circuitBoard, elements);
+    size_t slotCount = circuitBoard.GetNetwork().GetSlotCount();
+    CHECK(!elements.empty());
+
+    JobSystem jobSystem(2);
+    CircuitSolver denseSolver(jobSystem);
+    denseSolver.SetMode(SolverMode::Dense);
+    denseSolver.Solve(elements, slotCount, true);
+    CHECK(denseSolver.GetStats().mIterativeCount == 0);
+
+    CircuitSolver iterativeSolver(jobSystem);
+    iterativeSolver.SetMode(SolverMode::Iterative);
+    iterativeSolver.SetDenseNetLimit(TestDenseNetLimit);
+    iterativeSolver.Solve(elements, slotCount, true);
+    CHECK(iterativeSolver.GetStats().mIterativeCount > 0);
+
+    std::vector<std::optional<double>> denseVoltages = GetElementVoltages(denseSolver, elements);
+    std::vector<std::optional<double>> iterativeVoltages = GetElementVoltages(iterativeSolver, elements);
+    size_t comparedCount = 0;
+    for (size_t index = 0; index < elements.size(); index++)
+    {
+        if (!denseVoltages[index].has_value() || !iterativeVoltages[index].has_value())
+        {
+            continue;
+        }
+
+        double denseVoltage = denseVoltages[index].value();
+        double iterativeVoltage = iterativeVoltages[index].value();
+        CHECK(std::abs(denseVoltage - iterativeVoltage) <= VoltageTolerance * std::max(1.0, std::abs(denseVoltage)));
+        comparedCount++;
+    }
+    CHECK(comparedCount > elements.size() / 2);
+}
+
+TEST(DeterministicAcrossThreadCounts)
+{
+    CircuitBoard circuitBoard({ 192, 192 });
+    CircuitElements elements;
+    GenerateBoard(circuitBoard, elements);
+    size_t slotCount = circuitBoard.GetNetwork().GetSlotCount();
+
+    for (SolverMode mode : { SolverMode::Dense, SolverMode::Iterative })
+    {
+        std::vector<std::optional<double>> voltages[2];
+        size_t threadCounts[2] = { 1, 4 };
+        for (size_t run = 0; run < 2; run++)
+        {
+            JobSystem jobSystem(threadCounts[run]);
+            CircuitSolver solver(jobSystem);
+            solver.SetMode(mode);
+            solver.SetDeterministic(true);
+            solver.SetDenseNetLimit(TestDenseNetLimit);
+            solver.Solve(elements, slotCount, true);
+            voltages[run] = GetElementVoltages(solver, elements);
+        }
+        CHECK(AreBitwiseEqual(voltages[0], voltages[1]));
+    }
+}
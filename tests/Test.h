@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// A test is a function registered under its name. A failed CHECK reports itself and returns from the test,
+// so checks belong in the test function itself rather than in helpers.
+struct TestCase
+{
+    const char* mName;
+    void (*mFunction)();
+};
+
+std::vector<TestCase>& GetTestCases();
+void ReportFailure(const char* file, int line, const char* condition);
+
+// In the temporary directory, named after the file so tests do not share files
+std::string GetTestFilePath(const std::string& fileName);
+
+struct TestRegistration
+{
+    TestRegistration(const char* name, void (*function)())
+    {
+        GetTestCases().push_back({ name, function });
+    }
+};
+
+#define TEST(name) \
+    static void name(); \
+    static TestRegistration name##Registration(#name, name); \
+    static void name()
+
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            ReportFailure(__FILE__, __LINE__, #condition); \
+            return; \
+        } \
+    } while (false)
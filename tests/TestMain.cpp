@@ -0,0 +1,53 @@
+#include "Test.h"
+
+#include <cstring>
+#include <filesystem>
+
+namespace
+{
+    bool sIsFailed = false;
+}
+
+std::vector<TestCase>& GetTestCases()
+{
+    static std::vector<TestCase> testCases;
+    return testCases;
+}
+
+void ReportFailure(const char* file, int line, const char* condition)
+{
+    std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", file, line, condition);
+    sIsFailed = true;
+}
+
+std::string GetTestFilePath(const std::string& fileName)
+{
+    return (std::filesystem::temp_directory_path() / ("CircuitSimulatorTests_" + fileName)).string();
+}
+
+// Runs the test named on the command line, or every test without one
+int main(int argc, char** argv)
+{
+    size_t runCount = 0;
+    size_t failedCount = 0;
+    for (const TestCase& testCase : GetTestCases())
+    {
+        if (argc > 1 && std::strcmp(argv[1], testCase.mName) != 0)
+        {
+            continue;
+        }
+
+        sIsFailed = false;
+        testCase.mFunction();
+        std::printf("%s %s\n", sIsFailed ? "FAILED" : "passed", testCase.mName);
+        runCount++;
+        failedCount += sIsFailed ? 1 : 0;
+    }
+
+    if (runCount == 0)
+    {
+        std::fprintf(stderr, "No test named %s\n", argc > 1 ? argv[1] : "");
+        return 1;
+    }
+    return failedCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,78 @@
+#include "Test.h"
+
+#include "WaveformStore.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Fewer full blocks than ring slots, so none are dropped however slow the writer thread starts
+    constexpr uint64_t SampleCount = 2 * WaveformWriter::ChunkEntries + 500;
+
+    float GetSample(uint32_t channel, uint64_t index)
+    {
+        if (channel == 1 && index % 97 == 0)
+        {
+            return std::numeric_limits<float>::quiet_NaN();  // Not solved in that step
+        }
+        return channel == 0 ? std::sin(index * 1e-3f) * 5.0f : static_cast<float>((index * 2654435761u) % 1000) / 1000.0f;
+    }
+
+    // A NaN sample reads as an empty bucket, with its minimum above its maximum
+    bool IsSampleRead(float minimum, float maximum, float sample)
+    {
+        return std::isnan(sample) ? minimum > maximum : minimum == sample && maximum == sample;
+    }
+}
+
+TEST(WaveformEncodeDecode)
+{
+    std::string filePath = GetTestFilePath("EncodeDecode.cswf");
+    std::string error;
+    WaveformWriter writer;
+    CHECK(writer.Open(filePath, 2, 1e-3, 0.5, error));
+    for (uint64_t index = 0; index < SampleCount; index++)
+    {
+        float samples[2] = { GetSample(0, index), GetSample(1, index) };
+        writer.Append(samples);
+    }
+    CHECK(writer.GetDroppedBlockCount() == 0);
+    CHECK(writer.Close(error));
+
+    WaveformReader reader;
+    CHECK(reader.Open(filePath, error));
+    CHECK(reader.GetSampleCount() == SampleCount);
+    CHECK(reader.GetStartTime() == 0.5);
+
+    // A bucket per sample reads the samples themselves
+    for (uint32_t channel = 0; channel < 2; channel++)
+    {
+        std::vector<float> minimums;
+        std::vector<float> maximums;
+        CHECK(reader.ReadMinMax(channel, 0, SampleCount, SampleCount, minimums, maximums, error));
+        CHECK(minimums.size() == SampleCount && maximums.size() == SampleCount);
+        for (uint64_t index = 0; index < SampleCount; index++)
+        {
+            CHECK(IsSampleRead(minimums[index], maximums[index], GetSample(channel, index)));
+        }
+    }
+
+    // Coarse buckets come from the pyramid levels and keep the extremes of the samples
+    float minimum = GetSample(0, 0);
+    float maximum = GetSample(0, 0);
+    for (uint64_t index = 1; index < SampleCount; index++)
+    {
+        minimum = std::min(minimum, GetSample(0, index));
+        maximum = std::max(maximum, GetSample(0, index));
+    }
+
+    std::vector<float> minimums;
+    std::vector<float> maximums;
+    CHECK(reader.ReadMinMax(0, 0, SampleCount, 8, minimums, maximums, error));
+    CHECK(*std::min_element(minimums.begin(), minimums.end()) == minimum);
+    CHECK(*std::max_element(maximums.begin(), maximums.end()) == maximum);
+}